@@ -0,0 +1,1029 @@
+/*
+ * dabench.c - Disassembler benchmarks
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef HAVE_LINUX_PERF_EVENT_H
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+#endif
+
+#include <libdisarm/disarm.h>
+
+
+#define USAGE \
+	"Usage: %s [-h] [-b FILE] [-c FILE] [-C ENTRIES] [-d DACLI]" \
+	" [-i ITERATIONS] [-M MIX] [-n WORDS] [-o FILE] [-S SEED]" \
+	" [-t PERCENT]\n"
+#define HELP \
+	USAGE \
+	" Benchmark libdisarm on a synthetic firmware image.\n" \
+	"  -b FILE\tSave results as baseline to FILE\n" \
+	"  -c FILE\tCompare results with baseline in FILE\n" \
+	"  -C ENTRIES\tSize of the text and decode caches (default 4096)\n" \
+	"  -d DACLI\tRun the pipeline benchmark with DACLI (default ./dacli)\n" \
+	"  -h\t\tDisplay this help message\n" \
+	"  -i ITERATIONS\tRun each benchmark ITERATIONS times and keep the\n" \
+	"\t\tfastest run (default 5)\n" \
+	"  -M MIX\tInstruction mix as comma separated CLASS=WEIGHT, where\n" \
+	"\t\tCLASS is one of data, ls, branch, mul, cp, misc and random\n" \
+	"  -n WORDS\tSize of firmware image in words (default 262144)\n" \
+	"  -o FILE\tWrite firmware image to FILE and exit\n" \
+	"  -S SEED\tSeed of the image generator (default 1)\n" \
+	"  -t PERCENT\tSlowdown against baseline reported as regression\n" \
+	"\t\t(default 10)\n" \
+	"Report bugs to <" PACKAGE_BUGREPORT ">.\n"
+
+/* Maximum number of results in a baseline file */
+#define MAX_RESULTS  32
+
+/* Words handled by one call of the block functions */
+#define CHUNK_SIZE  4096
+
+
+/* Instruction classes of the generator */
+typedef enum {
+	CLASS_DATA = 0,
+	CLASS_LS,
+	CLASS_BRANCH,
+	CLASS_MUL,
+	CLASS_CP,
+	CLASS_MISC,
+	CLASS_RANDOM,
+	CLASS_MAX
+} class_t;
+
+static const char *class_names[CLASS_MAX] = {
+	"data", "ls", "branch", "mul", "cp", "misc", "random"
+};
+
+/* Default mix, roughly that of compiled ARM firmware with literal pools */
+static unsigned int class_weights[CLASS_MAX] = {
+	45, 30, 12, 3, 2, 3, 5
+};
+
+
+/* Benchmark result */
+typedef struct {
+	char name[32];
+	double ns;	/* Per word */
+	double cycles;	/* Per word, negative if not counted */
+} result_t;
+
+static result_t results[MAX_RESULTS];
+static int nresults = 0;
+
+
+/* xorshift64 generator, so images are equal on every host */
+static unsigned long long rand_state;
+
+static da_word_t
+rand_word(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (da_word_t)(rand_state >> 16);
+}
+
+/* Return random number below n. */
+static da_uint_t
+rand_below(da_uint_t n)
+{
+	return rand_word() % n;
+}
+
+/* Condition field: mostly always, sometimes one of the others. */
+static da_word_t
+gen_cond(void)
+{
+	if (rand_below(10) != 0) return (da_word_t)DA_COND_AL << 28;
+	return (da_word_t)rand_below(DA_COND_AL) << 28;
+}
+
+/* Register, biased towards the low registers */
+static da_word_t
+gen_reg(void)
+{
+	return rand_below(4) != 0 ? rand_below(8) : rand_below(16);
+}
+
+static da_word_t
+gen_data(void)
+{
+	static const da_data_op_t ops[] = {
+		DA_DATA_OP_MOV, DA_DATA_OP_MOV, DA_DATA_OP_MOV,
+		DA_DATA_OP_ADD, DA_DATA_OP_ADD, DA_DATA_OP_SUB,
+		DA_DATA_OP_CMP, DA_DATA_OP_CMP, DA_DATA_OP_AND,
+		DA_DATA_OP_ORR, DA_DATA_OP_BIC, DA_DATA_OP_EOR,
+		DA_DATA_OP_RSB, DA_DATA_OP_TST, DA_DATA_OP_MVN,
+		DA_DATA_OP_ADC
+	};
+	da_word_t op = ops[rand_below(sizeof(ops) / sizeof(ops[0]))];
+	da_word_t w = gen_cond() | (op << 21) | (gen_reg() << 12);
+
+	/* Compares always set flags, moves have no Rn */
+	if (op >= DA_DATA_OP_TST && op <= DA_DATA_OP_CMN) {
+		w |= 1 << 20;
+	} else if (rand_below(5) == 0) w |= 1 << 20;
+	if (op != DA_DATA_OP_MOV && op != DA_DATA_OP_MVN) {
+		w |= gen_reg() << 16;
+	}
+
+	switch (rand_below(8)) {
+	case 0:
+		/* Register shift */
+		return w | (gen_reg() << 8) | (rand_below(4) << 5) |
+			(1 << 4) | gen_reg();
+	case 1:
+	case 2:
+	case 3:
+		/* Immediate shift, usually none */
+		if (rand_below(3) == 0) {
+			w |= (rand_below(32) << 7) | (rand_below(4) << 5);
+		}
+		return w | gen_reg();
+	default:
+		/* Immediate, usually unrotated */
+		if (rand_below(4) == 0) w |= rand_below(16) << 8;
+		return w | (1 << 25) | rand_below(256);
+	}
+}
+
+static da_word_t
+gen_ls(void)
+{
+	da_word_t w = gen_cond();
+	da_uint_t regs;
+
+	switch (rand_below(10)) {
+	case 0:
+		/* push {..., lr} or pop {..., pc} */
+		regs = rand_below(256) & ~1;
+		if (rand_below(2)) return w | 0x092d4000 | regs;
+		return w | 0x08bd8000 | regs;
+	case 1:
+		/* ldrh/strh Rd, [Rn, #imm] */
+		regs = rand_below(32) << 1;
+		return w | 0x01c000b0 | (rand_below(2) << 20) |
+			(gen_reg() << 16) | (gen_reg() << 12) |
+			((regs >> 4) << 8) | (regs & 0xf);
+	case 2:
+	case 3:
+		/* ldr Rd, [pc, #imm] from a literal pool */
+		return w | 0x05900000 | (rand_below(2) << 23) |
+			(DA_REG_R15 << 16) | (gen_reg() << 12) |
+			(rand_below(256) << 2);
+	case 4:
+		/* ldr/str Rd, [Rn, Rm] */
+		return w | 0x07800000 | (rand_below(2) << 20) |
+			(rand_below(2) << 22) | (gen_reg() << 16) |
+			(gen_reg() << 12) | gen_reg();
+	default:
+		/* ldr/str Rd, [Rn, #imm] with sp or a low register */
+		return w | 0x05800000 | (rand_below(2) << 20) |
+			(rand_below(8) == 0 ? (1 << 22) : 0) |
+			((rand_below(3) == 0 ? DA_REG_R13 : gen_reg()) << 16) |
+			(gen_reg() << 12) | (rand_below(64) << 2);
+	}
+}
+
+static da_word_t
+gen_branch(void)
+{
+	da_uint_t off = rand_below(2048);
+	if (rand_below(2)) off = -off;
+
+	switch (rand_below(8)) {
+	case 0:
+		/* bx lr */
+		return gen_cond() | 0x012fff10 | DA_REG_R14;
+	case 1:
+		/* blx Rm */
+		return 0xe12fff30 | gen_reg();
+	case 2:
+	case 3:
+	case 4:
+		/* bl */
+		return 0xeb000000 | (off & 0xffffff);
+	default:
+		/* b, often conditional */
+		return gen_cond() | 0x0a000000 | (off & 0xffffff);
+	}
+}
+
+static da_word_t
+gen_mul(void)
+{
+	da_word_t w = gen_cond() | 0x00000090 | (gen_reg() << 8) | gen_reg();
+	if (rand_below(4) == 0) {
+		/* umull/smull/umlal/smlal */
+		return w | 0x00800000 | (rand_below(4) << 21) |
+			(gen_reg() << 16) | (gen_reg() << 12);
+	}
+	/* mul/mla */
+	if (rand_below(2)) w |= (1 << 21) | (gen_reg() << 12);
+	return w | (gen_reg() << 16);
+}
+
+static da_word_t
+gen_cp(void)
+{
+	if (rand_below(8) == 0) {
+		/* ldc/stc */
+		return gen_cond() | 0x0d800000 | (rand_below(2) << 20) |
+			(gen_reg() << 16) | (rand_below(16) << 12) |
+			(rand_below(16) << 8) | rand_below(256);
+	}
+	/* mcr/mrc p15 */
+	return gen_cond() | 0x0e000f10 | (rand_below(8) << 21) |
+		(rand_below(2) << 20) | (rand_below(16) << 16) |
+		(gen_reg() << 12) | (rand_below(8) << 5) | rand_below(16);
+}
+
+static da_word_t
+gen_misc(void)
+{
+	switch (rand_below(4)) {
+	case 0:
+		/* swi */
+		return gen_cond() | 0x0f000000 | rand_below(256);
+	case 1:
+		/* mrs Rd, cpsr/spsr */
+		return gen_cond() | 0x010f0000 | (rand_below(2) << 22) |
+			(gen_reg() << 12);
+	case 2:
+		/* msr cpsr_c/spsr_c, Rm */
+		return gen_cond() | 0x0121f000 | (rand_below(2) << 22) |
+			gen_reg();
+	default:
+		/* clz */
+		return gen_cond() | 0x016f0f10 | (gen_reg() << 12) | gen_reg();
+	}
+}
+
+/* Fill data with count words of synthetic firmware. */
+static void
+gen_image(da_word_t *data, size_t count, unsigned long long seed)
+{
+	da_uint_t total = 0;
+	size_t i;
+	int c;
+
+	rand_state = seed * 0x9e3779b97f4a7c15ULL + 1;
+	for (c = 0; c < CLASS_MAX; c++) total += class_weights[c];
+
+	for (i = 0; i < count; i++) {
+		da_uint_t pick = rand_below(total);
+		for (c = 0; pick >= class_weights[c]; c++) {
+			pick -= class_weights[c];
+		}
+
+		switch (c) {
+		case CLASS_DATA: data[i] = gen_data(); break;
+		case CLASS_LS: data[i] = gen_ls(); break;
+		case CLASS_BRANCH: data[i] = gen_branch(); break;
+		case CLASS_MUL: data[i] = gen_mul(); break;
+		case CLASS_CP: data[i] = gen_cp(); break;
+		case CLASS_MISC: data[i] = gen_misc(); break;
+		default: data[i] = rand_word(); break;
+		}
+	}
+}
+
+/* Write count words to fd as little endian. Return -1 on error. */
+static int
+write_image(int fd, const da_word_t *data, size_t count)
+{
+	unsigned char buf[4 * CHUNK_SIZE];
+	size_t i = 0;
+
+	while (i < count) {
+		size_t n = 0;
+		for (; i < count && n < sizeof(buf); i++) {
+			buf[n++] = data[i];
+			buf[n++] = data[i] >> 8;
+			buf[n++] = data[i] >> 16;
+			buf[n++] = data[i] >> 24;
+		}
+		if (write(fd, buf, n) != (ssize_t)n) return -1;
+	}
+
+	return 0;
+}
+
+/* Parse comma separated CLASS=WEIGHT list. Return -1 on error. */
+static int
+parse_mix(const char *mix)
+{
+	unsigned int weights[CLASS_MAX] = { 0 };
+	unsigned int total = 0;
+	int c;
+
+	while (*mix != '\0') {
+		size_t len = strcspn(mix, "=");
+		char *end;
+
+		for (c = 0; c < CLASS_MAX; c++) {
+			if (strlen(class_names[c]) == len &&
+			    !strncmp(mix, class_names[c], len)) break;
+		}
+		if (c == CLASS_MAX || mix[len] != '=') return -1;
+
+		errno = 0;
+		unsigned long weight = strtoul(mix + len + 1, &end, 10);
+		if (errno != 0 || end == mix + len + 1 || weight > 1000000 ||
+		    (*end != ',' && *end != '\0')) {
+			return -1;
+		}
+
+		weights[c] = weight;
+		total += weight;
+		mix = (*end == ',') ? end + 1 : end;
+	}
+
+	if (total == 0) return -1;
+	memcpy(class_weights, weights, sizeof(weights));
+	return 0;
+}
+
+
+/* Cycle counter of this process and its children */
+static int cycles_fd = -1;
+
+static void
+cycles_open(void)
+{
+#if defined(HAVE_LINUX_PERF_EVENT_H) && defined(SYS_perf_event_open)
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	cycles_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+static void
+cycles_start(void)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	if (cycles_fd < 0) return;
+	ioctl(cycles_fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(cycles_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+/* Return cycles since cycles_start, or -1 if not counted. */
+static double
+cycles_stop(void)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	unsigned long long count;
+	if (cycles_fd < 0) return -1;
+	ioctl(cycles_fd, PERF_EVENT_IOC_DISABLE, 0);
+	if (read(cycles_fd, &count, sizeof(count)) != sizeof(count)) {
+		return -1;
+	}
+	return count;
+#else
+	return -1;
+#endif
+}
+
+static double
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/* Benchmark state shared by the kernels */
+typedef struct {
+	const da_word_t *data;
+	size_t count;
+	da_instr_t *instrs;
+	da_instr_args_t *args;
+	FILE *null;
+	const char *dacli;
+	const char *image;
+	da_text_cache_t *cache;
+	da_decode_cache_t *direct;
+	da_decode_cache_t *lru2;
+	da_block_t *block;
+	da_symtab_t *symtab;
+} bench_t;
+
+/* Defeats elimination of the benchmarked calls */
+static volatile da_uint_t sink;
+
+static void
+run_parse(const bench_t *b)
+{
+	da_uint_t sum = 0;
+	size_t i;
+	for (i = 0; i < b->count; i++) {
+		da_instr_t instr;
+		da_instr_parse(&instr, b->data[i], 0);
+		sum += instr.group;
+	}
+	sink = sum;
+}
+
+static void
+run_parse_block(const bench_t *b)
+{
+	size_t i;
+	for (i = 0; i < b->count; i += CHUNK_SIZE) {
+		size_t n = b->count - i < CHUNK_SIZE ? b->count - i : CHUNK_SIZE;
+		da_instr_parse_block(&b->instrs[i], &b->data[i], n, 0);
+	}
+	sink = b->instrs[b->count - 1].group;
+}
+
+static void
+run_parse_args(const bench_t *b)
+{
+	da_uint_t sum = 0;
+	size_t i;
+	for (i = 0; i < b->count; i++) {
+		da_instr_args_t args;
+		da_instr_parse_args(&args, &b->instrs[i]);
+		sum += args.bl.cond;
+	}
+	sink = sum;
+}
+
+/* Parse arguments through a decode cache, starting from an empty cache. */
+static void
+run_args_cache(const bench_t *b, da_decode_cache_t *cache)
+{
+	da_uint_t sum = 0;
+	size_t i;
+	da_decode_cache_clear(cache);
+	for (i = 0; i < b->count; i++) {
+		da_instr_args_t args;
+		da_decode_cache_parse_args(cache, &args, &b->instrs[i]);
+		sum += args.bl.cond;
+	}
+	sink = sum;
+}
+
+static void
+run_args_direct(const bench_t *b)
+{
+	run_args_cache(b, b->direct);
+}
+
+static void
+run_args_lru2(const bench_t *b)
+{
+	run_args_cache(b, b->lru2);
+}
+
+static void
+run_snprint(const bench_t *b)
+{
+	char buf[256];
+	da_uint_t sum = 0;
+	size_t i;
+	for (i = 0; i < b->count; i++) {
+		sum += da_instr_snprint(buf, sizeof(buf), &b->instrs[i],
+					&b->args[i], i << 2);
+	}
+	sink = sum;
+}
+
+/* Print through the text cache, starting from an empty cache. */
+static void
+run_snprint_cache(const bench_t *b)
+{
+	char buf[256];
+	da_uint_t sum = 0;
+	size_t i;
+	da_text_cache_clear(b->cache);
+	for (i = 0; i < b->count; i++) {
+		sum += da_text_cache_snprint(b->cache, buf, sizeof(buf),
+					     &b->instrs[i], &b->args[i],
+					     i << 2);
+	}
+	sink = sum;
+}
+
+static void
+run_fprint(const bench_t *b)
+{
+	size_t i;
+	for (i = 0; i < b->count; i++) {
+		da_instr_fprint(b->null, &b->instrs[i], &b->args[i], i << 2);
+		putc('\n', b->null);
+	}
+	fflush(b->null);
+}
+
+/* Build the control flow graph of the decoded image. */
+static void
+run_cfg(const bench_t *b)
+{
+	da_cfg_t cfg;
+	if (da_cfg_build(&cfg, b->block, 0) < 0) {
+		perror("da_cfg_build");
+		exit(EXIT_FAILURE);
+	}
+	sink = cfg.nblocks;
+	da_cfg_free(&cfg);
+}
+
+/* Compute the registers used by the image in chunks. */
+static void
+run_regs(const bench_t *b)
+{
+	da_uint_t read[CHUNK_SIZE], written[CHUNK_SIZE];
+	da_uint_t sum = 0;
+	size_t i;
+	for (i = 0; i < b->count; i += CHUNK_SIZE) {
+		size_t n = b->count - i < CHUNK_SIZE ? b->count - i : CHUNK_SIZE;
+		da_instr_regs_block(read, written, &b->instrs[i], n);
+		sum += read[n - 1] | written[n - 1];
+	}
+	sink = sum;
+}
+
+/* Build the cross reference index of the image on one thread. */
+static void
+run_xref(const bench_t *b)
+{
+	da_xref_t xref;
+	if (da_xref_build(&xref, b->data, b->count, 0, 0, 1) < 0) {
+		perror("da_xref_build");
+		exit(EXIT_FAILURE);
+	}
+	sink = xref.count;
+	da_xref_free(&xref);
+}
+
+/* Find the coprocessor 15 register transfers in the image. */
+static void
+run_query(const bench_t *b)
+{
+	da_query_t query;
+	size_t hits[CHUNK_SIZE];
+	size_t start = 0, total = 0;
+
+	da_query_compile(&query, "cp_reg cp_num=15");
+	for (;;) {
+		size_t n = da_query_find(&query, hits, CHUNK_SIZE,
+					 b->data + start, b->count - start, 0);
+		total += n;
+		if (n < CHUNK_SIZE) break;
+		start += hits[n - 1] + 1;
+	}
+	sink = total;
+}
+
+/* Number of entry points spread over the image for tracing */
+#define TRACE_ENTRIES  64
+
+/* Trace the code of the image on one thread. */
+static void
+run_trace(const bench_t *b)
+{
+	da_addr_t entries[TRACE_ENTRIES];
+	size_t i;
+	for (i = 0; i < TRACE_ENTRIES; i++) {
+		entries[i] = (b->count / TRACE_ENTRIES)*i*sizeof(da_word_t);
+	}
+
+	da_trace_t trace;
+	if (da_trace_run(&trace, b->data, b->count, 0, 0, entries,
+			 TRACE_ENTRIES, 1) < 0) {
+		perror("da_trace_run");
+		exit(EXIT_FAILURE);
+	}
+	sink = trace.reached;
+	da_trace_free(&trace);
+}
+
+/* Number of symbols spread over the image for lookups */
+#define SYMTAB_SYMS  100000
+
+/* Look up the symbol of an address in the image for each word. */
+static void
+run_symtab(const bench_t *b)
+{
+	da_addr_t mask = 1;
+	while (mask < b->count*sizeof(da_word_t)) mask <<= 1;
+	mask -= 1;
+
+	da_uint_t sum = 0;
+	size_t i;
+	for (i = 0; i < b->count; i++) {
+		da_uint_t offset = 0;
+		da_symtab_lookup(b->symtab, b->data[i] & mask, &offset);
+		sum += offset;
+	}
+	sink = sum;
+}
+
+/* Run dacli on the image with output to /dev/null. */
+static void
+run_dacli(const bench_t *b)
+{
+	int status;
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		exit(EXIT_FAILURE);
+	} else if (pid == 0) {
+		dup2(fileno(b->null), STDOUT_FILENO);
+		execl(b->dacli, b->dacli, b->image, (char *)NULL);
+		perror(b->dacli);
+		_exit(127);
+	}
+
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+	    WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "%s failed.\n", b->dacli);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Run kernel iterations times and record the fastest run. */
+static void
+bench(const char *name, void (*kernel)(const bench_t *), const bench_t *b,
+      int iterations)
+{
+	result_t *res = &results[nresults++];
+	double best_ns = -1;
+	double best_cycles = -1;
+	int i;
+
+	for (i = 0; i < iterations; i++) {
+		cycles_start();
+		double start = now_ns();
+		kernel(b);
+		double ns = now_ns() - start;
+		double cycles = cycles_stop();
+
+		if (best_ns < 0 || ns < best_ns) {
+			best_ns = ns;
+			best_cycles = cycles;
+		}
+	}
+
+	strncpy(res->name, name, sizeof(res->name) - 1);
+	res->name[sizeof(res->name) - 1] = '\0';
+	res->ns = best_ns / b->count;
+	res->cycles = best_cycles < 0 ? -1 : best_cycles / b->count;
+}
+
+
+/* Load baseline results from path. Return number of results or -1. */
+static int
+load_baseline(const char *path, result_t *base)
+{
+	char line[128];
+	int n = 0;
+
+	FILE *f = fopen(path, "r");
+	if (f == NULL) return -1;
+
+	while (n < MAX_RESULTS && fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#') continue;
+		if (sscanf(line, "%31s %lf %lf", base[n].name, &base[n].ns,
+			   &base[n].cycles) == 3) {
+			n++;
+		}
+	}
+
+	fclose(f);
+	return n;
+}
+
+static int
+save_baseline(const char *path, size_t count)
+{
+	int i;
+
+	FILE *f = fopen(path, "w");
+	if (f == NULL) return -1;
+
+	fprintf(f, "# dabench baseline, %lu words: name ns/instr cycles/instr\n",
+		(unsigned long)count);
+	for (i = 0; i < nresults; i++) {
+		fprintf(f, "%s %.3f %.3f\n", results[i].name, results[i].ns,
+			results[i].cycles);
+	}
+
+	return fclose(f);
+}
+
+/* Print results, compared with base if nbase > 0. Return number of
+   regressions beyond threshold percent. */
+static int
+report(const result_t *base, int nbase, double threshold)
+{
+	int regressions = 0;
+	int i, j;
+
+	printf("%-14s %10s %10s %12s", "benchmark", "ns/instr", "Mwords/s",
+	       "cycles/instr");
+	if (nbase > 0) printf(" %9s", "baseline");
+	printf("\n");
+
+	for (i = 0; i < nresults; i++) {
+		const result_t *res = &results[i];
+		printf("%-14s %10.2f %10.2f", res->name, res->ns,
+		       1e3 / res->ns);
+		if (res->cycles >= 0) printf(" %12.2f", res->cycles);
+		else printf(" %12s", "-");
+
+		for (j = 0; j < nbase; j++) {
+			if (!strcmp(base[j].name, res->name)) break;
+		}
+		if (j < nbase) {
+			double change = 100 * (res->ns / base[j].ns - 1);
+			printf(" %+8.1f%%", change);
+			if (change > threshold) {
+				printf("  REGRESSION");
+				regressions++;
+			}
+		}
+		printf("\n");
+	}
+
+	return regressions;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	int r;
+
+	const char *baseline_out = NULL;
+	const char *baseline_in = NULL;
+	const char *image_out = NULL;
+	const char *dacli = "./dacli";
+	size_t count = 262144;
+	size_t cache_size = 4096;
+	unsigned long long seed = 1;
+	int iterations = 5;
+	double threshold = 10;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "b:c:C:d:hi:M:n:o:S:t:")) != -1) {
+		switch (opt) {
+		case 'b':
+			baseline_out = optarg;
+			break;
+		case 'c':
+			baseline_in = optarg;
+			break;
+		case 'C':
+			cache_size = strtoul(optarg, NULL, 0);
+			if (cache_size == 0) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'd':
+			dacli = optarg;
+			break;
+		case 'h':
+			printf(HELP, argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			if (iterations < 1) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'M':
+			r = parse_mix(optarg);
+			if (r < 0) {
+				fprintf(stderr, "Invalid instruction mix: %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			if (count == 0) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'o':
+			image_out = optarg;
+			break;
+		case 'S':
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			threshold = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, USAGE, argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	bench_t b;
+	da_word_t *data = malloc(count * sizeof(da_word_t));
+	b.instrs = malloc(count * sizeof(da_instr_t));
+	b.args = malloc(count * sizeof(da_instr_args_t));
+	if (data == NULL || b.instrs == NULL || b.args == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	gen_image(data, count, seed);
+	b.data = data;
+	b.count = count;
+
+	/* Write image for dacli, or to image_out */
+	char image[] = "/tmp/dabench-XXXXXX";
+	int fd = -1;
+	if (image_out != NULL) {
+		fd = open(image_out, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	} else fd = mkstemp(image);
+	if (fd < 0) {
+		perror(image_out != NULL ? image_out : "mkstemp");
+		exit(EXIT_FAILURE);
+	}
+
+	r = write_image(fd, data, count);
+	if (r < 0) {
+		perror("write");
+		exit(EXIT_FAILURE);
+	}
+	close(fd);
+
+	if (image_out != NULL) {
+		free(data);
+		free(b.instrs);
+		free(b.args);
+		return EXIT_SUCCESS;
+	}
+
+	b.image = image;
+	b.dacli = dacli;
+	b.null = fopen("/dev/null", "w");
+	if (b.null == NULL) {
+		perror("/dev/null");
+		exit(EXIT_FAILURE);
+	}
+
+	da_instr_parse_block(b.instrs, b.data, count, 0);
+	da_instr_parse_args_block(b.args, b.instrs, count);
+
+	da_text_cache_t cache;
+	da_decode_cache_t direct, lru2;
+	if (da_text_cache_init(&cache, cache_size) < 0 ||
+	    da_decode_cache_init(&direct, cache_size,
+				 DA_DECODE_CACHE_DIRECT) < 0 ||
+	    da_decode_cache_init(&lru2, cache_size,
+				 DA_DECODE_CACHE_LRU2) < 0) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	b.cache = &cache;
+	b.direct = &direct;
+	b.lru2 = &lru2;
+
+	da_block_t block;
+	if (da_block_init(&block, count) < 0 ||
+	    da_block_add_words(&block, b.data, count, 0) < 0) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	b.block = &block;
+
+	da_symtab_t symtab;
+	da_symtab_init(&symtab);
+	size_t i;
+	for (i = 0; i < SYMTAB_SYMS; i++) {
+		if (da_symtab_add(&symtab, rand_below(count)*sizeof(da_word_t),
+				  0, "sym") < 0) {
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (da_symtab_build(&symtab) < 0) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	b.symtab = &symtab;
+
+	cycles_open();
+	if (cycles_fd < 0) {
+		fprintf(stderr, "Cycle counter not available.\n");
+	}
+
+	printf("%lu words, seed %llu, best of %d\n", (unsigned long)count,
+	       seed, iterations);
+
+	bench("parse", run_parse, &b, iterations);
+	bench("parse_block", run_parse_block, &b, iterations);
+	bench("parse_args", run_parse_args, &b, iterations);
+	bench("args_direct", run_args_direct, &b, iterations);
+	bench("args_lru2", run_args_lru2, &b, iterations);
+	bench("snprint", run_snprint, &b, iterations);
+	bench("snprint_cache", run_snprint_cache, &b, iterations);
+	bench("fprint", run_fprint, &b, iterations);
+	bench("regs", run_regs, &b, iterations);
+	bench("cfg", run_cfg, &b, iterations);
+	bench("xref", run_xref, &b, iterations);
+	bench("trace", run_trace, &b, iterations);
+	bench("query", run_query, &b, iterations);
+	bench("symtab", run_symtab, &b, iterations);
+	if (access(dacli, X_OK) == 0) {
+		bench("dacli", run_dacli, &b, iterations);
+	} else {
+		fprintf(stderr, "%s not found; skipping pipeline.\n", dacli);
+	}
+
+	unlink(image);
+	fclose(b.null);
+
+	printf("%lu cache entries: hits/misses text %lu/%lu, direct %lu/%lu,"
+	       " lru2 %lu/%lu\n", (unsigned long)(cache.mask + 1),
+	       cache.hits, cache.misses, direct.hits, direct.misses,
+	       lru2.hits, lru2.misses);
+	da_text_cache_free(&cache);
+	da_decode_cache_free(&direct);
+	da_decode_cache_free(&lru2);
+	da_block_free(&block);
+	da_symtab_free(&symtab);
+
+	result_t base[MAX_RESULTS];
+	int nbase = 0;
+	if (baseline_in != NULL) {
+		nbase = load_baseline(baseline_in, base);
+		if (nbase < 0) {
+			perror(baseline_in);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	int regressions = report(base, nbase, threshold);
+
+	if (baseline_out != NULL) {
+		r = save_baseline(baseline_out, count);
+		if (r < 0) {
+			perror(baseline_out);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	free(data);
+	free(b.instrs);
+	free(b.args);
+
+	if (regressions > 0) {
+		printf("%d benchmarks slower than baseline by more than"
+		       " %.1f%%.\n", regressions, threshold);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
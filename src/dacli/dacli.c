@@ -22,68 +22,1352 @@
 # include <config.h>
 #endif
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <errno.h>
 #include <unistd.h>
+#ifdef HAVE_GETOPT_H
+# include <getopt.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include <libdisarm/disarm.h>
 
+#include "hexinput.h"
+
 
 #define USAGE \
-	"Usage: %s [-EB|-EL] [-h] [-m OFFSET] [-s SKIP] [FILE]\n"
+	"Usage: %s [-c COUNT] [-C DIR] [-D] [-e ADDR] [-EB|-EL] [-h] [-j JOBS]" \
+	" [-l] [-m OFFSET] [-M MAP] [-p N] [-q QUERY] [-r RANGES] [-s SKIP]" \
+	" [-S] [-t|-T] [-x|-X LAYOUT] [-z SIZE] [FILE]\n"
 #define HELP \
 	USAGE \
-	" Disassemble ARM machine code from FILE or standard input.\n" \
+	" Disassemble ARM or Thumb machine code from FILE or standard input.\n" \
+	"  -c COUNT\tDisassemble at most COUNT bytes\n" \
+	"  -C, --cache=DIR\n" \
+	"\t\tKeep the text of disassembled pages in DIR and reuse it\n" \
+	"\t\tfor pages with the same words, at any address\n" \
+	"  -D\t\tDecode repeated words once with the decode cache\n" \
+	"  -e ADDR\tTrace code from entry point ADDR (implies -t)\n" \
 	"  -EB\t\tRead input as big endian data\n" \
 	"  -EL\t\tRead input as little endian data\n" \
 	"  -h\t\tDisplay this help message\n" \
+	"  -j JOBS\tDisassemble on JOBS threads\n" \
+	"  -l, --elf\tRead FILE as an ELF image and disassemble its\n" \
+	"\t\texecutable sections, skipping data and labelling symbols\n" \
 	"  -m OFFSET\tUse OFFSET as memory address of input\n" \
+	"  -M, --map=MAP\n" \
+	"\t\tRead symbols from MAP, lines of ADDR NAME or the output\n" \
+	"\t\tof nm, and print branch targets as symbol+offset\n" \
+	"  -p, --sample=N\n" \
+	"\t\tWith -S, only count one of every N blocks of 4 KB\n" \
+	"  -q QUERY\tOnly disassemble instructions matching QUERY: a group\n" \
+	"\t\tname or * followed by FIELD=VALUE constraints on the\n" \
+	"\t\targuments, e.g. \"cp_reg cp_num=15 load=0\"\n" \
+	"  -r RANGES\tOnly disassemble the comma separated address ranges\n" \
+	"\t\tSTART-END in RANGES (END is exclusive)\n" \
 	"  -s SKIP\tNumber of bytes to skip before disassembly\n" \
+	"  -S, --stats\tPrint counts of groups, conditions, opcodes and\n" \
+	"\t\tregisters read and written instead of disassembly\n" \
+	"  -t\t\tOnly disassemble code reached from the exception vectors\n" \
+	"\t\tor the entry points by following branches; with -l, from\n" \
+	"\t\tthe entry point, functions and $a symbols of the image\n" \
+	"  -T\t\tDisassemble input as Thumb code (on one thread)\n" \
+	"  -x\t\tRead input as hex bytes separated by whitespace\n" \
+	"  -X LAYOUT\tRead input as hex dump in LAYOUT, one of plain,\n" \
+	"\t\txxd, od (od -x) and mdw (OpenOCD mdw)\n" \
+	"  -z, --cache-size=SIZE\n" \
+	"\t\tRemove the least recently used pages when the cache\n" \
+	"\t\ttakes more than SIZE MB (default 256)\n" \
 	"Report bugs to <" PACKAGE_BUGREPORT ">.\n"
 
-/* Return -1 on error, 0 on EOF, 1 on succesful read. */
-int
-read_hex_input(void *dest, size_t size, FILE *f)
+/* Size of output buffer and room reserved for one line of output */
+#define OUTPUT_SIZE  65536
+#define LINE_SIZE    256
+
+/* Number of words decoded at a time */
+#define CHUNK_SIZE  1024
+
+/* Number of words disassembled by a thread at a time */
+#define JOB_SIZE  4096
+
+/* Maximum number of address ranges */
+#define MAX_RANGES  64
+
+/* Maximum number of entry points */
+#define MAX_ENTRIES  64
+
+/* Default size of the page cache in MB */
+#define PAGE_CACHE_SIZE  256
+
+/* Longest symbol name printed in full */
+#define MAX_NAME  4096
+
+/* Number of words in the blocks sampled by --sample */
+#define SAMPLE_SIZE  1024
+
+
+/* Address range [start, end) */
+typedef struct {
+	unsigned long long start;
+	unsigned long long end;
+} range_t;
+
+static range_t ranges[MAX_RANGES];
+static int nranges = 0;
+
+static int use_decode_cache = 0;
+
+static int trace_code = 0;
+static int use_query = 0;
+static da_query_t query;
+
+
+/* Instruction counts. Registers are followed by the status register and
+   memory. */
+#define STATS_REGS  (DA_REG_MAX + 2)
+
+typedef struct {
+	unsigned long long words;
+	unsigned long long groups[DA_GROUP_MAX];
+	unsigned long long conds[DA_COND_MAX];
+	unsigned long long data_ops[DA_DATA_OP_MAX];
+	unsigned long long read[STATS_REGS];
+	unsigned long long written[STATS_REGS];
+} stats_t;
+
+/* Counts of the main thread, followed by those of the job threads */
+static stats_t *stats = NULL;
+static int nstats = 0;
+static int count_stats = 0;
+static unsigned long long stats_total = 0;
+static unsigned int sample_every = 1;
+/* Cache of the text of pages */
+static int use_page_cache = 0;
+static da_page_cache_t page_cache;
+
+/* Symbols printed as labels and branch targets */
+static da_symtab_t symtab;
+static const da_symtab_t *symbols = NULL;
+
+static da_addr_t entries[MAX_ENTRIES];
+static size_t nentries = 0;
+
+
+/* Buffer of output text. Buffers of jobs grow instead of being
+   flushed, since they are written in order by the main thread. */
+typedef struct {
+	char *data;
+	size_t len;
+	size_t size;
+	int grow;
+} output_t;
+
+static char stdout_data[OUTPUT_SIZE];
+static output_t stdout_output = { stdout_data, 0, OUTPUT_SIZE, 0 };
+
+/* Room reserved for one line of output with a symbol name */
+static size_t line_room = LINE_SIZE;
+
+static void
+flush_output(output_t *out)
 {
-	int c = fgetc(f);
-	if (c == EOF) return 0;
-	
+	size_t written = fwrite(out->data, 1, out->len, stdout);
+	if (written < out->len) {
+		perror("fwrite");
+		exit(EXIT_FAILURE);
+	}
+	out->len = 0;
+}
+
+/* Make room for len bytes in the output buffer. */
+static void
+reserve_output(output_t *out, size_t len)
+{
+	if (out->size - out->len >= len) return;
+	if (!out->grow) {
+		flush_output(out);
+		return;
+	}
+
+	while (out->size - out->len < len) out->size *= 2;
+	out->data = realloc(out->data, out->size);
+	if (out->data == NULL) {
+		perror("realloc");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Append value as with "%08x\t". */
+static char *
+print_hex_column(char *p, da_uint_t value)
+{
+	static const char digits[] = "0123456789abcdef";
+	int i;
+	for (i = 7; i >= 0; i--) {
+		p[i] = digits[value & 0xf];
+		value >>= 4;
+	}
+	p[8] = '\t';
+	return p + 9;
+}
+
+/* Append value as with "%04x". */
+static char *
+print_hex_hword(char *p, da_uint_t value)
+{
+	static const char digits[] = "0123456789abcdef";
 	int i;
-	for (i = 0; i < size; i++) {
-		while (isspace(c)) {
-			c = fgetc(f);
-		}
-
-		if (c == EOF) return 0;
-
-		int byte = 0;
-		int j;
-		for (j = 0; j < 2; j++) {
-			int input;
-			if (c >= '0' && c <= '9') {
-				input = c - '0';
-			} else if (c >= 'a' && c <= 'f') {
-				input = c - 'a' + 10;
-			} else if (c >= 'A' && c <= 'F') {
-				input = c - 'A' + 10;
-			} else if (j > 0 && isspace(c)) {
+	for (i = 3; i >= 0; i--) {
+		p[i] = digits[value & 0xf];
+		value >>= 4;
+	}
+	return p + 4;
+}
+
+/* Append the labels of the symbols from index *sym that are before
+   address end to the output buffer. */
+static void
+print_labels(output_t *out, size_t *sym, da_addr_t end)
+{
+	while (*sym < symbols->count && symbols->syms[*sym].addr < end) {
+		const da_sym_t *s = &symbols->syms[*sym];
+		reserve_output(out, line_room);
+
+		/* Names longer than the room are truncated */
+		size_t room = out->size - out->len;
+		int n = snprintf(out->data + out->len, room, "\n%08x <%s>:\n",
+				 (unsigned int)s->addr, s->name);
+		out->len += ((size_t)n < room ? (size_t)n : room - 1);
+		*sym += 1;
+	}
+}
+
+/* Append the heading of a section, or of a segment if name is NULL, to
+   the output buffer. */
+static void
+print_section(output_t *out, const char *name)
+{
+	reserve_output(out, LINE_SIZE);
+	out->len += snprintf(out->data + out->len, LINE_SIZE,
+			     "\nDisassembly of %s%.200s:\n",
+			     (name != NULL ? "section " : "segment"),
+			     (name != NULL ? name : ""));
+}
+
+/* Append a line of disassembly to the output buffer. */
+static void
+print_line(output_t *out, const da_instr_t *instr,
+	   const da_instr_args_t *args, da_addr_t addr)
+{
+	reserve_output(out, line_room);
+
+	char *p = out->data + out->len;
+	p = print_hex_column(p, addr);
+	p = print_hex_column(p, instr->data);
+	if (symbols != NULL) {
+		/* Leave room for the newline; long names are truncated */
+		size_t room = out->data + out->size - p - 1;
+		size_t n = da_instr_snprint_sym(p, room, instr, args, addr,
+						symbols);
+		p += (n < room ? n : room - 1);
+	} else {
+		p += da_instr_snprint(p, out->data + out->size - p, instr,
+				      args, addr);
+	}
+	*p++ = '\n';
+	out->len = p - out->data;
+}
+
+/* Return the value of word as read with the given byte order. */
+static da_word_t
+word_value(da_word_t word, int big_endian)
+{
+	const unsigned char *b = (const unsigned char *)&word;
+	if (big_endian) {
+		return ((da_word_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) |
+			b[3];
+	}
+	return ((da_word_t)b[3] << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
+}
+
+/* Append the line of word i of page at address addr to the output
+   buffer. */
+static void
+print_page_line(output_t *out, const da_page_t *page, size_t i,
+		da_addr_t addr, int big_endian)
+{
+	reserve_output(out, line_room);
+
+	char *p = out->data + out->len;
+	p = print_hex_column(p, addr);
+	p = print_hex_column(p, word_value(page->words[i], big_endian));
+
+	size_t len;
+	const char *text = da_page_text(page, i, &len);
+	memcpy(p, text, len);
+	p += len;
+
+	da_instr_rel_t rel;
+	da_page_rel(page, i, &rel);
+	if (rel.present) {
+		size_t room = out->data + out->size - p - 1;
+		size_t n;
+		if (symbols != NULL) {
+			n = da_symtab_snprint_addr(p, room, symbols,
+						   addr + rel.delta);
+		} else {
+			n = da_instr_snprint_rel_addr(p, room, &rel, addr);
+		}
+		p += (n < room ? n : room - 1);
+	}
+	*p++ = '\n';
+	out->len = p - out->data;
+}
+
+/* Parse comma separated list of START-END ranges into the sorted list of
+   ranges, merging overlapping ranges. Return -1 on error. */
+static int
+parse_ranges(const char *arg)
+{
+	const char *p = arg;
+
+	while (*p != '\0') {
+		char *end;
+		range_t range;
+
+		if (nranges == MAX_RANGES) return -1;
+
+		errno = 0;
+		range.start = strtoull(p, &end, 0);
+		if (errno != 0 || end == p || *end != '-') return -1;
+		p = end + 1;
+
+		range.end = strtoull(p, &end, 0);
+		if (errno != 0 || end == p) return -1;
+		if (*end == ',') end += 1;
+		else if (*end != '\0') return -1;
+		p = end;
+
+		if (range.end <= range.start) continue;
+
+		/* Insert sorted by start */
+		int i = nranges++;
+		while (i > 0 && ranges[i-1].start > range.start) {
+			ranges[i] = ranges[i-1];
+			i -= 1;
+		}
+		ranges[i] = range;
+	}
+
+	/* Merge overlapping ranges */
+	int i, n = 0;
+	for (i = 0; i < nranges; i++) {
+		if (n > 0 && ranges[i].start <= ranges[n-1].end) {
+			if (ranges[i].end > ranges[n-1].end) {
+				ranges[n-1].end = ranges[i].end;
+			}
+		} else {
+			ranges[n++] = ranges[i];
+		}
+	}
+	nranges = n;
+
+	return 0;
+}
+
+/* Disassemble the words that match the query among count words located at
+   address addr to out. */
+static void
+find_words(output_t *out, const da_word_t *words, size_t count,
+	   da_addr_t addr, int big_endian)
+{
+	size_t hits[CHUNK_SIZE];
+	size_t start = 0;
+
+	for (;;) {
+		size_t n = da_query_find(&query, hits, CHUNK_SIZE,
+					 words + start, count - start,
+					 big_endian);
+
+		size_t i;
+		for (i = 0; i < n; i++) {
+			size_t j = start + hits[i];
+			da_instr_t instr;
+			da_instr_args_t args;
+			da_instr_parse(&instr, words[j], big_endian);
+			da_instr_parse_args(&args, &instr);
+			print_line(out, &instr, &args,
+				   addr + j*sizeof(da_word_t));
+		}
+
+		if (n < CHUNK_SIZE) break;
+		start += hits[n - 1] + 1;
+	}
+}
+
+/* Disassemble count words located at address addr to out, using the text
+   of pages in the page cache. Pages are aligned to their address. */
+static void
+cache_words(output_t *out, const da_word_t *words, size_t count,
+	    da_addr_t addr, int big_endian)
+{
+	da_page_t page;
+	da_page_init(&page);
+
+	size_t sym = (symbols != NULL ? da_symtab_find(symbols, addr) : 0);
+	while (count > 0) {
+		size_t n = DA_PAGE_CACHE_WORDS -
+			(addr / sizeof(da_word_t)) % DA_PAGE_CACHE_WORDS;
+		if (n > count) n = count;
+
+		int r = da_page_cache_render(&page_cache, &page, words, n,
+					     big_endian);
+		if (r < 0) {
+			perror("da_page_cache_render");
+			exit(EXIT_FAILURE);
+		}
+
+		size_t i;
+		for (i = 0; i < n; i++) {
+			da_addr_t a = addr + i*sizeof(da_word_t);
+			if (symbols != NULL) {
+				print_labels(out, &sym, a + sizeof(da_word_t));
+			}
+			print_page_line(out, &page, i, a, big_endian);
+		}
+
+		words += n;
+		count -= n;
+		addr += n*sizeof(da_word_t);
+	}
+
+	da_page_free(&page);
+}
+
+/* Disassemble count words located at address addr to out. */
+static void
+decode_words(output_t *out, const da_word_t *words, size_t count,
+	     da_addr_t addr, int big_endian)
+{
+	if (use_query) {
+		find_words(out, words, count, addr, big_endian);
+		return;
+	} else if (use_page_cache) {
+		cache_words(out, words, count, addr, big_endian);
+		return;
+	}
+
+	da_instr_t instrs[CHUNK_SIZE];
+	da_instr_args_t args[CHUNK_SIZE];
+
+	/* Repeated words are decoded once per thread */
+	da_decode_cache_t *cache = (use_decode_cache ?
+				    da_decode_cache_thread() : NULL);
+
+	while (count > 0) {
+		size_t n = (count < CHUNK_SIZE ? count : CHUNK_SIZE);
+
+		da_instr_parse_block(instrs, words, n, big_endian);
+		if (cache != NULL) {
+			da_decode_cache_parse_args_block(cache, args, instrs,
+							 n);
+		} else {
+			da_instr_parse_args_block(args, instrs, n);
+		}
+
+		size_t i;
+		if (symbols != NULL) {
+			size_t sym = da_symtab_find(symbols, addr);
+			for (i = 0; i < n; i++) {
+				da_addr_t a = addr + i*sizeof(da_word_t);
+				print_labels(out, &sym, a + sizeof(da_word_t));
+				print_line(out, &instrs[i], &args[i], a);
+			}
+		} else {
+			for (i = 0; i < n; i++) {
+				print_line(out, &instrs[i], &args[i],
+					   addr + i*sizeof(da_word_t));
+			}
+		}
+
+		words += n;
+		count -= n;
+		addr += n*sizeof(da_word_t);
+	}
+}
+
+/* Add one to counts for each register, status register or memory in
+   mask. */
+static void
+count_regs(unsigned long long *counts, da_uint_t mask)
+{
+	while (mask != 0) {
+		int i = 0;
+		while (!((mask >> i) & 1)) i += 1;
+		counts[i] += 1;
+		mask &= mask - 1;
+	}
+}
+
+/* Count the groups, conditions, opcodes and registers of count words.
+   Only the fields needed are decoded. */
+static void
+count_words(stats_t *st, const da_word_t *words, size_t count,
+	    int big_endian)
+{
+	da_instr_t instrs[CHUNK_SIZE];
+	da_uint_t read[CHUNK_SIZE];
+	da_uint_t written[CHUNK_SIZE];
+
+	while (count > 0) {
+		size_t n = (count < CHUNK_SIZE ? count : CHUNK_SIZE);
+
+		da_instr_parse_block(instrs, words, n, big_endian);
+		da_instr_regs_block(read, written, instrs, n);
+
+		size_t i;
+		for (i = 0; i < n; i++) {
+			const da_instr_t *instr = &instrs[i];
+			st->groups[instr->group] += 1;
+			st->conds[da_instr_get_cond(instr)] += 1;
+
+			switch (instr->group) {
+			case DA_GROUP_DATA_IMM:
+			case DA_GROUP_DATA_IMM_SH:
+			case DA_GROUP_DATA_REG_SH:
+				st->data_ops[DA_ARG_DATA_OP(instr, 21)] += 1;
 				break;
-			} else {
-				return -1;
+			default:
+				break;
+			}
+
+			count_regs(st->read, read[i]);
+			count_regs(st->written, written[i]);
+		}
+
+		st->words += n;
+		words += n;
+		count -= n;
+	}
+}
+
+/* Print the counts of all threads as tab separated lines of kind, name
+   and count. */
+static void
+print_stats(void)
+{
+	stats_t sum;
+	memset(&sum, 0, sizeof(sum));
+
+	int t, i;
+	for (t = 0; t < nstats; t++) {
+		sum.words += stats[t].words;
+		for (i = 0; i < DA_GROUP_MAX; i++) {
+			sum.groups[i] += stats[t].groups[i];
+		}
+		for (i = 0; i < DA_COND_MAX; i++) {
+			sum.conds[i] += stats[t].conds[i];
+		}
+		for (i = 0; i < DA_DATA_OP_MAX; i++) {
+			sum.data_ops[i] += stats[t].data_ops[i];
+		}
+		for (i = 0; i < STATS_REGS; i++) {
+			sum.read[i] += stats[t].read[i];
+			sum.written[i] += stats[t].written[i];
+		}
+	}
+
+	printf("total\twords\t%llu\n", stats_total);
+	printf("total\tsampled\t%llu\n", sum.words);
+	for (i = 0; i < DA_GROUP_MAX; i++) {
+		printf("group\t%s\t%llu\n", da_group_name(i), sum.groups[i]);
+	}
+	for (i = 0; i < DA_COND_MAX; i++) {
+		printf("cond\t%s\t%llu\n", da_cond_name(i), sum.conds[i]);
+	}
+	for (i = 0; i < DA_DATA_OP_MAX; i++) {
+		printf("op\t%s\t%llu\n", da_data_op_name(i), sum.data_ops[i]);
+	}
+	for (i = 0; i < STATS_REGS; i++) {
+		char name[8];
+		if (i < DA_REG_MAX) sprintf(name, "r%d", i);
+		else strcpy(name, (i == DA_REG_MAX ? "cpsr" : "memory"));
+		printf("read\t%s\t%llu\n", name, sum.read[i]);
+		printf("written\t%s\t%llu\n", name, sum.written[i]);
+	}
+}
+
+#ifdef HAVE_PTHREAD
+/* Words to be disassembled by a thread. Jobs are taken by the threads in
+   the order they were submitted, and their output is written in the same
+   order by the main thread. */
+typedef struct {
+	da_word_t words[JOB_SIZE];
+	size_t count;
+	da_addr_t addr;
+	int big_endian;
+	int done;
+	output_t output;
+} job_t;
+
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done_cond = PTHREAD_COND_INITIALIZER;
+
+static job_t *jobs = NULL;
+static size_t njobs = 0;
+static unsigned long next_submit = 0;
+static unsigned long next_take = 0;
+static unsigned long next_write = 0;
+static int jobs_finished = 0;
+
+static pthread_t *threads = NULL;
+static int nthreads = 0;
+
+static void *
+job_thread(void *arg)
+{
+	pthread_mutex_lock(&job_mutex);
+
+	while (1) {
+		while (next_take == next_submit && !jobs_finished) {
+			pthread_cond_wait(&job_ready_cond, &job_mutex);
+		}
+		if (next_take == next_submit) break;
+
+		job_t *job = &jobs[next_take % njobs];
+		next_take += 1;
+		pthread_mutex_unlock(&job_mutex);
+
+		if (count_stats) {
+			count_words(arg, job->words, job->count,
+				    job->big_endian);
+		} else {
+			decode_words(&job->output, job->words, job->count,
+				     job->addr, job->big_endian);
+		}
+
+		pthread_mutex_lock(&job_mutex);
+		job->done = 1;
+		pthread_cond_broadcast(&job_done_cond);
+	}
+
+	pthread_mutex_unlock(&job_mutex);
+	return NULL;
+}
+
+/* Start n threads with two jobs in flight for each. */
+static void
+start_threads(int n)
+{
+	int i;
+
+	njobs = 2*n;
+	jobs = calloc(njobs, sizeof(job_t));
+	threads = calloc(n, sizeof(pthread_t));
+	if (jobs == NULL || threads == NULL) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < njobs; i++) {
+		jobs[i].output.size = JOB_SIZE*LINE_SIZE;
+		jobs[i].output.grow = 1;
+		jobs[i].output.data = malloc(jobs[i].output.size);
+		if (jobs[i].output.data == NULL) {
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		int r = pthread_create(&threads[i], NULL, job_thread,
+				       &stats[i + 1]);
+		if (r != 0) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(r));
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	nthreads = n;
+}
+
+/* Wait for the oldest job and write its output. */
+static void
+write_job(void)
+{
+	job_t *job = &jobs[next_write % njobs];
+
+	pthread_mutex_lock(&job_mutex);
+	while (!job->done) pthread_cond_wait(&job_done_cond, &job_mutex);
+	pthread_mutex_unlock(&job_mutex);
+
+	flush_output(&job->output);
+	job->done = 0;
+	next_write += 1;
+}
+
+static void
+submit_words(const da_word_t *words, size_t count, da_addr_t addr,
+	     int big_endian)
+{
+	while (count > 0) {
+		size_t n = (count < JOB_SIZE ? count : JOB_SIZE);
+
+		if (next_submit - next_write == njobs) write_job();
+
+		job_t *job = &jobs[next_submit % njobs];
+		memcpy(job->words, words, n*sizeof(da_word_t));
+		job->count = n;
+		job->addr = addr;
+		job->big_endian = big_endian;
+
+		pthread_mutex_lock(&job_mutex);
+		next_submit += 1;
+		pthread_cond_signal(&job_ready_cond);
+		pthread_mutex_unlock(&job_mutex);
+
+		words += n;
+		count -= n;
+		addr += n*sizeof(da_word_t);
+	}
+}
+
+/* Write the output of all submitted jobs and stop the threads. */
+static void
+stop_threads(void)
+{
+	int i;
+
+	while (next_write != next_submit) write_job();
+
+	pthread_mutex_lock(&job_mutex);
+	jobs_finished = 1;
+	pthread_cond_broadcast(&job_ready_cond);
+	pthread_mutex_unlock(&job_mutex);
+
+	for (i = 0; i < nthreads; i++) pthread_join(threads[i], NULL);
+	nthreads = 0;
+}
+#endif
+
+/* Disassemble or count count words located at address addr. */
+static void
+dispatch_words(const da_word_t *words, size_t count, da_addr_t addr,
+	       int big_endian)
+{
+#ifdef HAVE_PTHREAD
+	if (nthreads > 0) {
+		/* Text added after sync_output goes before the jobs */
+		if (stdout_output.len > 0) flush_output(&stdout_output);
+		submit_words(words, count, addr, big_endian);
+		return;
+	}
+#endif
+	if (count_stats) count_words(&stats[0], words, count, big_endian);
+	else decode_words(&stdout_output, words, count, addr, big_endian);
+}
+
+/* Disassemble count words located at address addr. When sampling, only
+   the words in one of every sample_every aligned blocks are counted and
+   the rest are not accessed. */
+static void
+disasm_words(const da_word_t *words, size_t count, da_addr_t addr,
+	     int big_endian)
+{
+	stats_total += count;
+	if (!count_stats || sample_every <= 1) {
+		dispatch_words(words, count, addr, big_endian);
+		return;
+	}
+
+	while (count > 0) {
+		da_addr_t block = addr / (SAMPLE_SIZE*sizeof(da_word_t));
+		size_t n = SAMPLE_SIZE - (addr / sizeof(da_word_t)) %
+			SAMPLE_SIZE;
+		if (n > count) n = count;
+
+		if (block % sample_every == 0) {
+			dispatch_words(words, n, addr, big_endian);
+		}
+
+		words += n;
+		count -= n;
+		addr += n*sizeof(da_word_t);
+	}
+}
+
+/* Write the output of all submitted jobs, so that text can be added to
+   the standard output buffer in order. */
+static void
+sync_output(void)
+{
+#ifdef HAVE_PTHREAD
+	while (nthreads > 0 && next_write != next_submit) write_job();
+#endif
+}
+
+/* Write all pending output and close the page cache. */
+static void
+finish_output(void)
+{
+#ifdef HAVE_PTHREAD
+	if (nthreads > 0) stop_threads();
+#endif
+	flush_output(&stdout_output);
+	if (count_stats) print_stats();
+	if (use_page_cache) da_page_cache_close(&page_cache);
+}
+
+/* Disassemble the parts of count words at address addr that are inside the
+   selected ranges. Words outside the ranges are not accessed. */
+static void
+disasm_ranges(const da_word_t *words, size_t count, unsigned long long addr,
+	      int big_endian)
+{
+	if (nranges == 0) {
+		disasm_words(words, count, addr, big_endian);
+		return;
+	}
+
+	unsigned long long end = addr + count*sizeof(da_word_t);
+	int i;
+	for (i = 0; i < nranges && ranges[i].start < end; i++) {
+		if (ranges[i].end <= addr) continue;
+
+		unsigned long long start = (ranges[i].start > addr ?
+					    ranges[i].start : addr);
+		unsigned long long stop = (ranges[i].end < end ?
+					   ranges[i].end : end);
+
+		/* Include words that overlap the range */
+		size_t first = (start - addr) / sizeof(da_word_t);
+		size_t last = (stop - addr + sizeof(da_word_t) - 1) /
+			sizeof(da_word_t);
+
+		disasm_words(words + first, last - first,
+			     addr + first*sizeof(da_word_t), big_endian);
+	}
+}
+
+/* Disassemble count words at data, which need not be aligned, located
+   at address addr. */
+static void
+disasm_bytes(const unsigned char *data, size_t count, unsigned long long addr,
+	     int big_endian)
+{
+	if (((uintptr_t)data % sizeof(da_word_t)) == 0) {
+		disasm_ranges((const da_word_t *)data, count, addr,
+			      big_endian);
+		return;
+	}
+
+	/* Copy unaligned words to an aligned buffer */
+	da_word_t words[CHUNK_SIZE];
+	while (count > 0) {
+		size_t n = (count < CHUNK_SIZE ? count : CHUNK_SIZE);
+		memcpy(words, data, n*sizeof(da_word_t));
+		disasm_ranges(words, n, addr, big_endian);
+
+		data += n*sizeof(da_word_t);
+		addr += n*sizeof(da_word_t);
+		count -= n;
+	}
+}
+
+/* Read up to count words from f. Return the number of words read; error
+   is set if the hex input could not be parsed. */
+static size_t
+read_words(da_word_t *words, size_t count, FILE *f, hex_input_t *hex,
+	   int *error)
+{
+	if (hex == NULL) {
+		size_t read = fread(words, sizeof(da_word_t), count, f);
+		if (read < count && ferror(f)) {
+			perror("fread");
+			exit(EXIT_FAILURE);
+		}
+		return read;
+	}
+
+	size_t read = hex_input_read(hex, words, count*sizeof(da_word_t));
+	*error = hex_input_error(hex);
+	return read / sizeof(da_word_t);
+}
+
+/* Disassemble input read with stdio, as hex text if hex is not NULL. */
+static void
+disasm_stream(FILE *f, hex_input_t *hex, da_addr_t mem_offset,
+	      ssize_t disasm_size, int big_endian)
+{
+	da_word_t words[CHUNK_SIZE];
+	unsigned long long addr = mem_offset;
+	unsigned long long limit = mem_offset + disasm_size;
+
+	while (disasm_size < 0 || addr < limit) {
+		size_t count = CHUNK_SIZE;
+		if (disasm_size >= 0 && (limit - addr + sizeof(da_word_t) - 1) /
+		    sizeof(da_word_t) < count) {
+			count = (limit - addr + sizeof(da_word_t) - 1) /
+				sizeof(da_word_t);
+		}
+
+		int error = 0;
+		size_t read = read_words(words, count, f, hex, &error);
+
+		disasm_ranges(words, read, addr, big_endian);
+		addr += read*sizeof(da_word_t);
+
+		if (error) {
+			finish_output();
+			fprintf(stderr, "Unable to parse input.\n");
+			exit(EXIT_FAILURE);
+		} else if (read < count) {
+			break;
+		}
+	}
+}
+
+/* Append a line of Thumb disassembly to the output buffer. A BL or BLX
+   prefix followed by its suffix is printed as one line. Return the
+   number of halfwords printed. */
+static size_t
+print_thumb_line(output_t *out, const da_thumb_instr_t *instrs,
+		 const da_thumb_args_t *args, size_t count, da_addr_t addr)
+{
+	reserve_output(out, line_room);
+
+	char *p = out->data + out->len;
+	p = print_hex_column(p, addr);
+	p = print_hex_hword(p, instrs[0].data);
+
+	size_t n = 1;
+	if (count > 1 && instrs[0].group == DA_THUMB_GROUP_BL_PREFIX &&
+	    (instrs[1].group == DA_THUMB_GROUP_BL_SUFFIX ||
+	     instrs[1].group == DA_THUMB_GROUP_BLX_SUFFIX)) {
+		*p++ = ' ';
+		p = print_hex_hword(p, instrs[1].data);
+		*p++ = '\t';
+		if (symbols != NULL) {
+			size_t room = out->data + out->size - p - 1;
+			size_t len = da_thumb_snprint_bl_sym(p, room, &args[0],
+							     &args[1], addr,
+							     symbols);
+			p += (len < room ? len : room - 1);
+		} else {
+			p += da_thumb_snprint_bl(p, out->data + out->size - p,
+						 &args[0], &args[1], addr);
+		}
+		n = 2;
+	} else {
+		*p++ = '\t';
+		p += da_thumb_snprint(p, out->data + out->size - p,
+				      &instrs[0], &args[0], addr);
+	}
+	*p++ = '\n';
+	out->len = p - out->data;
+	return n;
+}
+
+/* Disassemble count Thumb halfwords at address addr. */
+static void
+disasm_thumb(const da_hword_t *data, size_t count, da_addr_t addr,
+	     int big_endian)
+{
+	da_thumb_instr_t instrs[CHUNK_SIZE];
+	da_thumb_args_t args[CHUNK_SIZE];
+
+	while (count > 0) {
+		size_t n = (count < CHUNK_SIZE ? count : CHUNK_SIZE);
+		da_thumb_parse_block(instrs, data, n, big_endian);
+		da_thumb_parse_args_block(args, instrs, n);
+
+		/* Leave a prefix at the end for the next chunk */
+		if (n < count && n > 1 &&
+		    instrs[n-1].group == DA_THUMB_GROUP_BL_PREFIX) n -= 1;
+
+		size_t i = 0;
+		size_t sym = (symbols != NULL ?
+			      da_symtab_find(symbols, addr) : 0);
+		while (i < n) {
+			da_addr_t a = addr + i*sizeof(da_hword_t);
+			if (symbols != NULL) {
+				print_labels(&stdout_output, &sym,
+					     a + sizeof(da_hword_t));
+			}
+			i += print_thumb_line(&stdout_output, &instrs[i],
+					      &args[i], n - i, a);
+		}
+
+		data += n;
+		addr += n*sizeof(da_hword_t);
+		count -= n;
+	}
+}
+
+/* Disassemble the parts of count Thumb halfwords at address addr that are
+   inside the selected ranges. */
+static void
+disasm_thumb_ranges(const da_hword_t *data, size_t count,
+		    unsigned long long addr, int big_endian)
+{
+	if (nranges == 0) {
+		disasm_thumb(data, count, addr, big_endian);
+		return;
+	}
+
+	unsigned long long end = addr + count*sizeof(da_hword_t);
+	int i;
+	for (i = 0; i < nranges && ranges[i].start < end; i++) {
+		if (ranges[i].end <= addr) continue;
+
+		unsigned long long start = (ranges[i].start > addr ?
+					    ranges[i].start : addr);
+		unsigned long long stop = (ranges[i].end < end ?
+					   ranges[i].end : end);
+
+		/* Include halfwords that overlap the range */
+		size_t first = (start - addr) / sizeof(da_hword_t);
+		size_t last = (stop - addr + sizeof(da_hword_t) - 1) /
+			sizeof(da_hword_t);
+
+		disasm_thumb(data + first, last - first,
+			     addr + first*sizeof(da_hword_t), big_endian);
+	}
+}
+
+/* Read all of the input, up to disasm_size bytes if not negative. Return
+   the data, which must be freed, and set size to the number of bytes. */
+static unsigned char *
+read_all(FILE *f, hex_input_t *hex, ssize_t disasm_size, size_t *size)
+{
+	size_t len = 0;
+	size_t alloc = OUTPUT_SIZE;
+	unsigned char *data = malloc(alloc);
+	if (data == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	while (disasm_size < 0 || len < (size_t)disasm_size) {
+		if (len == alloc) {
+			alloc *= 2;
+			data = realloc(data, alloc);
+			if (data == NULL) {
+				perror("realloc");
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		size_t read;
+		if (hex == NULL) {
+			read = fread(data + len, 1, alloc - len, f);
+			if (read < alloc - len && ferror(f)) {
+				perror("fread");
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			read = hex_input_read(hex, data + len, alloc - len);
+			if (hex_input_error(hex)) {
+				fprintf(stderr, "Unable to parse input.\n");
+				exit(EXIT_FAILURE);
 			}
-					
-			byte = (byte << 4) | input;
+		}
+
+		len += read;
+		if (read == 0) break;
+	}
+
+	*size = len;
+	return data;
+}
+
+/* Read all of the input and disassemble it as Thumb code. Thumb code
+   can not be split at arbitrary halfwords because of BL pairs, so it is
+   disassembled on one thread. */
+static void
+disasm_thumb_stream(FILE *f, hex_input_t *hex, da_addr_t mem_offset,
+		    ssize_t disasm_size, int big_endian)
+{
+	size_t size;
+	unsigned char *data = read_all(f, hex, disasm_size, &size);
+
+	if (disasm_size >= 0 && size > (size_t)disasm_size) {
+		size = disasm_size + (disasm_size & 1);
+	}
+
+	disasm_thumb_ranges((const da_hword_t *)data,
+			    size / sizeof(da_hword_t), mem_offset, big_endian);
+	free(data);
+}
+
+/* Disassemble the runs of code in count words at address addr that are
+   reached from the nstarts addresses in starts, or from the exception
+   vectors if starts is NULL. */
+static void
+disasm_traced(const da_word_t *words, size_t count, da_addr_t addr,
+	      int big_endian, const da_addr_t *starts, size_t nstarts)
+{
+	int threads = 1;
+#ifdef HAVE_PTHREAD
+	if (nthreads > 0) threads = nthreads;
+#endif
+
+	da_trace_t trace;
+	int r = da_trace_run(&trace, words, count, addr, big_endian,
+			     starts, nstarts, threads);
+	if (r < 0) {
+		fprintf(stderr, "Unable to trace code.\n");
+		exit(EXIT_FAILURE);
+	}
 
-			c = fgetc(f);
-			if (c == EOF) break;
+	size_t i = 0;
+	while (i < count) {
+		if (!da_trace_is_code(&trace, i)) {
+			i += 1;
+			continue;
 		}
 
-		((unsigned char *)dest)[i] = byte;
+		size_t j = i + 1;
+		while (j < count && da_trace_is_code(&trace, j)) j += 1;
+		disasm_ranges(words + i, j - i, addr + i*sizeof(da_word_t),
+			      big_endian);
+		i = j;
+	}
+
+	da_trace_free(&trace);
+}
+
+/* Read all of the input and disassemble the code reached from the entry
+   points. */
+static void
+disasm_trace_stream(FILE *f, hex_input_t *hex, da_addr_t mem_offset,
+		    ssize_t disasm_size, int big_endian)
+{
+	size_t size;
+	unsigned char *data = read_all(f, hex, disasm_size, &size);
+
+	/* Include the word that overlaps the end */
+	if (disasm_size >= 0 &&
+	    size > (size_t)disasm_size + sizeof(da_word_t) - 1) {
+		size = disasm_size + sizeof(da_word_t) - 1;
+	}
+
+	disasm_traced((const da_word_t *)data, size / sizeof(da_word_t),
+		      mem_offset, big_endian,
+		      (nentries > 0 ? entries : NULL), nentries);
+	free(data);
+}
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+/* Disassemble regular file by mapping it to memory. Return -1 if the
+   file cannot be mapped. */
+static int
+disasm_mapped(int fd, off_t file_offset, da_addr_t mem_offset,
+	      ssize_t disasm_size, int big_endian)
+{
+	struct stat st;
+	int r = fstat(fd, &st);
+	if (r < 0 || !S_ISREG(st.st_mode)) return -1;
+
+	if (st.st_size <= file_offset) return 0;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) return -1;
+
+#ifdef HAVE_MADVISE
+	/* Advice only; errors are ignored */
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+# ifdef MADV_HUGEPAGE
+	madvise(map, st.st_size, MADV_HUGEPAGE);
+# endif
+#endif
+
+	const unsigned char *data = (const unsigned char *)map + file_offset;
+	size_t count = (st.st_size - file_offset) / sizeof(da_word_t);
+	if (disasm_size >= 0 &&
+	    (disasm_size + sizeof(da_word_t) - 1) / sizeof(da_word_t) < count) {
+		count = (disasm_size + sizeof(da_word_t) - 1) /
+			sizeof(da_word_t);
 	}
 
-	return 1;
+	if (trace_code) {
+		/* Mapped words are aligned for tracing */
+		disasm_traced((const da_word_t *)data, count, mem_offset,
+			      big_endian, (nentries > 0 ? entries : NULL),
+			      nentries);
+	} else {
+		disasm_bytes(data, count, mem_offset, big_endian);
+	}
+
+	munmap(map, st.st_size);
+	return 0;
+}
+#endif
+
+/* Build the symbol table and use it for labels and branch targets,
+   unless counting instructions. */
+static void
+use_symbols(void)
+{
+	if (da_symtab_build(&symtab) < 0) {
+		perror("da_symtab_build");
+		exit(EXIT_FAILURE);
+	}
+	if (count_stats || symtab.count == 0) return;
+
+	/* Lines have room for the longest name, up to a limit */
+	size_t i, longest = 0;
+	for (i = 0; i < symtab.count; i++) {
+		size_t len = strlen(symtab.syms[i].name);
+		if (len > longest) longest = len;
+	}
+	line_room = LINE_SIZE + (longest < MAX_NAME ? longest : MAX_NAME);
+	symbols = &symtab;
+}
+
+/* Return the entry points for tracing ELF image: those given with -e,
+   the entry point and ARM functions of the image, and the start of each
+   range of ARM code, which begins at a $a symbol or a section. */
+static da_addr_t *
+elf_entries(const da_elf_t *elf, size_t *count)
+{
+	da_addr_t *starts = malloc((nentries + 1 + elf->nsyms +
+				    elf->nranges) * sizeof(da_addr_t));
+	if (starts == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	size_t n = 0;
+	size_t i;
+	for (i = 0; i < nentries; i++) starts[n++] = entries[i];
+	if (!(elf->entry & 1)) starts[n++] = elf->entry;
+	for (i = 0; i < elf->nsyms; i++) {
+		const da_elf_sym_t *sym = &elf->syms[i];
+		if (sym->func && !sym->thumb) starts[n++] = sym->addr;
+	}
+	for (i = 0; i < elf->nranges; i++) {
+		const da_elf_range_t *range = &elf->ranges[i];
+		if (range->mode == DA_ELF_MODE_ARM) starts[n++] = range->addr;
+	}
+
+	*count = n;
+	return starts;
+}
+
+/* Disassemble the code of ARM range of ELF image that is reached from
+   the nstarts addresses in starts. Branches to other ranges are not
+   followed. */
+static void
+disasm_elf_traced(const da_elf_range_t *range, int big_endian,
+		  const da_addr_t *starts, size_t nstarts)
+{
+	size_t count = range->size / sizeof(da_word_t);
+	if (((uintptr_t)range->data % sizeof(da_word_t)) == 0) {
+		disasm_traced((const da_word_t *)range->data, count,
+			      range->addr, big_endian, starts, nstarts);
+		return;
+	}
+
+	if (count == 0) return;
+
+	/* Copy unaligned words */
+	da_word_t *words = malloc(count*sizeof(da_word_t));
+	if (words == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(words, range->data, count*sizeof(da_word_t));
+	disasm_traced(words, count, range->addr, big_endian, starts, nstarts);
+	free(words);
+}
+
+/* Disassemble the executable ranges of the ELF image in path, labelled
+   with its symbols. The sections are not copied unless unaligned. With
+   -t, only the ARM code reached from the entry points of elf_entries is
+   disassembled. */
+static void
+disasm_elf(const char *path)
+{
+	da_elf_t elf;
+	int r = da_elf_open(&elf, path);
+	if (r < 0) {
+		fprintf(stderr, "Unable to load ELF image: %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (da_symtab_add_elf(&symtab, &elf) < 0) {
+		perror("da_symtab_add_elf");
+		exit(EXIT_FAILURE);
+	}
+	use_symbols();
+
+	da_addr_t *starts = NULL;
+	size_t nstarts = 0;
+	if (trace_code) starts = elf_entries(&elf, &nstarts);
+
+	const char *section = NULL;
+	size_t i;
+	for (i = 0; i < elf.nranges; i++) {
+		const da_elf_range_t *range = &elf.ranges[i];
+		if (range->mode == DA_ELF_MODE_DATA) continue;
+
+		/* Only ARM code is counted */
+		if (range->mode == DA_ELF_MODE_THUMB && count_stats) continue;
+
+		if (!count_stats && (i == 0 || range->section != section)) {
+			sync_output();
+			print_section(&stdout_output, range->section);
+			section = range->section;
+		}
+
+		if (range->mode == DA_ELF_MODE_ARM && trace_code) {
+			disasm_elf_traced(range, elf.big_endian, starts,
+					  nstarts);
+			continue;
+		} else if (range->mode == DA_ELF_MODE_ARM) {
+			disasm_bytes(range->data,
+				     range->size / sizeof(da_word_t),
+				     range->addr, elf.big_endian);
+			continue;
+		}
+
+		sync_output();
+		size_t count = range->size / sizeof(da_hword_t);
+		if (((uintptr_t)range->data % sizeof(da_hword_t)) == 0) {
+			disasm_thumb_ranges((const da_hword_t *)range->data,
+					    count, range->addr,
+					    elf.big_endian);
+		} else {
+			/* Copy unaligned halfwords */
+			da_hword_t *data = malloc(count*sizeof(da_hword_t));
+			if (data == NULL) {
+				perror("malloc");
+				exit(EXIT_FAILURE);
+			}
+			memcpy(data, range->data, count*sizeof(da_hword_t));
+			disasm_thumb_ranges(data, count, range->addr,
+					    elf.big_endian);
+			free(data);
+		}
+	}
+
+	finish_output();
+	free(starts);
+	symbols = NULL;
+	da_symtab_free(&symtab);
+	da_elf_free(&elf);
 }
 
 int
@@ -92,17 +1376,53 @@ main(int argc, char *argv[])
 	int r;
 
 	int hex_input = 0;
+	hex_layout_t hex_layout = HEX_LAYOUT_PLAIN;
 	da_addr_t mem_offset = 0;
 	off_t file_offset = 0;
 	ssize_t disasm_size = -1;
 	int big_endian = 0;
+	int thread_count = 1;
+	int thumb = 0;
+	int elf_input = 0;
+	const char *cache_dir = NULL;
+	unsigned long long cache_size = PAGE_CACHE_SIZE;
+
+#ifdef HAVE_GETOPT_LONG
+	static const struct option long_options[] = {
+		{ "cache", required_argument, NULL, 'C' },
+		{ "cache-size", required_argument, NULL, 'z' },
+		{ "elf", no_argument, NULL, 'l' },
+		{ "help", no_argument, NULL, 'h' },
+		{ "map", required_argument, NULL, 'M' },
+		{ "sample", required_argument, NULL, 'p' },
+		{ "stats", no_argument, NULL, 'S' },
+		{ NULL, 0, NULL, 0 }
+	};
+# define OPTIONS(s)  getopt_long(argc, argv, s, long_options, NULL)
+#else
+# define OPTIONS(s)  getopt(argc, argv, s)
+#endif
 
 	int opt;
-	while ((opt = getopt(argc, argv, "c:E:hm:s:x")) != -1) {
+	while ((opt = OPTIONS("c:C:De:E:hj:lm:M:p:q:r:s:StTxX:z:")) != -1) {
 		switch (opt) {
 		case 'c':
 			disasm_size = atoi(optarg);
 			break;
+		case 'C':
+			cache_dir = optarg;
+			break;
+		case 'D':
+			use_decode_cache = 1;
+			break;
+		case 'e':
+			if (nentries == MAX_ENTRIES) {
+				fprintf(stderr, "Too many entry points.\n");
+				exit(EXIT_FAILURE);
+			}
+			entries[nentries++] = strtoul(optarg, NULL, 0);
+			trace_code = 1;
+			break;
 		case 'E':
 			if (optarg != NULL &&
 			    (optarg[0] == 'B' || optarg[0] == 'L')) {
@@ -116,21 +1436,151 @@ main(int argc, char *argv[])
 			printf(HELP, argv[0]);
 			exit(EXIT_SUCCESS);
 			break;
+		case 'j':
+			thread_count = atoi(optarg);
+			if (thread_count < 1) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'l':
+			elf_input = 1;
+			break;
 		case 'm':
 			mem_offset = atoi(optarg);
 			break;
+		case 'M':
+			r = da_symtab_load_map(&symtab, optarg);
+			if (r < 0) {
+				perror(optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'p':
+			sample_every = strtoul(optarg, NULL, 0);
+			if (sample_every < 1) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'q':
+			r = da_query_compile(&query, optarg);
+			if (r < 0) {
+				fprintf(stderr, "Invalid query: %s\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			use_query = 1;
+			break;
+		case 'r':
+			r = parse_ranges(optarg);
+			if (r < 0) {
+				fprintf(stderr, "Invalid address range: %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		case 's':
 			file_offset = atoi(optarg);
 			break;
+		case 'S':
+			count_stats = 1;
+			break;
+		case 't':
+			trace_code = 1;
+			break;
+		case 'T':
+			thumb = 1;
+			break;
 		case 'x':
+			hex_input = 1;
+			hex_layout = HEX_LAYOUT_PLAIN;
+			break;
+		case 'X':
+			r = hex_layout_parse(optarg, &hex_layout);
+			if (r < 0) {
+				fprintf(stderr, "Unknown hex layout: %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
 			hex_input = 1;
 			break;
+		case 'z':
+			cache_size = strtoull(optarg, NULL, 0);
+			break;
 		default:
 			fprintf(stderr, USAGE, argv[0]);
 			exit(EXIT_FAILURE);
 		}
 	}
 
+	if (thumb && trace_code) {
+		fprintf(stderr, "Tracing is not supported for Thumb code.\n");
+		exit(EXIT_FAILURE);
+	} else if (thumb && use_query) {
+		fprintf(stderr, "Queries are not supported for Thumb code.\n");
+		exit(EXIT_FAILURE);
+	} else if (thumb && count_stats) {
+		fprintf(stderr, "Statistics are not supported for Thumb"
+			" code.\n");
+		exit(EXIT_FAILURE);
+	} else if (thumb && use_decode_cache) {
+		fprintf(stderr, "The decode cache is not supported for Thumb"
+			" code.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (cache_dir != NULL && (thumb || use_query || count_stats)) {
+		fprintf(stderr, "The page cache can not be used with -q, -S"
+			" or -T.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (elf_input && (thumb || hex_input || mem_offset != 0 ||
+			  file_offset != 0 || disasm_size >= 0)) {
+		fprintf(stderr, "ELF images can not be read with -c, -m, -s,"
+			" -T, -x or -X.\n");
+		exit(EXIT_FAILURE);
+	} else if (elf_input && (optind >= argc ||
+				 !strcmp(argv[optind], "-"))) {
+		fprintf(stderr, "ELF images must be read from a file.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (cache_dir != NULL) {
+		r = da_page_cache_open(&page_cache, cache_dir,
+				       cache_size << 20);
+		if (r < 0) {
+			perror(cache_dir);
+			exit(EXIT_FAILURE);
+		}
+		use_page_cache = 1;
+	}
+
+	if (count_stats) {
+		nstats = (thread_count > 1 ? thread_count + 1 : 1);
+		stats = calloc(nstats, sizeof(stats_t));
+		if (stats == NULL) {
+			perror("calloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+#ifdef HAVE_PTHREAD
+	if (thread_count > 1 && !thumb) start_threads(thread_count);
+#else
+	if (thread_count > 1) {
+		fprintf(stderr, "Threads are not supported;"
+			" disassembling on one thread.\n");
+	}
+#endif
+
+	if (elf_input) {
+		disasm_elf(argv[optind]);
+		return EXIT_SUCCESS;
+	}
+
+	if (symtab.count > 0) use_symbols();
+
 	FILE *f = stdin;
 	
 	if (optind < argc && strcmp(argv[optind], "-")) {
@@ -140,6 +1590,18 @@ main(int argc, char *argv[])
 			exit(EXIT_FAILURE);
 		}
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+		/* Regular binary files are mapped to memory */
+		if (!hex_input && !thumb && file_offset >= 0 &&
+		    (!trace_code || file_offset % sizeof(da_word_t) == 0) &&
+		    disasm_mapped(fileno(f), file_offset, mem_offset,
+				  disasm_size, big_endian) == 0) {
+			finish_output();
+			fclose(f);
+			return EXIT_SUCCESS;
+		}
+#endif
+
 		if (file_offset > 0) {
 			r = fseek(f, file_offset, SEEK_SET);
 			if (r < 0) {
@@ -149,42 +1611,27 @@ main(int argc, char *argv[])
 		}
 	}
 
-	da_addr_t addr = mem_offset;
-
-	while (disasm_size < 0 || addr < mem_offset + disasm_size) {
-		da_word_t data;
-
-		if (!hex_input) {
-			size_t read = fread(&data, sizeof(da_word_t), 1, f);
-			if (read < 1) {
-				if (feof(f)) break;
-				else {
-					perror("fread");
-					exit(EXIT_FAILURE);
-				}
-			}
-		} else {
-			r = read_hex_input(&data, sizeof(da_word_t), f);
-			if (r < 0) {
-				fprintf(stderr, "Unable to parse input.\n");
-				exit(EXIT_FAILURE);
-			} else if (r == 0) {
-				break;
-			}
+	hex_input_t *hex = NULL;
+	if (hex_input) {
+		hex = hex_input_new(f, hex_layout);
+		if (hex == NULL) {
+			perror("hex_input_new");
+			exit(EXIT_FAILURE);
 		}
-		
-		da_instr_t instr;
-		da_instr_args_t args;
-		da_instr_parse(&instr, data, big_endian);
-		da_instr_parse_args(&args, &instr);
-
-		printf("%08x\t", addr);
-		printf("%08x\t", instr.data);
-		da_instr_fprint(stdout, &instr, &args, addr);
-		printf("\n");
+	}
 
-		addr += sizeof(da_word_t);
+	if (thumb) {
+		disasm_thumb_stream(f, hex, mem_offset, disasm_size,
+				    big_endian);
+	} else if (trace_code) {
+		disasm_trace_stream(f, hex, mem_offset, disasm_size,
+				    big_endian);
+	} else {
+		disasm_stream(f, hex, mem_offset, disasm_size, big_endian);
 	}
+	finish_output();
+
+	if (hex != NULL) hex_input_free(hex);
 
 	r = fclose(f);
 	if (r < 0) {
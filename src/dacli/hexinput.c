@@ -0,0 +1,556 @@
+/*
+ * hexinput.c - Hex text input
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "hexinput.h"
+
+#if defined(DA_SIMD) && defined(HAVE_EMMINTRIN_H) && defined(__SSE2__) && \
+	defined(__GNUC__)
+# define HEX_SIMD_SSE2  1
+# include <emmintrin.h>
+#endif
+
+
+/* Size of text buffer. Lines of the dump layouts must fit in it. */
+#define HEX_BUFFER_SIZE  65536
+
+
+struct hex_input {
+	FILE *f;
+	hex_layout_t layout;
+	int error;
+
+	/* Text read from f */
+	char text[HEX_BUFFER_SIZE];
+	size_t text_pos;
+	size_t text_len;
+	int eof;
+
+	/* Pending digit at the end of a run of hex digits, or -1 */
+	int nibble;
+
+	/* Decoded bytes not yet returned */
+	unsigned char out[HEX_BUFFER_SIZE];
+	size_t out_pos;
+	size_t out_len;
+
+	/* Number of bytes to return by repeating out, for "*" lines of od */
+	unsigned long long repeat;
+	size_t repeat_pos;
+
+	/* Last line of od, held until the address of the next line shows
+	   how much of it is valid and whether it repeats. */
+	unsigned char held[HEX_BUFFER_SIZE];
+	size_t held_len;
+	unsigned long long held_addr;
+	int held_repeat;
+};
+
+
+static const char *const hex_layout_map[] = {
+	"plain", "xxd", "od", "mdw"
+};
+
+
+/* Parse name of layout. Return -1 if unknown. */
+int
+hex_layout_parse(const char *name, hex_layout_t *layout)
+{
+	int i;
+	for (i = 0; i < HEX_LAYOUT_MAX; i++) {
+		if (!strcmp(name, hex_layout_map[i])) {
+			*layout = i;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+hex_input_t *
+hex_input_new(FILE *f, hex_layout_t layout)
+{
+	hex_input_t *in = malloc(sizeof(hex_input_t));
+	if (in == NULL) return NULL;
+
+	in->f = f;
+	in->layout = layout;
+	in->error = 0;
+	in->text_pos = 0;
+	in->text_len = 0;
+	in->eof = 0;
+	in->nibble = -1;
+	in->out_pos = 0;
+	in->out_len = 0;
+	in->repeat = 0;
+	in->repeat_pos = 0;
+	in->held_len = 0;
+	in->held_addr = 0;
+	in->held_repeat = 0;
+
+	return in;
+}
+
+void
+hex_input_free(hex_input_t *in)
+{
+	free(in);
+}
+
+int
+hex_input_error(const hex_input_t *in)
+{
+	return in->error;
+}
+
+
+static inline int
+hex_digit_value(int c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	else if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	else if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+/* Decode runs of hex digits separated by whitespace. Each pair of digits
+   in a run is a byte; an odd digit at the end of a run is a byte of its
+   own. Any other character is an error. */
+static unsigned char *
+hex_decode_scalar(hex_input_t *in, const char *p, const char *end,
+		  unsigned char *d)
+{
+	for (; p < end; p++) {
+		int value = hex_digit_value(*p);
+		if (value >= 0) {
+			if (in->nibble >= 0) {
+				*d++ = (in->nibble << 4) | value;
+				in->nibble = -1;
+			} else {
+				in->nibble = value;
+			}
+		} else if (isspace((unsigned char)*p)) {
+			if (in->nibble >= 0) {
+				*d++ = in->nibble;
+				in->nibble = -1;
+			}
+		} else {
+			in->error = 1;
+			break;
+		}
+	}
+
+	return d;
+}
+
+#ifdef HEX_SIMD_SSE2
+/* Decode 16 characters as hex_decode_scalar does. The characters are
+   classified and converted to digit values and digit pairs at once; only
+   the runs are walked one at a time. Return NULL if any character is
+   neither a hex digit nor whitespace. */
+static unsigned char *
+hex_decode_sse2(hex_input_t *in, const char *p, unsigned char *d)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+
+	__m128i digit = _mm_and_si128(
+		_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+		_mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	__m128i alpha = _mm_and_si128(
+		_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+		_mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+	__m128i space = _mm_or_si128(
+		_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+		_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+			      _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+
+	unsigned int digits = _mm_movemask_epi8(_mm_or_si128(digit, alpha));
+	unsigned int spaces = _mm_movemask_epi8(space);
+	if ((digits | spaces) != 0xffff) return NULL;
+
+	/* Digit values, and values of each digit paired with the next */
+	__m128i nib = _mm_or_si128(
+		_mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+		_mm_andnot_si128(digit,
+				 _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+	nib = _mm_and_si128(nib, _mm_set1_epi8(0xf));
+	__m128i pair = _mm_or_si128(_mm_slli_epi16(nib, 4),
+				    _mm_srli_si128(nib, 1));
+
+	unsigned char nibs[16];
+	unsigned char pairs[16];
+	_mm_storeu_si128((__m128i *)nibs, nib);
+	_mm_storeu_si128((__m128i *)pairs, pair);
+
+	unsigned int i = 0;
+	while (i < 16) {
+		unsigned int rest = digits >> i;
+
+		if (!(rest & 1)) {
+			/* Whitespace ends a run */
+			if (in->nibble >= 0) {
+				*d++ = in->nibble;
+				in->nibble = -1;
+			}
+			i += __builtin_ctz(rest | (1 << (16 - i)));
+			continue;
+		}
+
+		unsigned int n = __builtin_ctz(~rest);
+		if (in->nibble >= 0) {
+			*d++ = (in->nibble << 4) | nibs[i];
+			in->nibble = -1;
+			i += 1;
+			n -= 1;
+		}
+		while (n >= 2) {
+			*d++ = pairs[i];
+			i += 2;
+			n -= 2;
+		}
+		if (n > 0) {
+			in->nibble = nibs[i];
+			i += 1;
+		}
+	}
+
+	return d;
+}
+#endif
+
+static unsigned char *
+hex_decode(hex_input_t *in, const char *p, const char *end, unsigned char *d)
+{
+#ifdef HEX_SIMD_SSE2
+	while (end - p >= 16) {
+		unsigned char *next = hex_decode_sse2(in, p, d);
+		if (next == NULL) break;
+		d = next;
+		p += 16;
+	}
+#endif
+	return hex_decode_scalar(in, p, end, d);
+}
+
+/* End the current run of digits. */
+static unsigned char *
+hex_decode_end(hex_input_t *in, unsigned char *d)
+{
+	if (in->nibble >= 0) {
+		*d++ = in->nibble;
+		in->nibble = -1;
+	}
+	return d;
+}
+
+/* Decode whitespace separated values of up to 2*unit hex digits, stored
+   as little endian units. Return NULL on error. */
+static unsigned char *
+hex_decode_units(const char *p, const char *end, size_t unit,
+		 unsigned char *d)
+{
+	while (1) {
+		while (p < end && isspace((unsigned char)*p)) p++;
+		if (p == end) break;
+
+		unsigned long value = 0;
+		size_t n = 0;
+		while (p < end && !isspace((unsigned char)*p)) {
+			int digit = hex_digit_value(*p++);
+			if (digit < 0 || ++n > 2*unit) return NULL;
+			value = (value << 4) | digit;
+		}
+
+		size_t i;
+		for (i = 0; i < unit; i++) {
+			*d++ = value & 0xff;
+			value >>= 8;
+		}
+	}
+
+	return d;
+}
+
+/* Parse address at the start of a line. Return the position after it, or
+   NULL if there is none. */
+static const char *
+hex_parse_addr(const char *p, const char *end, int base,
+	       unsigned long long *addr)
+{
+	while (p < end && isspace((unsigned char)*p)) p++;
+
+	if (base == 16 && end - p > 2 && p[0] == '0' &&
+	    (p[1] == 'x' || p[1] == 'X')) {
+		p += 2;
+	}
+
+	const char *start = p;
+	*addr = 0;
+	while (p < end) {
+		int digit = hex_digit_value(*p);
+		if (digit < 0 || digit >= base) break;
+		*addr = *addr * base + digit;
+		p++;
+	}
+
+	return (p > start ? p : NULL);
+}
+
+
+/* Read more text, keeping the text not yet consumed. */
+static void
+hex_read_text(hex_input_t *in)
+{
+	if (in->text_pos > 0) {
+		memmove(in->text, in->text + in->text_pos,
+			in->text_len - in->text_pos);
+		in->text_len -= in->text_pos;
+		in->text_pos = 0;
+	}
+
+	in->text_len += fread(in->text + in->text_len, 1,
+			      HEX_BUFFER_SIZE - in->text_len, in->f);
+	if (ferror(in->f)) {
+		perror("fread");
+		in->error = 1;
+	}
+	if (feof(in->f)) in->eof = 1;
+}
+
+/* Return the next line of text without line terminator, or NULL at end of
+   input. */
+static const char *
+hex_next_line(hex_input_t *in, size_t *len)
+{
+	const char *line;
+	const char *nl;
+
+	while (1) {
+		line = in->text + in->text_pos;
+		nl = memchr(line, '\n', in->text_len - in->text_pos);
+		if (nl != NULL || in->eof || in->error) break;
+
+		if (in->text_pos == 0 && in->text_len == HEX_BUFFER_SIZE) {
+			/* Line too long */
+			in->error = 1;
+			return NULL;
+		}
+		hex_read_text(in);
+	}
+
+	if (nl != NULL) {
+		in->text_pos = nl + 1 - in->text;
+	} else if (in->text_pos < in->text_len && !in->error) {
+		nl = in->text + in->text_len;
+		in->text_pos = in->text_len;
+	} else {
+		return NULL;
+	}
+
+	*len = nl - line;
+	if (*len > 0 && line[*len - 1] == '\r') *len -= 1;
+	return line;
+}
+
+/* Decode a line of xxd output: "ADDR: HEX  ASCII". */
+static int
+hex_decode_xxd(hex_input_t *in, const char *p, const char *end)
+{
+	unsigned long long addr;
+	p = hex_parse_addr(p, end, 16, &addr);
+	if (p == NULL || p == end || *p != ':') return -1;
+	p += 1;
+
+	/* The ASCII column starts after two spaces */
+	const char *data_end = p;
+	while (data_end < end &&
+	       !(data_end[0] == ' ' && data_end + 1 < end &&
+		 data_end[1] == ' ')) {
+		data_end++;
+	}
+
+	unsigned char *d = hex_decode(in, p, data_end, in->out);
+	d = hex_decode_end(in, d);
+	in->out_len = d - in->out;
+	return (in->error ? -1 : 0);
+}
+
+/* Decode a line of od -x output: "ADDR UNIT...", with ADDR in octal, or
+   "*" if lines are repeated up to the address of the next line. */
+static int
+hex_decode_od(hex_input_t *in, const char *p, const char *end)
+{
+	while (p < end && isspace((unsigned char)*p)) p++;
+
+	if (p < end && *p == '*') {
+		if (in->held_len == 0) return -1;
+		in->held_repeat = 1;
+		return 0;
+	}
+
+	unsigned long long addr;
+	p = hex_parse_addr(p, end, 8, &addr);
+	if (p == NULL || (p < end && !isspace((unsigned char)*p))) return -1;
+
+	/* Return the held line, up to the address of this line */
+	if (in->held_len > 0) {
+		if (addr < in->held_addr) return -1;
+
+		unsigned long long span = addr - in->held_addr;
+		size_t n = (span < in->held_len ? span : in->held_len);
+		memcpy(in->out, in->held, n);
+		in->out_len = n;
+
+		if (in->held_repeat && span > in->held_len) {
+			in->repeat = span - in->held_len;
+			in->repeat_pos = 0;
+		}
+	}
+
+	unsigned char *d = hex_decode_units(p, end, 2, in->held);
+	if (d == NULL) return -1;
+
+	in->held_len = d - in->held;
+	in->held_addr = addr;
+	in->held_repeat = 0;
+	return 0;
+}
+
+/* Decode a line of OpenOCD mdw output: "0xADDR: WORD...". */
+static int
+hex_decode_mdw(hex_input_t *in, const char *p, const char *end)
+{
+	unsigned long long addr;
+	p = hex_parse_addr(p, end, 16, &addr);
+	if (p == NULL || p == end || *p != ':') return -1;
+
+	unsigned char *d = hex_decode_units(p + 1, end, 4, in->out);
+	if (d == NULL) return -1;
+
+	in->out_len = d - in->out;
+	return 0;
+}
+
+/* Decode more input into out. Return 0 at end of input or on error. */
+static int
+hex_decode_next(hex_input_t *in)
+{
+	in->out_pos = 0;
+	in->out_len = 0;
+
+	if (in->error) return 0;
+
+	if (in->layout == HEX_LAYOUT_PLAIN) {
+		if (in->eof) return 0;
+
+		hex_read_text(in);
+		unsigned char *d = hex_decode(in, in->text + in->text_pos,
+					      in->text + in->text_len,
+					      in->out);
+		in->text_pos = in->text_len;
+		if (in->eof) d = hex_decode_end(in, d);
+
+		in->out_len = d - in->out;
+		return 1;
+	}
+
+	size_t len;
+	const char *line = hex_next_line(in, &len);
+	if (line == NULL) {
+		/* The last line of od is valid in full */
+		if (in->held_len > 0 && !in->error) {
+			memcpy(in->out, in->held, in->held_len);
+			in->out_len = in->held_len;
+			in->held_len = 0;
+			return 1;
+		}
+		return 0;
+	}
+
+	const char *end = line + len;
+	int r = 0;
+	switch (in->layout) {
+	case HEX_LAYOUT_XXD:
+		if (len > 0) r = hex_decode_xxd(in, line, end);
+		break;
+	case HEX_LAYOUT_OD:
+		if (len > 0) r = hex_decode_od(in, line, end);
+		break;
+	case HEX_LAYOUT_MDW:
+		if (len > 0) r = hex_decode_mdw(in, line, end);
+		break;
+	default:
+		r = -1;
+		break;
+	}
+
+	if (r < 0) {
+		in->error = 1;
+		in->out_len = 0;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Read up to size bytes of decoded input to dest. Return the number of
+   bytes read, which is less than size only at end of input or on
+   error. */
+size_t
+hex_input_read(hex_input_t *in, void *dest, size_t size)
+{
+	unsigned char *d = dest;
+	size_t done = 0;
+
+	while (done < size) {
+		size_t n;
+
+		if (in->out_pos < in->out_len) {
+			n = in->out_len - in->out_pos;
+			if (n > size - done) n = size - done;
+			memcpy(d + done, in->out + in->out_pos, n);
+			in->out_pos += n;
+		} else if (in->repeat > 0) {
+			n = in->out_len - in->repeat_pos;
+			if (n > in->repeat) n = in->repeat;
+			if (n > size - done) n = size - done;
+			memcpy(d + done, in->out + in->repeat_pos, n);
+			in->repeat_pos = (in->repeat_pos + n) % in->out_len;
+			in->repeat -= n;
+		} else if (hex_decode_next(in)) {
+			continue;
+		} else {
+			break;
+		}
+
+		done += n;
+	}
+
+	return done;
+}
@@ -0,0 +1,49 @@
+/*
+ * hexinput.h - Hex text input header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _DACLI_HEXINPUT_H
+#define _DACLI_HEXINPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+/* Layout of hex text */
+typedef enum {
+	HEX_LAYOUT_PLAIN = 0,	/* Hex bytes separated by whitespace */
+	HEX_LAYOUT_XXD,		/* xxd output */
+	HEX_LAYOUT_OD,		/* od -x output */
+	HEX_LAYOUT_MDW,		/* OpenOCD mdw output */
+	HEX_LAYOUT_MAX
+} hex_layout_t;
+
+typedef struct hex_input hex_input_t;
+
+
+int hex_layout_parse(const char *name, hex_layout_t *layout);
+
+hex_input_t *hex_input_new(FILE *f, hex_layout_t layout);
+void hex_input_free(hex_input_t *in);
+
+size_t hex_input_read(hex_input_t *in, void *dest, size_t size);
+int hex_input_error(const hex_input_t *in);
+
+
+#endif /* ! _DACLI_HEXINPUT_H */
@@ -0,0 +1,844 @@
+/*
+ * daverify.c - Exhaustive decoder verification
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include <libdisarm/disarm.h>
+
+/* Private header: the decode tree is the reference classifier */
+#include <libdisarm/group.h>
+
+#include "refprint.h"
+
+
+#define USAGE \
+	"Usage: %s [-h] [-c CHECKS] [-j JOBS] [-m MAX] [-r START-END]\n"
+#define HELP \
+	USAGE \
+	" Compare the decoder with the reference for every instruction word.\n" \
+	"  -c CHECKS\tComma separated checks to run (default group,args):\n" \
+	"\t\tgroup  lookup table and SIMD classifiers against the\n" \
+	"\t\t       decode tree\n" \
+	"\t\targs   packed format, field accessors and decode cache\n" \
+	"\t\t       against da_instr_parse_args\n" \
+	"\t\tprint  da_instr_snprint and the text cache against the\n" \
+	"\t\t       reference printer\n" \
+	"\t\tpage   page cache entries, written, read back and\n" \
+	"\t\t       corrupted, against da_instr_snprint\n" \
+	"  -h\t\tDisplay this help message\n" \
+	"  -j JOBS\tVerify on JOBS threads (default: all processors)\n" \
+	"  -m MAX\tReport at most MAX mismatches of each check (default 10)\n" \
+	"  -r START-END\tOnly verify words START to END (END is exclusive)\n" \
+	"Report bugs to <" PACKAGE_BUGREPORT ">.\n"
+
+/* Number of words verified by a thread at a time */
+#define CHUNK_SIZE  4096
+
+/* Number of chunks taken from the work counter at a time */
+#define CHUNKS_PER_TAKE  256
+
+/* Size of text buffers */
+#define TEXT_SIZE  256
+
+/* Size of the page caches, room for one entry */
+#define PAGE_CACHE_SIZE  (1 << 20)
+
+
+/* Checks */
+typedef enum {
+	CHECK_GROUP = 0,
+	CHECK_ARGS,
+	CHECK_PRINT,
+	CHECK_PAGE,
+	CHECK_MAX
+} check_t;
+
+static const char *check_names[CHECK_MAX] = {
+	"group", "args", "print", "page"
+};
+
+static int checks[CHECK_MAX] = { 1, 1, 0, 0 };
+static unsigned long max_report = 10;
+
+
+/* Verification state shared by the threads */
+static unsigned long long range_start = 0;
+static unsigned long long range_end = 1ULL << 32;
+static unsigned long long next_word;
+static unsigned long long mismatches[CHECK_MAX];
+static unsigned long long words_done;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK()  pthread_mutex_lock(&state_lock)
+# define UNLOCK()  pthread_mutex_unlock(&state_lock)
+#else
+# define LOCK()
+# define UNLOCK()
+#endif
+
+
+/* Record a mismatch, printing the first max_report of each check. */
+static void
+report(check_t check, da_word_t w, const char *what, const char *expected,
+       const char *actual)
+{
+	LOCK();
+	if (mismatches[check]++ < max_report) {
+		printf("%s: %08x: %s: expected %s, got %s\n",
+		       check_names[check], w, what, expected, actual);
+		fflush(stdout);
+	}
+	UNLOCK();
+}
+
+static void
+report_uint(check_t check, da_word_t w, const char *what, long long expected,
+	    long long actual)
+{
+	char e[32], a[32];
+	snprintf(e, sizeof(e), "%lld", expected);
+	snprintf(a, sizeof(a), "%lld", actual);
+	report(check, w, what, e, a);
+}
+
+/* Take the next range of words to verify. Return 0 when done. */
+static int
+take_work(unsigned long long *start, unsigned long long *end)
+{
+	int r = 0;
+
+	LOCK();
+	if (next_word < range_end) {
+		*start = next_word;
+		next_word += (unsigned long long)CHUNK_SIZE * CHUNKS_PER_TAKE;
+		if (next_word > range_end) next_word = range_end;
+		*end = next_word;
+		r = 1;
+	}
+	UNLOCK();
+
+	return r;
+}
+
+
+/* Fields the accessors of access.h return for an instruction */
+typedef struct {
+	da_uint_t rd, rn, rm, rs;
+	int32_t imm;
+	da_uint_t reglist;
+	int load, store, flags;
+} fields_t;
+
+/* Read the fields from arguments parsed by da_instr_parse_args. */
+static void
+fields_from_args(fields_t *f, da_group_t group, const da_instr_args_t *a)
+{
+	f->rd = f->rn = f->rm = f->rs = DA_FIELD_NONE;
+	f->imm = 0;
+	f->reglist = 0;
+	f->load = f->store = f->flags = 0;
+
+	switch (group) {
+	case DA_GROUP_BKPT:
+		f->imm = a->bkpt.imm;
+		break;
+	case DA_GROUP_BL:
+		f->imm = a->bl.off;
+		break;
+	case DA_GROUP_BLX_IMM:
+		f->imm = a->blx_imm.off;
+		break;
+	case DA_GROUP_BLX_REG:
+		f->rm = a->blx_reg.rm;
+		break;
+	case DA_GROUP_CLZ:
+		f->rd = a->clz.rd;
+		f->rm = a->clz.rm;
+		break;
+	case DA_GROUP_CP_DATA:
+		break;
+	case DA_GROUP_CP_LS:
+		f->rn = a->cp_ls.rn;
+		f->imm = a->cp_ls.imm;
+		f->load = a->cp_ls.load;
+		f->store = !a->cp_ls.load;
+		break;
+	case DA_GROUP_CP_REG:
+		f->rd = a->cp_reg.rd;
+		f->load = a->cp_reg.load;
+		f->store = !a->cp_reg.load;
+		break;
+	case DA_GROUP_DATA_IMM:
+		f->rd = a->data_imm.rd;
+		f->rn = a->data_imm.rn;
+		f->imm = a->data_imm.imm;
+		f->flags = a->data_imm.flags;
+		break;
+	case DA_GROUP_DATA_IMM_SH:
+		f->rd = a->data_imm_sh.rd;
+		f->rn = a->data_imm_sh.rn;
+		f->rm = a->data_imm_sh.rm;
+		f->flags = a->data_imm_sh.flags;
+		break;
+	case DA_GROUP_DATA_REG_SH:
+		f->rd = a->data_reg_sh.rd;
+		f->rn = a->data_reg_sh.rn;
+		f->rm = a->data_reg_sh.rm;
+		f->rs = a->data_reg_sh.rs;
+		f->flags = a->data_reg_sh.flags;
+		break;
+	case DA_GROUP_DSP_ADD_SUB:
+		f->rd = a->dsp_add_sub.rd;
+		f->rn = a->dsp_add_sub.rn;
+		f->rm = a->dsp_add_sub.rm;
+		break;
+	case DA_GROUP_DSP_MUL:
+		f->rd = a->dsp_mul.rd;
+		f->rn = a->dsp_mul.rn;
+		f->rm = a->dsp_mul.rm;
+		f->rs = a->dsp_mul.rs;
+		break;
+	case DA_GROUP_L_SIGN_IMM:
+		f->rd = a->l_sign_imm.rd;
+		f->rn = a->l_sign_imm.rn;
+		f->imm = a->l_sign_imm.off;
+		f->load = 1;
+		break;
+	case DA_GROUP_L_SIGN_REG:
+		f->rd = a->l_sign_reg.rd;
+		f->rn = a->l_sign_reg.rn;
+		f->rm = a->l_sign_reg.rm;
+		f->load = 1;
+		break;
+	case DA_GROUP_LS_HW_IMM:
+		f->rd = a->ls_hw_imm.rd;
+		f->rn = a->ls_hw_imm.rn;
+		f->imm = a->ls_hw_imm.off;
+		f->load = a->ls_hw_imm.load;
+		f->store = !a->ls_hw_imm.load;
+		break;
+	case DA_GROUP_LS_HW_REG:
+		f->rd = a->ls_hw_reg.rd;
+		f->rn = a->ls_hw_reg.rn;
+		f->rm = a->ls_hw_reg.rm;
+		f->load = a->ls_hw_reg.load;
+		f->store = !a->ls_hw_reg.load;
+		break;
+	case DA_GROUP_LS_IMM:
+		f->rd = a->ls_imm.rd;
+		f->rn = a->ls_imm.rn;
+		f->imm = a->ls_imm.off;
+		f->load = a->ls_imm.load;
+		f->store = !a->ls_imm.load;
+		break;
+	case DA_GROUP_LS_MULTI:
+		f->rn = a->ls_multi.rn;
+		f->reglist = a->ls_multi.reglist;
+		f->load = a->ls_multi.load;
+		f->store = !a->ls_multi.load;
+		break;
+	case DA_GROUP_LS_REG:
+		f->rd = a->ls_reg.rd;
+		f->rn = a->ls_reg.rn;
+		f->rm = a->ls_reg.rm;
+		f->load = a->ls_reg.load;
+		f->store = !a->ls_reg.load;
+		break;
+	case DA_GROUP_LS_TWO_IMM:
+		f->rd = a->ls_two_imm.rd;
+		f->rn = a->ls_two_imm.rn;
+		f->imm = a->ls_two_imm.off;
+		f->load = !a->ls_two_imm.store;
+		f->store = a->ls_two_imm.store;
+		break;
+	case DA_GROUP_LS_TWO_REG:
+		f->rd = a->ls_two_reg.rd;
+		f->rn = a->ls_two_reg.rn;
+		f->rm = a->ls_two_reg.rm;
+		f->load = !a->ls_two_reg.store;
+		f->store = a->ls_two_reg.store;
+		break;
+	case DA_GROUP_MRS:
+		f->rd = a->mrs.rd;
+		break;
+	case DA_GROUP_MSR:
+		f->rm = a->msr.rm;
+		break;
+	case DA_GROUP_MSR_IMM:
+		f->imm = a->msr_imm.imm;
+		break;
+	case DA_GROUP_MUL:
+		f->rd = a->mul.rd;
+		f->rn = a->mul.rn;
+		f->rm = a->mul.rm;
+		f->rs = a->mul.rs;
+		f->flags = a->mul.flags;
+		break;
+	case DA_GROUP_MULL:
+		f->rd = a->mull.rd_lo;
+		f->rn = a->mull.rd_hi;
+		f->rm = a->mull.rm;
+		f->rs = a->mull.rs;
+		f->flags = a->mull.flags;
+		break;
+	case DA_GROUP_SWI:
+		f->imm = a->swi.imm;
+		break;
+	case DA_GROUP_SWP:
+		f->rd = a->swp.rd;
+		f->rn = a->swp.rn;
+		f->rm = a->swp.rm;
+		f->load = 1;
+		f->store = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Read the fields with the accessors. */
+static void
+fields_from_accessors(fields_t *f, const da_instr_t *instr)
+{
+	f->rd = da_instr_rd(instr);
+	f->rn = da_instr_rn(instr);
+	f->rm = da_instr_rm(instr);
+	f->rs = da_instr_rs(instr);
+	f->imm = da_instr_imm(instr);
+	f->reglist = da_instr_reglist(instr);
+	f->load = da_instr_is_load(instr);
+	f->store = da_instr_is_store(instr);
+	f->flags = da_instr_sets_flags(instr);
+}
+
+#define CHECK_FIELD(w,e,a,name)  \
+	if ((e)->name != (a)->name) {  \
+		report_uint(CHECK_ARGS, w, "accessor " #name,  \
+			    (e)->name, (a)->name);  \
+	}
+
+
+/* Per thread buffers */
+typedef struct {
+	da_word_t raw[CHUNK_SIZE];
+	da_instr_t instrs[CHUNK_SIZE];
+	da_instr_packed_t packed[CHUNK_SIZE];
+	FILE *text;
+	char ref_text[TEXT_SIZE];
+	char text_buf[TEXT_SIZE];
+	da_text_cache_t cache;
+	da_decode_cache_t decode_cache;
+	char page_dir[64];
+	da_page_cache_t page_cache;
+	da_page_t page;
+} worker_t;
+
+/* Compare the text of the count words from start, little endian in
+   raw, in the page of the worker with da_instr_snprint. */
+static void
+verify_page_text(worker_t *wk, const da_word_t *raw, da_word_t start,
+		 size_t count, const char *what)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_word_t w = start + i;
+		da_addr_t addr = w << 2;
+		da_instr_t instr;
+		da_instr_args_t args;
+		char expected[TEXT_SIZE];
+
+		da_instr_parse(&instr, raw[i], 0);
+		da_instr_parse_args(&args, &instr);
+		da_instr_snprint(expected, TEXT_SIZE, &instr, &args, addr);
+
+		size_t len;
+		const char *text = da_page_text(&wk->page, i, &len);
+		if (len >= TEXT_SIZE) {
+			report_uint(CHECK_PAGE, w, what, strlen(expected),
+				    len);
+			continue;
+		}
+
+		da_instr_rel_t rel;
+		memcpy(wk->text_buf, text, len);
+		da_page_rel(&wk->page, i, &rel);
+		da_instr_snprint_rel_addr(wk->text_buf + len, TEXT_SIZE - len,
+					  &rel, addr);
+		if (strcmp(expected, wk->text_buf)) {
+			report(CHECK_PAGE, w, what, expected, wk->text_buf);
+		}
+	}
+}
+
+/* Break the text offsets of the only entry in the page cache of the
+   worker in one of the ways da_page_load must catch, chosen by kind.
+   Return -1 if there is no entry. */
+static int
+corrupt_page_entry(worker_t *wk, size_t count, int kind)
+{
+	char path[sizeof(wk->page_dir) + 256];
+	DIR *dir = opendir(wk->page_dir);
+	if (dir == NULL) return -1;
+
+	int found = 0;
+	struct dirent *ent;
+	while (!found && (ent = readdir(dir)) != NULL) {
+		if (ent->d_name[0] == '.') continue;
+		snprintf(path, sizeof(path), "%s/%s", wk->page_dir,
+			 ent->d_name);
+		found = 1;
+	}
+	closedir(dir);
+	if (!found) return -1;
+
+	int fd = open(path, O_RDWR);
+	if (fd < 0) return -1;
+
+	/* The offsets follow the five word header and the words */
+	off_t pos = (5 + count) * sizeof(uint32_t);
+	uint32_t off[3];
+	if (count < 2) kind = 0;
+	if (pread(fd, off, sizeof(off), pos) != sizeof(off)) {
+		close(fd);
+		return -1;
+	}
+
+	switch (kind) {
+	case 0:
+		/* Text does not start at the beginning */
+		off[0] = 1;
+		break;
+	case 1:
+		/* Text of the first word is longer than any instruction */
+		off[1] = off[0] + TEXT_SIZE;
+		break;
+	default:
+		/* Offsets decrease */
+		off[2] = off[1] - 1;
+		break;
+	}
+
+	int r = (pwrite(fd, off, sizeof(off), pos) == sizeof(off) ? 0 : -1);
+	close(fd);
+	return r;
+}
+
+/* Render the page of count words from start, little endian in raw,
+   through the page cache: a miss, a hit and a miss after the entry is
+   corrupted. */
+static void
+verify_page(worker_t *wk, const da_word_t *raw, da_word_t start,
+	    size_t count)
+{
+	static const char *const what[] = {
+		"da_page_cache_render miss", "da_page_cache_render hit",
+		"da_page_cache_render corrupt entry"
+	};
+	int k;
+
+	for (k = 0; k < 3; k++) {
+		if (k == 2 && corrupt_page_entry(wk, count,
+						 (start / count) % 3) < 0) {
+			report(CHECK_PAGE, start, what[k], "entry",
+			       "no entry");
+			break;
+		}
+
+		int r = da_page_cache_render(&wk->page_cache, &wk->page,
+					     raw, count, 0);
+		if (r != (k == 1)) report_uint(CHECK_PAGE, start, what[k],
+					       (k == 1), r);
+		if (r < 0) break;
+		verify_page_text(wk, raw, start, count, what[k]);
+	}
+
+	/* Remove the entry for the next page */
+	wk->page_cache.max_size = 0;
+	da_page_cache_evict(&wk->page_cache);
+	wk->page_cache.max_size = PAGE_CACHE_SIZE;
+}
+
+/* Verify count words from start. */
+static void
+verify_chunk(worker_t *wk, da_word_t start, size_t count)
+{
+	size_t i;
+
+	/* Block functions take little endian words */
+	for (i = 0; i < count; i++) {
+		da_word_t w = start + i;
+		unsigned char bytes[4] = { w, w >> 8, w >> 16, w >> 24 };
+		memcpy(&wk->raw[i], bytes, sizeof(bytes));
+	}
+
+	if (checks[CHECK_GROUP] || checks[CHECK_ARGS]) {
+		da_instr_parse_block(wk->instrs, wk->raw, count, 0);
+	}
+	if (checks[CHECK_ARGS]) {
+		da_instr_parse_packed_block(wk->packed, wk->raw, count, 0);
+	}
+
+	for (i = 0; i < count; i++) {
+		da_word_t w = start + i;
+		da_instr_t ref, instr;
+		da_instr_args_t ref_args;
+
+		ref.data = w;
+		ref.group = da_parse_group_tree(w);
+
+		if (checks[CHECK_GROUP]) {
+			da_instr_parse(&instr, wk->raw[i], 0);
+			if (instr.data != w || instr.group != ref.group) {
+				report_uint(CHECK_GROUP, w, "da_instr_parse",
+					    ref.group, instr.group);
+			}
+			if (wk->instrs[i].data != w ||
+			    wk->instrs[i].group != ref.group) {
+				report_uint(CHECK_GROUP, w,
+					    "da_instr_parse_block",
+					    ref.group, wk->instrs[i].group);
+			}
+		}
+
+		if (!checks[CHECK_ARGS] && !checks[CHECK_PRINT]) continue;
+
+		memset(&ref_args, 0, sizeof(ref_args));
+		da_instr_parse_args(&ref_args, &ref);
+
+		if (checks[CHECK_ARGS]) {
+			da_instr_packed_t packed;
+			da_instr_args_t args;
+			fields_t e, a;
+
+			da_instr_pack(&packed, &ref, &ref_args);
+			if (memcmp(&packed, &wk->packed[i], sizeof(packed))) {
+				report(CHECK_ARGS, w,
+				       "da_instr_parse_packed_block",
+				       "da_instr_pack", "other fields");
+			}
+
+			memset(&args, 0, sizeof(args));
+			da_instr_unpack_args(&args, &packed);
+			if (memcmp(&args, &ref_args, sizeof(args))) {
+				report(CHECK_ARGS, w, "da_instr_unpack_args",
+				       "da_instr_parse_args", "other fields");
+			}
+
+			/* Decode a miss and then a hit through the cache */
+			int k;
+			for (k = 0; k < 2; k++) {
+				da_instr_t cached;
+				memset(&args, 0, sizeof(args));
+				da_decode_cache_parse(&wk->decode_cache, &cached,
+						      &args, wk->raw[i], 0);
+				if (cached.data != w ||
+				    cached.group != ref.group ||
+				    memcmp(&args, &ref_args, sizeof(args))) {
+					report(CHECK_ARGS, w,
+					       "da_decode_cache_parse",
+					       "da_instr_parse_args",
+					       "other fields");
+				}
+			}
+
+			fields_from_args(&e, ref.group, &ref_args);
+			fields_from_accessors(&a, &ref);
+			CHECK_FIELD(w, &e, &a, rd);
+			CHECK_FIELD(w, &e, &a, rn);
+			CHECK_FIELD(w, &e, &a, rm);
+			CHECK_FIELD(w, &e, &a, rs);
+			CHECK_FIELD(w, &e, &a, imm);
+			CHECK_FIELD(w, &e, &a, reglist);
+			CHECK_FIELD(w, &e, &a, load);
+			CHECK_FIELD(w, &e, &a, store);
+			CHECK_FIELD(w, &e, &a, flags);
+		}
+
+		if (checks[CHECK_PRINT]) {
+			da_addr_t addr = w << 2;
+			long len;
+
+			rewind(wk->text);
+			ref_instr_fprint(wk->text, &ref, &ref_args, addr);
+			fflush(wk->text);
+			len = ftell(wk->text);
+			if (len < 0 || len >= TEXT_SIZE) len = TEXT_SIZE - 1;
+			wk->ref_text[len] = '\0';
+
+			da_instr_snprint(wk->text_buf, TEXT_SIZE, &ref,
+					 &ref_args, addr);
+			if (strcmp(wk->ref_text, wk->text_buf)) {
+				report(CHECK_PRINT, w, "da_instr_snprint",
+				       wk->ref_text, wk->text_buf);
+			}
+
+			/* Print a miss and then a hit through the cache */
+			int k;
+			for (k = 0; k < 2; k++) {
+				da_text_cache_snprint(&wk->cache, wk->text_buf,
+						      TEXT_SIZE, &ref, NULL,
+						      addr);
+				if (strcmp(wk->ref_text, wk->text_buf)) {
+					report(CHECK_PRINT, w,
+					       "da_text_cache_snprint",
+					       wk->ref_text, wk->text_buf);
+				}
+			}
+		}
+	}
+
+	if (checks[CHECK_PAGE]) {
+		for (i = 0; i < count; i += DA_PAGE_CACHE_WORDS) {
+			size_t n = (count - i < DA_PAGE_CACHE_WORDS ?
+				    count - i : DA_PAGE_CACHE_WORDS);
+			verify_page(wk, wk->raw + i, start + i, n);
+		}
+	}
+}
+
+static void *
+verify_thread(void *arg)
+{
+	worker_t *wk = malloc(sizeof(worker_t));
+	unsigned long long start, end;
+
+	if (wk == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	if (da_text_cache_init(&wk->cache, CHUNK_SIZE) < 0 ||
+	    da_decode_cache_init(&wk->decode_cache, CHUNK_SIZE,
+				 DA_DECODE_CACHE_LRU2) < 0) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	wk->text = fmemopen(wk->ref_text, TEXT_SIZE, "w");
+	if (wk->text == NULL) {
+		perror("fmemopen");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Each thread has a cache in a directory of its own */
+	if (checks[CHECK_PAGE]) {
+		const char *tmp = getenv("TMPDIR");
+		if (tmp == NULL || strlen(tmp) > 32) tmp = "/tmp";
+		snprintf(wk->page_dir, sizeof(wk->page_dir),
+			 "%s/daverify-XXXXXX", tmp);
+		if (mkdtemp(wk->page_dir) == NULL ||
+		    da_page_cache_open(&wk->page_cache, wk->page_dir,
+				       PAGE_CACHE_SIZE) < 0) {
+			perror(wk->page_dir);
+			exit(EXIT_FAILURE);
+		}
+		da_page_init(&wk->page);
+	}
+
+	while (take_work(&start, &end)) {
+		unsigned long long w;
+		for (w = start; w < end; w += CHUNK_SIZE) {
+			size_t n = (end - w < CHUNK_SIZE) ? end - w : CHUNK_SIZE;
+			verify_chunk(wk, (da_word_t)w, n);
+		}
+
+		LOCK();
+		words_done += end - start;
+		if (isatty(STDERR_FILENO)) {
+			fprintf(stderr, "\r%3.0f%%",
+				100.0 * words_done / (range_end - range_start));
+		}
+		UNLOCK();
+	}
+
+	if (checks[CHECK_PAGE]) {
+		da_page_free(&wk->page);
+		da_page_cache_close(&wk->page_cache);
+		rmdir(wk->page_dir);
+	}
+
+	fclose(wk->text);
+	da_text_cache_free(&wk->cache);
+	da_decode_cache_free(&wk->decode_cache);
+	free(wk);
+	return NULL;
+}
+
+
+/* Parse comma separated list of checks. Return -1 on error. */
+static int
+parse_checks(const char *list)
+{
+	int enabled[CHECK_MAX] = { 0 };
+	int c;
+
+	while (*list != '\0') {
+		size_t len = strcspn(list, ",");
+		for (c = 0; c < CHECK_MAX; c++) {
+			if (strlen(check_names[c]) == len &&
+			    !strncmp(list, check_names[c], len)) break;
+		}
+		if (c == CHECK_MAX) return -1;
+
+		enabled[c] = 1;
+		list += len;
+		if (*list == ',') list++;
+	}
+
+	memcpy(checks, enabled, sizeof(checks));
+	return 0;
+}
+
+/* Parse START-END range of words. Return -1 on error. */
+static int
+parse_range(const char *s)
+{
+	unsigned long long start, end;
+	char *p;
+
+	errno = 0;
+	start = strtoull(s, &p, 0);
+	if (errno != 0 || p == s || *p != '-') return -1;
+
+	s = p + 1;
+	end = strtoull(s, &p, 0);
+	if (errno != 0 || p == s || *p != '\0') return -1;
+	if (start >= end || end > (1ULL << 32)) return -1;
+
+	range_start = start;
+	range_end = end;
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int r;
+	int c;
+
+	int thread_count = 1;
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+	thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (thread_count < 1) thread_count = 1;
+#endif
+
+	int opt;
+	while ((opt = getopt(argc, argv, "c:hj:m:r:")) != -1) {
+		switch (opt) {
+		case 'c':
+			r = parse_checks(optarg);
+			if (r < 0) {
+				fprintf(stderr, "Unknown check in: %s\n",
+					optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'h':
+			printf(HELP, argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+		case 'j':
+			thread_count = atoi(optarg);
+			if (thread_count < 1) {
+				fprintf(stderr, USAGE, argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'm':
+			max_report = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			r = parse_range(optarg);
+			if (r < 0) {
+				fprintf(stderr, "Invalid range: %s\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			fprintf(stderr, USAGE, argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	next_word = range_start;
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+#ifdef HAVE_PTHREAD
+	pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
+	if (threads == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+
+	int i;
+	for (i = 0; i < thread_count; i++) {
+		r = pthread_create(&threads[i], NULL, verify_thread, NULL);
+		if (r != 0) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(r));
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < thread_count; i++) pthread_join(threads[i], NULL);
+	free(threads);
+#else
+	if (thread_count > 1) {
+		fprintf(stderr, "Threads are not supported;"
+			" verifying on one thread.\n");
+	}
+	thread_count = 1;
+	verify_thread(NULL);
+#endif
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double seconds = (t1.tv_sec - t0.tv_sec) +
+		(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	if (isatty(STDERR_FILENO)) fprintf(stderr, "\r");
+
+	unsigned long long total = 0;
+	printf("Verified %llu words on %d threads in %.1f s"
+	       " (%.1f Mwords/s)\n", range_end - range_start, thread_count,
+	       seconds, (range_end - range_start) / seconds / 1e6);
+	for (c = 0; c < CHECK_MAX; c++) {
+		if (!checks[c]) continue;
+		printf("  %-6s %llu mismatches\n", check_names[c],
+		       mismatches[c]);
+		total += mismatches[c];
+	}
+
+	return total > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
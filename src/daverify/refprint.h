@@ -0,0 +1,34 @@
+/*
+ * refprint.h - Reference instruction printer header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _DAVERIFY_REFPRINT_H
+#define _DAVERIFY_REFPRINT_H
+
+#include <stdio.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/types.h>
+
+
+void ref_instr_fprint(FILE *f, const da_instr_t *instr,
+		      const da_instr_args_t *args, da_addr_t addr);
+
+
+#endif /* ! _DAVERIFY_REFPRINT_H */
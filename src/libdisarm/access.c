@@ -0,0 +1,109 @@
+/*
+ * access.c - Instruction field accessor tables
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "access.h"
+#include "macros.h"
+#include "types.h"
+
+
+/* Shorthands for the map below. The bit positions must match the
+   DA_ARG calls in args.c. */
+#define N  DA_FIELD_NONE
+#define NEVER  0, 1
+#define ALWAYS  0, 0
+#define SET(bit)  (1 << (bit)), (1 << (bit))
+#define CLEAR(bit)  (1 << (bit)), 0
+
+/* rd, rn, rm, rs, imm, load mask/value, store mask/value */
+DA_API const da_field_map_t da_field_map[DA_GROUP_MAX] = {
+	[DA_GROUP_BKPT] =
+	{  N,  N,  N,  N, DA_IMM_BKPT,   NEVER,     NEVER     },
+	[DA_GROUP_BL] =
+	{  N,  N,  N,  N, DA_IMM_BRANCH, NEVER,     NEVER     },
+	[DA_GROUP_BLX_IMM] =
+	{  N,  N,  N,  N, DA_IMM_BRANCH, NEVER,     NEVER     },
+	[DA_GROUP_BLX_REG] =
+	{  N,  N,  0,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_CLZ] =
+	{ 12,  N,  0,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_CP_DATA] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_CP_LS] =
+	{  N, 16,  N,  N, DA_IMM_CP,     SET(20),   CLEAR(20) },
+	[DA_GROUP_CP_REG] =
+	{ 12,  N,  N,  N, DA_IMM_NONE,   SET(20),   CLEAR(20) },
+	[DA_GROUP_DATA_IMM] =
+	{ 12, 16,  N,  N, DA_IMM_ROT,    NEVER,     NEVER     },
+	[DA_GROUP_DATA_IMM_SH] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_DATA_REG_SH] =
+	{ 12, 16,  0,  8, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_DSP_ADD_SUB] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_DSP_MUL] =
+	{ 16, 12,  0, 12, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_L_SIGN_IMM] =
+	{ 12, 16,  N,  N, DA_IMM_SPLIT,  ALWAYS,    NEVER     },
+	[DA_GROUP_L_SIGN_REG] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   ALWAYS,    NEVER     },
+	[DA_GROUP_LS_HW_IMM] =
+	{ 12, 16,  N,  N, DA_IMM_SPLIT,  SET(20),   CLEAR(20) },
+	[DA_GROUP_LS_HW_REG] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   SET(20),   CLEAR(20) },
+	[DA_GROUP_LS_IMM] =
+	{ 12, 16,  N,  N, DA_IMM_OFF12,  SET(20),   CLEAR(20) },
+	[DA_GROUP_LS_MULTI] =
+	{  N, 16,  N,  N, DA_IMM_NONE,   SET(20),   CLEAR(20) },
+	[DA_GROUP_LS_REG] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   SET(20),   CLEAR(20) },
+	[DA_GROUP_LS_TWO_IMM] =
+	{ 12, 16,  N,  N, DA_IMM_SPLIT,  CLEAR(5),  SET(5)    },
+	[DA_GROUP_LS_TWO_REG] =
+	{ 12, 16,  0,  N, DA_IMM_NONE,   CLEAR(5),  SET(5)    },
+	[DA_GROUP_MRS] =
+	{ 12,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_MSR] =
+	{  N,  N,  0,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_MSR_IMM] =
+	{  N,  N,  N,  N, DA_IMM_ROT,    NEVER,     NEVER     },
+	[DA_GROUP_MUL] =
+	{ 16, 12,  0,  8, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_MULL] =
+	{ 12, 16,  0,  8, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_SWI] =
+	{  N,  N,  N,  N, DA_IMM_SWI,    NEVER,     NEVER     },
+	/* rm is read from bit 10, as in args.c */
+	[DA_GROUP_SWP] =
+	{ 12, 16, 10,  N, DA_IMM_NONE,   ALWAYS,    ALWAYS    },
+	[DA_GROUP_UNDEF_1] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_UNDEF_2] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_UNDEF_3] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_UNDEF_4] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     },
+	[DA_GROUP_UNDEF_5] =
+	{  N,  N,  N,  N, DA_IMM_NONE,   NEVER,     NEVER     }
+};
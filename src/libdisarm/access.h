@@ -0,0 +1,172 @@
+/*
+ * access.h - Instruction field accessor header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_ACCESS_H
+#define _LIBDISARM_ACCESS_H
+
+#include <stdint.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+/* Value of register accessors for groups without that field */
+#define DA_FIELD_NONE  0xff
+
+DA_BEGIN_DECLS
+
+/* Encodings of the immediate field */
+typedef enum {
+	DA_IMM_NONE = 0,
+	DA_IMM_BKPT,		/* 12 + 4 bits split by bits 4-7 */
+	DA_IMM_BRANCH,		/* 24 bit branch offset */
+	DA_IMM_ROT,		/* 8 bits rotated right by twice bits 8-11 */
+	DA_IMM_CP,		/* 8 bits, unsigned */
+	DA_IMM_SPLIT,		/* 4 + 4 bits, signed by bit 23 */
+	DA_IMM_OFF12,		/* 12 bits, signed by bit 23 */
+	DA_IMM_SWI,		/* 24 bits */
+	DA_IMM_MAX
+} da_imm_kind_t;
+
+/* Per-group field map. Register shifts are DA_FIELD_NONE when the group
+   has no such field. An instruction loads when
+   (data & load_mask) == load_value, and likewise for stores. */
+typedef struct {
+	uint8_t rd;
+	uint8_t rn;
+	uint8_t rm;
+	uint8_t rs;
+	uint8_t imm;
+	uint32_t load_mask;
+	uint32_t load_value;
+	uint32_t store_mask;
+	uint32_t store_value;
+} da_field_map_t;
+
+extern const da_field_map_t da_field_map[DA_GROUP_MAX];
+
+
+/* Extract the register at map shift s, or DA_FIELD_NONE. */
+static inline da_uint_t
+da_instr_field_reg(const da_instr_t *instr, da_uint_t s)
+{
+	if (s == DA_FIELD_NONE) return DA_FIELD_NONE;
+	return (instr->data >> s) & DA_REG_MASK;
+}
+
+/* The following return the field of the same name in the group's
+   argument struct, as set by da_instr_parse_args. For multiply long
+   rd is RdLo and rn is RdHi. */
+
+static inline da_uint_t
+da_instr_rd(const da_instr_t *instr)
+{
+	return da_instr_field_reg(instr, da_field_map[instr->group].rd);
+}
+
+static inline da_uint_t
+da_instr_rn(const da_instr_t *instr)
+{
+	return da_instr_field_reg(instr, da_field_map[instr->group].rn);
+}
+
+static inline da_uint_t
+da_instr_rm(const da_instr_t *instr)
+{
+	return da_instr_field_reg(instr, da_field_map[instr->group].rm);
+}
+
+static inline da_uint_t
+da_instr_rs(const da_instr_t *instr)
+{
+	return da_instr_field_reg(instr, da_field_map[instr->group].rs);
+}
+
+/* Return the imm or off field, or 0 if the group has none. Branch
+   offsets are returned unextended, as in the bl and blx_imm args. */
+static inline int32_t
+da_instr_imm(const da_instr_t *instr)
+{
+	da_word_t d = instr->data;
+	int32_t sign = (d & (1 << 23)) ? 1 : -1;
+	da_uint_t rot;
+
+	switch (da_field_map[instr->group].imm) {
+	case DA_IMM_BKPT:
+		return (((d >> 8) & 0xfff) << 4) | (d & 0xf);
+	case DA_IMM_BRANCH:
+	case DA_IMM_SWI:
+		return d & 0xffffff;
+	case DA_IMM_ROT:
+		rot = (d >> 7) & 0x1e;
+		return ((d & 0xff) >> rot) | ((d & 0xff) << ((32 - rot) & 31));
+	case DA_IMM_CP:
+		return d & 0xff;
+	case DA_IMM_SPLIT:
+		return sign * (int32_t)((((d >> 8) & 0xf) << 4) | (d & 0xf));
+	case DA_IMM_OFF12:
+		return sign * (int32_t)(d & 0xfff);
+	default:
+		return 0;
+	}
+}
+
+/* Return true if the instruction loads from memory or a coprocessor. */
+static inline int
+da_instr_is_load(const da_instr_t *instr)
+{
+	const da_field_map_t *map = &da_field_map[instr->group];
+	return (instr->data & map->load_mask) == map->load_value;
+}
+
+/* Return true if the instruction stores to memory or a coprocessor. */
+static inline int
+da_instr_is_store(const da_instr_t *instr)
+{
+	const da_field_map_t *map = &da_field_map[instr->group];
+	return (instr->data & map->store_mask) == map->store_value;
+}
+
+/* Return register list of load/store multiple, or 0. */
+static inline da_uint_t
+da_instr_reglist(const da_instr_t *instr)
+{
+	if (instr->group != DA_GROUP_LS_MULTI) return 0;
+	return instr->data & 0xffff;
+}
+
+/* Return true if the instruction sets the condition flags. */
+static inline int
+da_instr_sets_flags(const da_instr_t *instr)
+{
+	switch (instr->group) {
+	case DA_GROUP_DATA_IMM:
+	case DA_GROUP_DATA_IMM_SH:
+	case DA_GROUP_DATA_REG_SH:
+	case DA_GROUP_MUL:
+	case DA_GROUP_MULL:
+		return (instr->data >> 20) & 1;
+	default:
+		return 0;
+	}
+}
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_ACCESS_H */
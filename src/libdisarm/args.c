@@ -64,9 +64,19 @@ da_instr_branch_target(da_uint_t offset, da_addr_t addr)
 	return (off.ext << 2) + addr + 8;
 }
 
+/* Return target address of BLX immediate instruction. The H bit selects
+   the second halfword of the word at the branch target. Note that the
+   printed text of the instruction is the word aligned target with H in
+   bit 0 (0x9 for fb000000 at address 0, where the target is 0xa). */
+DA_API da_addr_t
+da_instr_blx_target(da_uint_t offset, da_uint_t h, da_addr_t addr)
+{
+	return da_instr_branch_target(offset, addr) + (h << 1);
+}
+
 /* Parse instruction arguments. */
-DA_API void
-da_instr_parse_args(da_instr_args_t *args, const da_instr_t *instr)
+static inline void
+da_instr_parse_args_inline(da_instr_args_t *args, const da_instr_t *instr)
 {
 	switch (instr->group) {
 	case DA_GROUP_BKPT:
@@ -324,3 +334,20 @@ da_instr_parse_args(da_instr_args_t *args, const da_instr_t *instr)
 		break;
 	}
 }
+
+DA_API void
+da_instr_parse_args(da_instr_args_t *args, const da_instr_t *instr)
+{
+	da_instr_parse_args_inline(args, instr);
+}
+
+/* Parse arguments of count instructions into the args array. */
+DA_API void
+da_instr_parse_args_block(da_instr_args_t *args, const da_instr_t *instrs,
+			  size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_instr_parse_args_inline(&args[i], &instrs[i]);
+	}
+}
@@ -21,6 +21,8 @@
 #ifndef _LIBDISARM_ARGS_H
 #define _LIBDISARM_ARGS_H
 
+#include <stddef.h>
+
 #include <libdisarm/macros.h>
 #include <libdisarm/types.h>
 
@@ -337,8 +339,11 @@ typedef struct {
 
 da_cond_t da_instr_get_cond(const da_instr_t *instr);
 da_addr_t da_instr_branch_target(da_uint_t off, da_addr_t addr);
+da_addr_t da_instr_blx_target(da_uint_t off, da_uint_t h, da_addr_t addr);
 
 void da_instr_parse_args(da_instr_args_t *args, const da_instr_t *instr);
+void da_instr_parse_args_block(da_instr_args_t *args,
+			       const da_instr_t *instrs, size_t count);
 
 DA_END_DECLS
 
@@ -0,0 +1,457 @@
+/*
+ * block.c - Decoded instruction block
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "block.h"
+#include "macros.h"
+#include "parser.h"
+#include "types.h"
+
+
+/* Number of words decoded at a time by da_block_add_words */
+#define DA_BLOCK_PARSE_SIZE  256
+
+#define DA_BLOCK_LS_FLAGS(load,p,write) \
+	(((load) ? DA_BLOCK_FLAG_LOAD : DA_BLOCK_FLAG_STORE) | \
+	 ((p) ? DA_BLOCK_FLAG_PRE : 0) | \
+	 ((!(p) || (write)) ? DA_BLOCK_FLAG_WRITEBACK : 0))
+
+
+/* Grow columns to hold at least size rows. Return -1 on error. */
+static int
+da_block_reserve(da_block_t *block, size_t size)
+{
+	if (size <= block->size) return 0;
+
+	size_t new_size = (block->size > 0 ? block->size : 256);
+	while (new_size < size) new_size *= 2;
+
+#define DA_BLOCK_GROW(column) \
+	do { \
+		void *p = realloc(block->column, \
+				  new_size*sizeof(*block->column)); \
+		if (p == NULL) return -1; \
+		block->column = p; \
+	} while (0)
+
+	DA_BLOCK_GROW(data);
+	DA_BLOCK_GROW(group);
+	DA_BLOCK_GROW(cond);
+	DA_BLOCK_GROW(rd);
+	DA_BLOCK_GROW(rn);
+	DA_BLOCK_GROW(rm);
+	DA_BLOCK_GROW(flags);
+	DA_BLOCK_GROW(imm);
+
+#undef DA_BLOCK_GROW
+
+	block->size = new_size;
+	return 0;
+}
+
+/* Initialize empty block with room for size rows. Return -1 on error. */
+DA_API int
+da_block_init(da_block_t *block, size_t size)
+{
+	memset(block, 0, sizeof(da_block_t));
+
+	int r = da_block_reserve(block, size);
+	if (r < 0) {
+		da_block_free(block);
+		return -1;
+	}
+
+	return 0;
+}
+
+DA_API void
+da_block_free(da_block_t *block)
+{
+	free(block->data);
+	free(block->group);
+	free(block->cond);
+	free(block->rd);
+	free(block->rn);
+	free(block->rm);
+	free(block->flags);
+	free(block->imm);
+	memset(block, 0, sizeof(da_block_t));
+}
+
+/* Remove all rows. */
+DA_API void
+da_block_clear(da_block_t *block)
+{
+	block->count = 0;
+}
+
+/* Set row i from decoded instruction. */
+static void
+da_block_set(da_block_t *block, size_t i, const da_instr_t *instr,
+	     const da_instr_args_t *args)
+{
+	da_uint_t rd = DA_BLOCK_REG_NONE;
+	da_uint_t rn = DA_BLOCK_REG_NONE;
+	da_uint_t rm = DA_BLOCK_REG_NONE;
+	uint32_t flags = 0;
+	int32_t imm = 0;
+
+	switch (instr->group) {
+	case DA_GROUP_BKPT:
+		imm = args->bkpt.imm;
+		flags = DA_BLOCK_FLAG_IMM;
+		break;
+	case DA_GROUP_BL:
+		imm = da_instr_branch_target(args->bl.off, 0);
+		flags = DA_BLOCK_FLAG_BRANCH | DA_BLOCK_FLAG_WRITE_PC |
+			DA_BLOCK_FLAG_IMM |
+			(args->bl.link ? DA_BLOCK_FLAG_LINK : 0);
+		break;
+	case DA_GROUP_BLX_IMM:
+		imm = da_instr_blx_target(args->blx_imm.off, args->blx_imm.h,
+					  0);
+		flags = DA_BLOCK_FLAG_BRANCH | DA_BLOCK_FLAG_WRITE_PC |
+			DA_BLOCK_FLAG_LINK | DA_BLOCK_FLAG_IMM;
+		break;
+	case DA_GROUP_BLX_REG:
+		rm = args->blx_reg.rm;
+		flags = DA_BLOCK_FLAG_BRANCH | DA_BLOCK_FLAG_WRITE_PC |
+			(args->blx_reg.link ? DA_BLOCK_FLAG_LINK : 0);
+		break;
+	case DA_GROUP_CLZ:
+		rd = args->clz.rd;
+		rm = args->clz.rm;
+		break;
+	case DA_GROUP_CP_DATA:
+		break;
+	case DA_GROUP_CP_LS:
+		rn = args->cp_ls.rn;
+		imm = (args->cp_ls.sign ? 1 : -1) * (args->cp_ls.imm << 2);
+		flags = DA_BLOCK_FLAG_IMM |
+			(args->cp_ls.load ? DA_BLOCK_FLAG_LOAD :
+			 DA_BLOCK_FLAG_STORE) |
+			(args->cp_ls.p ? DA_BLOCK_FLAG_PRE : 0) |
+			(args->cp_ls.write ? DA_BLOCK_FLAG_WRITEBACK : 0);
+		break;
+	case DA_GROUP_CP_REG:
+		rd = args->cp_reg.rd;
+		flags = (args->cp_reg.load ? DA_BLOCK_FLAG_LOAD :
+			 DA_BLOCK_FLAG_STORE);
+		break;
+	case DA_GROUP_DATA_IMM:
+		rd = args->data_imm.rd;
+		rn = args->data_imm.rn;
+		imm = args->data_imm.imm;
+		flags = DA_BLOCK_FLAG_IMM |
+			(args->data_imm.flags ? DA_BLOCK_FLAG_S : 0);
+		break;
+	case DA_GROUP_DATA_IMM_SH:
+		rd = args->data_imm_sh.rd;
+		rn = args->data_imm_sh.rn;
+		rm = args->data_imm_sh.rm;
+		imm = args->data_imm_sh.sha;
+		flags = DA_BLOCK_FLAG_IMM |
+			(args->data_imm_sh.flags ? DA_BLOCK_FLAG_S : 0);
+		break;
+	case DA_GROUP_DATA_REG_SH:
+		rd = args->data_reg_sh.rd;
+		rn = args->data_reg_sh.rn;
+		rm = args->data_reg_sh.rm;
+		flags = (args->data_reg_sh.flags ? DA_BLOCK_FLAG_S : 0);
+		break;
+	case DA_GROUP_DSP_ADD_SUB:
+		rd = args->dsp_add_sub.rd;
+		rn = args->dsp_add_sub.rn;
+		rm = args->dsp_add_sub.rm;
+		break;
+	case DA_GROUP_DSP_MUL:
+		rd = args->dsp_mul.rd;
+		rn = args->dsp_mul.rn;
+		rm = args->dsp_mul.rm;
+		break;
+	case DA_GROUP_L_SIGN_IMM:
+		rd = args->l_sign_imm.rd;
+		rn = args->l_sign_imm.rn;
+		imm = args->l_sign_imm.off;
+		flags = DA_BLOCK_FLAG_IMM |
+			DA_BLOCK_LS_FLAGS(1, args->l_sign_imm.p,
+					  args->l_sign_imm.write) |
+			(args->l_sign_imm.hword ? DA_BLOCK_FLAG_HWORD :
+			 DA_BLOCK_FLAG_BYTE);
+		break;
+	case DA_GROUP_L_SIGN_REG:
+		rd = args->l_sign_reg.rd;
+		rn = args->l_sign_reg.rn;
+		rm = args->l_sign_reg.rm;
+		flags = DA_BLOCK_LS_FLAGS(1, args->l_sign_reg.p,
+					  args->l_sign_reg.write) |
+			(args->l_sign_reg.hword ? DA_BLOCK_FLAG_HWORD :
+			 DA_BLOCK_FLAG_BYTE);
+		break;
+	case DA_GROUP_LS_HW_IMM:
+		rd = args->ls_hw_imm.rd;
+		rn = args->ls_hw_imm.rn;
+		imm = args->ls_hw_imm.off;
+		flags = DA_BLOCK_FLAG_IMM | DA_BLOCK_FLAG_HWORD |
+			DA_BLOCK_LS_FLAGS(args->ls_hw_imm.load,
+					  args->ls_hw_imm.p,
+					  args->ls_hw_imm.write);
+		break;
+	case DA_GROUP_LS_HW_REG:
+		rd = args->ls_hw_reg.rd;
+		rn = args->ls_hw_reg.rn;
+		rm = args->ls_hw_reg.rm;
+		flags = DA_BLOCK_FLAG_HWORD |
+			DA_BLOCK_LS_FLAGS(args->ls_hw_reg.load,
+					  args->ls_hw_reg.p,
+					  args->ls_hw_reg.write);
+		break;
+	case DA_GROUP_LS_IMM:
+		rd = args->ls_imm.rd;
+		rn = args->ls_imm.rn;
+		imm = args->ls_imm.off;
+		flags = DA_BLOCK_FLAG_IMM |
+			DA_BLOCK_LS_FLAGS(args->ls_imm.load, args->ls_imm.p,
+					  args->ls_imm.w) |
+			(args->ls_imm.byte ? DA_BLOCK_FLAG_BYTE : 0);
+		break;
+	case DA_GROUP_LS_MULTI:
+		rn = args->ls_multi.rn;
+		imm = args->ls_multi.reglist;
+		flags = DA_BLOCK_FLAG_IMM |
+			(args->ls_multi.load ? DA_BLOCK_FLAG_LOAD :
+			 DA_BLOCK_FLAG_STORE) |
+			(args->ls_multi.p ? DA_BLOCK_FLAG_PRE : 0) |
+			(args->ls_multi.write ? DA_BLOCK_FLAG_WRITEBACK : 0);
+		if (args->ls_multi.load &&
+		    (args->ls_multi.reglist & (1 << DA_REG_R15))) {
+			flags |= DA_BLOCK_FLAG_WRITE_PC;
+		}
+		break;
+	case DA_GROUP_LS_REG:
+		rd = args->ls_reg.rd;
+		rn = args->ls_reg.rn;
+		rm = args->ls_reg.rm;
+		imm = args->ls_reg.sha;
+		flags = DA_BLOCK_FLAG_IMM |
+			DA_BLOCK_LS_FLAGS(args->ls_reg.load, args->ls_reg.p,
+					  args->ls_reg.write) |
+			(args->ls_reg.byte ? DA_BLOCK_FLAG_BYTE : 0);
+		break;
+	case DA_GROUP_LS_TWO_IMM:
+		rd = args->ls_two_imm.rd;
+		rn = args->ls_two_imm.rn;
+		imm = args->ls_two_imm.off;
+		flags = DA_BLOCK_FLAG_IMM | DA_BLOCK_FLAG_DWORD |
+			DA_BLOCK_LS_FLAGS(!args->ls_two_imm.store,
+					  args->ls_two_imm.p,
+					  args->ls_two_imm.write);
+		break;
+	case DA_GROUP_LS_TWO_REG:
+		rd = args->ls_two_reg.rd;
+		rn = args->ls_two_reg.rn;
+		rm = args->ls_two_reg.rm;
+		flags = DA_BLOCK_FLAG_DWORD |
+			DA_BLOCK_LS_FLAGS(!args->ls_two_reg.store,
+					  args->ls_two_reg.p,
+					  args->ls_two_reg.write);
+		break;
+	case DA_GROUP_MRS:
+		rd = args->mrs.rd;
+		break;
+	case DA_GROUP_MSR:
+		rm = args->msr.rm;
+		break;
+	case DA_GROUP_MSR_IMM:
+		imm = args->msr_imm.imm;
+		flags = DA_BLOCK_FLAG_IMM;
+		break;
+	case DA_GROUP_MUL:
+		rd = args->mul.rd;
+		if (args->mul.acc) rn = args->mul.rn;
+		rm = args->mul.rm;
+		flags = (args->mul.flags ? DA_BLOCK_FLAG_S : 0);
+		break;
+	case DA_GROUP_MULL:
+		rd = args->mull.rd_lo;
+		rn = args->mull.rd_hi;
+		rm = args->mull.rm;
+		flags = (args->mull.flags ? DA_BLOCK_FLAG_S : 0);
+		break;
+	case DA_GROUP_SWI:
+		imm = args->swi.imm;
+		flags = DA_BLOCK_FLAG_IMM;
+		break;
+	case DA_GROUP_SWP:
+		rd = args->swp.rd;
+		rn = args->swp.rn;
+		rm = args->swp.rm;
+		flags = DA_BLOCK_FLAG_LOAD | DA_BLOCK_FLAG_STORE |
+			(args->swp.byte ? DA_BLOCK_FLAG_BYTE : 0);
+		break;
+	case DA_GROUP_UNDEF_1:
+	case DA_GROUP_UNDEF_2:
+	case DA_GROUP_UNDEF_3:
+	case DA_GROUP_UNDEF_4:
+	case DA_GROUP_UNDEF_5:
+	case DA_GROUP_MAX:
+		break;
+	}
+
+	/* Data processing: compares have no Rd, moves have no Rn */
+	if (instr->group == DA_GROUP_DATA_IMM ||
+	    instr->group == DA_GROUP_DATA_IMM_SH ||
+	    instr->group == DA_GROUP_DATA_REG_SH) {
+		da_data_op_t op = DA_ARG_DATA_OP(instr, 21);
+		if (op >= DA_DATA_OP_TST && op <= DA_DATA_OP_CMN) {
+			rd = DA_BLOCK_REG_NONE;
+		} else if (op == DA_DATA_OP_MOV || op == DA_DATA_OP_MVN) {
+			rn = DA_BLOCK_REG_NONE;
+		}
+	}
+
+	/* Loads and data processing to r15 */
+	if (rd == DA_REG_R15 && instr->group != DA_GROUP_CP_REG &&
+	    (flags & (DA_BLOCK_FLAG_LOAD | DA_BLOCK_FLAG_STORE)) !=
+	    DA_BLOCK_FLAG_STORE) {
+		flags |= DA_BLOCK_FLAG_WRITE_PC;
+	}
+
+	block->data[i] = instr->data;
+	block->group[i] = instr->group;
+	block->cond[i] = da_instr_get_cond(instr);
+	block->rd[i] = rd;
+	block->rn[i] = rn;
+	block->rm[i] = rm;
+	block->flags[i] = flags;
+	block->imm[i] = imm;
+}
+
+/* Decode count words and append them to block. Return -1 on error. */
+DA_API int
+da_block_add_words(da_block_t *block, const da_word_t *data, size_t count,
+		   int big_endian)
+{
+	da_instr_t instrs[DA_BLOCK_PARSE_SIZE];
+	da_instr_args_t args[DA_BLOCK_PARSE_SIZE];
+
+	int r = da_block_reserve(block, block->count + count);
+	if (r < 0) return -1;
+
+	while (count > 0) {
+		size_t n = (count < DA_BLOCK_PARSE_SIZE ? count :
+			    DA_BLOCK_PARSE_SIZE);
+
+		da_instr_parse_block(instrs, data, n, big_endian);
+		da_instr_parse_args_block(args, instrs, n);
+
+		size_t i;
+		for (i = 0; i < n; i++) {
+			da_block_set(block, block->count + i, &instrs[i],
+				     &args[i]);
+		}
+
+		block->count += n;
+		data += n;
+		count -= n;
+	}
+
+	return 0;
+}
+
+/* Append count decoded instructions to block. Return -1 on error. */
+DA_API int
+da_block_add_instrs(da_block_t *block, const da_instr_t *instrs,
+		    const da_instr_args_t *args, size_t count)
+{
+	int r = da_block_reserve(block, block->count + count);
+	if (r < 0) return -1;
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_block_set(block, block->count + i, &instrs[i], &args[i]);
+	}
+
+	block->count += count;
+	return 0;
+}
+
+/* Get instruction of row i. */
+DA_API void
+da_block_get_instr(const da_block_t *block, size_t i, da_instr_t *instr)
+{
+	instr->data = block->data[i];
+	instr->group = block->group[i];
+}
+
+/* Store indices of rows in group. indices must have room for a row index
+   per row of the block. Return the number of rows found. */
+DA_API size_t
+da_block_select_group(const da_block_t *block, da_group_t group,
+		      size_t *indices)
+{
+	size_t n = 0;
+	size_t i;
+	for (i = 0; i < block->count; i++) {
+		indices[n] = i;
+		n += (block->group[i] == group);
+	}
+
+	return n;
+}
+
+/* Store indices of rows with all flags in mask set, as
+   da_block_select_group does. */
+DA_API size_t
+da_block_select_flags(const da_block_t *block, uint32_t mask,
+		      size_t *indices)
+{
+	size_t n = 0;
+	size_t i;
+	for (i = 0; i < block->count; i++) {
+		indices[n] = i;
+		n += ((block->flags[i] & mask) == mask);
+	}
+
+	return n;
+}
+
+/* Store indices of rows with reg in the rd, rn or rm column, as
+   da_block_select_group does. */
+DA_API size_t
+da_block_select_reg(const da_block_t *block, da_reg_t reg, size_t *indices)
+{
+	size_t n = 0;
+	size_t i;
+	for (i = 0; i < block->count; i++) {
+		indices[n] = i;
+		n += ((block->rd[i] == reg) | (block->rn[i] == reg) |
+		      (block->rm[i] == reg));
+	}
+
+	return n;
+}
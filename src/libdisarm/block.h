@@ -0,0 +1,93 @@
+/*
+ * block.h - Decoded instruction block header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_BLOCK_H
+#define _LIBDISARM_BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Register column value of instructions without that register */
+#define DA_BLOCK_REG_NONE  0xff
+
+/* Flags column bits */
+#define DA_BLOCK_FLAG_S          (1 << 0)   /* Updates condition flags */
+#define DA_BLOCK_FLAG_LOAD       (1 << 1)   /* Loads from memory or CP */
+#define DA_BLOCK_FLAG_STORE      (1 << 2)   /* Stores to memory or CP */
+#define DA_BLOCK_FLAG_PRE        (1 << 3)   /* Pre-indexed addressing */
+#define DA_BLOCK_FLAG_WRITEBACK  (1 << 4)   /* Writes back base register */
+#define DA_BLOCK_FLAG_BYTE       (1 << 5)   /* Byte access */
+#define DA_BLOCK_FLAG_HWORD      (1 << 6)   /* Halfword access */
+#define DA_BLOCK_FLAG_DWORD      (1 << 7)   /* Two word access */
+#define DA_BLOCK_FLAG_BRANCH     (1 << 8)   /* Branch instruction */
+#define DA_BLOCK_FLAG_LINK       (1 << 9)   /* Writes return address */
+#define DA_BLOCK_FLAG_WRITE_PC   (1 << 10)  /* Writes r15 */
+#define DA_BLOCK_FLAG_IMM        (1 << 11)  /* Immediate column is valid */
+
+DA_BEGIN_DECLS
+
+/* Decoded instructions stored column-wise. Row i of every column
+   describes instruction i. Registers are stored in the columns of the
+   argument fields of the same name; multiply long stores RdLo in rd and
+   RdHi in rn. The immediate column holds the immediate value, signed
+   load/store offset, shift amount, register list of load/store multiple
+   or branch displacement from the instruction address. */
+typedef struct {
+	size_t count;
+	size_t size;
+
+	da_word_t *data;
+	uint8_t *group;
+	uint8_t *cond;
+	uint8_t *rd;
+	uint8_t *rn;
+	uint8_t *rm;
+	uint32_t *flags;
+	int32_t *imm;
+} da_block_t;
+
+
+int da_block_init(da_block_t *block, size_t size);
+void da_block_free(da_block_t *block);
+void da_block_clear(da_block_t *block);
+
+int da_block_add_words(da_block_t *block, const da_word_t *data,
+		       size_t count, int big_endian);
+int da_block_add_instrs(da_block_t *block, const da_instr_t *instrs,
+			const da_instr_args_t *args, size_t count);
+
+void da_block_get_instr(const da_block_t *block, size_t i,
+			da_instr_t *instr);
+
+size_t da_block_select_group(const da_block_t *block, da_group_t group,
+			     size_t *indices);
+size_t da_block_select_flags(const da_block_t *block, uint32_t mask,
+			     size_t *indices);
+size_t da_block_select_reg(const da_block_t *block, da_reg_t reg,
+			   size_t *indices);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_BLOCK_H */
@@ -0,0 +1,304 @@
+/*
+ * cfg.c - Control flow graph
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "cfg.h"
+#include "macros.h"
+#include "types.h"
+
+
+/* Most successors of a block: the branch target and the fall through */
+#define DA_CFG_MAX_SUCC  2
+
+
+static inline unsigned int
+da_cfg_popcount(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(x);
+#else
+	unsigned int n = 0;
+	while (x) {
+		x &= x - 1;
+		n += 1;
+	}
+	return n;
+#endif
+}
+
+static inline unsigned int
+da_cfg_ctz(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	unsigned int n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n += 1;
+	}
+	return n;
+#endif
+}
+
+/* Leaders bitmap with the number of leaders before each word */
+typedef struct {
+	uint64_t *bits;
+	uint32_t *rank;
+	size_t words;
+} da_cfg_leaders_t;
+
+static inline void
+da_cfg_mark(da_cfg_leaders_t *leaders, size_t i)
+{
+	leaders->bits[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline int
+da_cfg_is_leader(const da_cfg_leaders_t *leaders, size_t i)
+{
+	return (leaders->bits[i >> 6] >> (i & 63)) & 1;
+}
+
+/* Return the number of leaders before instruction i, which is the block
+   index of instruction i if it is a leader. */
+static inline size_t
+da_cfg_rank(const da_cfg_leaders_t *leaders, size_t i)
+{
+	uint64_t below = ((uint64_t)1 << (i & 63)) - 1;
+	return leaders->rank[i >> 6] +
+		da_cfg_popcount(leaders->bits[i >> 6] & below);
+}
+
+/* Store index of the direct branch target of instruction i in target.
+   Return 0 if the instruction has no target in the block. Targets of
+   blx are Thumb code and are not followed. */
+static inline int
+da_cfg_target(const da_block_t *block, size_t i, size_t *target)
+{
+	if (block->group[i] != DA_GROUP_BL) return 0;
+
+	/* The immediate is the target relative to the instruction */
+	int64_t t = (int64_t)i + block->imm[i] / 4;
+	if (t < 0 || (uint64_t)t >= block->count) return 0;
+
+	*target = t;
+	return 1;
+}
+
+/* Store successor edges of the block ending with instruction j. Return
+   the number of edges. */
+static size_t
+da_cfg_block_succ(const da_block_t *block, const da_cfg_leaders_t *leaders,
+		  size_t j, da_cfg_edge_t *edges)
+{
+	uint32_t flags = block->flags[j];
+	da_cond_t cond = block->cond[j];
+	int next = (j + 1 < block->count);
+	size_t n = 0;
+	size_t target;
+
+	if (!(flags & DA_BLOCK_FLAG_WRITE_PC)) {
+		if (next) {
+			edges[n].block = da_cfg_rank(leaders, j + 1);
+			edges[n].kind = DA_CFG_EDGE_FALL;
+			edges[n].cond = DA_COND_AL;
+			n += 1;
+		}
+		return n;
+	}
+
+	if (da_cfg_target(block, j, &target)) {
+		edges[n].block = da_cfg_rank(leaders, target);
+		edges[n].kind = ((flags & DA_BLOCK_FLAG_LINK) ?
+				 DA_CFG_EDGE_CALL : DA_CFG_EDGE_BRANCH);
+		edges[n].cond = cond;
+		n += 1;
+	}
+
+	/* Calls return, and conditional branches may fall through */
+	if (next && ((flags & DA_BLOCK_FLAG_LINK) || cond != DA_COND_AL)) {
+		edges[n].block = da_cfg_rank(leaders, j + 1);
+		edges[n].kind = DA_CFG_EDGE_FALL;
+		edges[n].cond = ((flags & DA_BLOCK_FLAG_LINK) ?
+				 DA_COND_AL : cond ^ 1);
+		n += 1;
+	}
+
+	return n;
+}
+
+/* Build control flow graph of the instructions in block, the first at
+   address addr. A basic block starts at the first instruction, at
+   targets of direct branches and after instructions that write r15.
+   Calls end a block with a call edge and a fall through edge; other
+   writes to r15 than direct branches have no known target. Return -1 on
+   error. */
+DA_API int
+da_cfg_build(da_cfg_t *cfg, const da_block_t *block, da_addr_t addr)
+{
+	size_t n = block->count;
+	size_t i, b;
+
+	memset(cfg, 0, sizeof(da_cfg_t));
+	cfg->addr = addr;
+	cfg->count = n;
+	if (n >= UINT32_MAX) return -1;
+
+	/* Mark leaders */
+	da_cfg_leaders_t leaders;
+	leaders.words = (n + 63) / 64 + 1;
+	leaders.bits = calloc(leaders.words, sizeof(uint64_t));
+	leaders.rank = malloc(leaders.words*sizeof(uint32_t));
+	if (leaders.bits == NULL || leaders.rank == NULL) {
+		free(leaders.bits);
+		free(leaders.rank);
+		return -1;
+	}
+
+	if (n > 0) da_cfg_mark(&leaders, 0);
+	for (i = 0; i < n; i++) {
+		size_t target;
+		if (!(block->flags[i] & DA_BLOCK_FLAG_WRITE_PC)) continue;
+		if (i + 1 < n) da_cfg_mark(&leaders, i + 1);
+		if (da_cfg_target(block, i, &target)) {
+			da_cfg_mark(&leaders, target);
+		}
+	}
+
+	size_t nblocks = 0;
+	for (i = 0; i < leaders.words; i++) {
+		leaders.rank[i] = nblocks;
+		nblocks += da_cfg_popcount(leaders.bits[i]);
+	}
+
+	/* Count edges of the blocks, which end before each leader */
+	size_t nedges = 0;
+	for (i = 0; i < n; i++) {
+		if (i + 1 == n || da_cfg_is_leader(&leaders, i + 1)) {
+			da_cfg_edge_t edges[DA_CFG_MAX_SUCC];
+			nedges += da_cfg_block_succ(block, &leaders, i, edges);
+		}
+	}
+
+	/* Allocate arena, edges first for alignment */
+	size_t size = 2*nedges*sizeof(da_cfg_edge_t) +
+		3*(nblocks + 1)*sizeof(uint32_t);
+	cfg->arena = malloc(size > 0 ? size : 1);
+	if (cfg->arena == NULL) {
+		free(leaders.bits);
+		free(leaders.rank);
+		return -1;
+	}
+
+	cfg->succ = cfg->arena;
+	cfg->pred = cfg->succ + nedges;
+	cfg->start = (uint32_t *)(cfg->pred + nedges);
+	cfg->succ_index = cfg->start + nblocks + 1;
+	cfg->pred_index = cfg->succ_index + nblocks + 1;
+	cfg->nblocks = nblocks;
+	cfg->nedges = nedges;
+
+	/* Blocks and successors */
+	b = 0;
+	for (i = 0; i < leaders.words; i++) {
+		uint64_t bits = leaders.bits[i];
+		while (bits) {
+			cfg->start[b++] = i*64 + da_cfg_ctz(bits);
+			bits &= bits - 1;
+		}
+	}
+	cfg->start[nblocks] = n;
+
+	size_t e = 0;
+	memset(cfg->pred_index, 0, (nblocks + 1)*sizeof(uint32_t));
+	for (b = 0; b < nblocks; b++) {
+		cfg->succ_index[b] = e;
+		e += da_cfg_block_succ(block, &leaders, cfg->start[b + 1] - 1,
+				       &cfg->succ[e]);
+	}
+	cfg->succ_index[nblocks] = e;
+
+	free(leaders.bits);
+	free(leaders.rank);
+
+	/* Predecessors by counting sort on the target block. pred_index[t]
+	   is used as the fill position of block t and ends up as the start
+	   of block t + 1. */
+	for (e = 0; e < nedges; e++) cfg->pred_index[cfg->succ[e].block] += 1;
+
+	uint32_t sum = 0;
+	for (b = 0; b <= nblocks; b++) {
+		uint32_t c = cfg->pred_index[b];
+		cfg->pred_index[b] = sum;
+		sum += c;
+	}
+
+	for (b = 0; b < nblocks; b++) {
+		for (e = cfg->succ_index[b]; e < cfg->succ_index[b + 1]; e++) {
+			da_cfg_edge_t *p =
+				&cfg->pred[cfg->pred_index[cfg->succ[e].block]++];
+			*p = cfg->succ[e];
+			p->block = b;
+		}
+	}
+
+	memmove(cfg->pred_index + 1, cfg->pred_index,
+		nblocks*sizeof(uint32_t));
+	cfg->pred_index[0] = 0;
+
+	return 0;
+}
+
+DA_API void
+da_cfg_free(da_cfg_t *cfg)
+{
+	free(cfg->arena);
+	memset(cfg, 0, sizeof(da_cfg_t));
+}
+
+/* Return index of the block containing address addr, or DA_CFG_NONE. */
+DA_API size_t
+da_cfg_block_at(const da_cfg_t *cfg, da_addr_t addr)
+{
+	if (addr < cfg->addr) return DA_CFG_NONE;
+
+	size_t i = (addr - cfg->addr) / sizeof(da_word_t);
+	if (i >= cfg->count) return DA_CFG_NONE;
+
+	/* Find the last block starting at or before i */
+	size_t lo = 0;
+	size_t hi = cfg->nblocks;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (cfg->start[mid] <= i) lo = mid;
+		else hi = mid;
+	}
+
+	return lo;
+}
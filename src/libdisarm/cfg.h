@@ -0,0 +1,97 @@
+/*
+ * cfg.h - Control flow graph header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_CFG_H
+#define _LIBDISARM_CFG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/block.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Block index of addresses outside the graph */
+#define DA_CFG_NONE  ((size_t)-1)
+
+DA_BEGIN_DECLS
+
+/* Kinds of edges */
+typedef enum {
+	DA_CFG_EDGE_FALL = 0,	/* To the next instruction */
+	DA_CFG_EDGE_BRANCH,	/* Taken direct branch */
+	DA_CFG_EDGE_CALL,	/* Direct branch with link */
+	DA_CFG_EDGE_MAX
+} da_cfg_edge_kind_t;
+
+/* Edge to (in successor lists) or from (in predecessor lists) block.
+   cond is the condition under which the edge is taken; the fall through
+   edge of a conditional branch has the inverse condition. */
+typedef struct {
+	uint32_t block;
+	uint8_t kind;
+	uint8_t cond;
+	uint16_t reserved;
+} da_cfg_edge_t;
+
+/* Control flow graph of the instructions of a block, the first at address
+   addr. Basic blocks are numbered in address order; block b holds the
+   instructions start[b] to start[b + 1] - 1. The successors of block b
+   are succ[succ_index[b]] to succ[succ_index[b + 1] - 1], and likewise
+   for predecessors. All arrays are allocated in one arena. */
+typedef struct {
+	da_addr_t addr;
+	size_t count;
+	size_t nblocks;
+	size_t nedges;
+
+	uint32_t *start;
+	uint32_t *succ_index;
+	da_cfg_edge_t *succ;
+	uint32_t *pred_index;
+	da_cfg_edge_t *pred;
+
+	void *arena;
+} da_cfg_t;
+
+
+int da_cfg_build(da_cfg_t *cfg, const da_block_t *block, da_addr_t addr);
+void da_cfg_free(da_cfg_t *cfg);
+
+size_t da_cfg_block_at(const da_cfg_t *cfg, da_addr_t addr);
+
+/* Return address of the first instruction of block b. */
+static inline da_addr_t
+da_cfg_block_addr(const da_cfg_t *cfg, size_t b)
+{
+	return cfg->addr + cfg->start[b]*sizeof(da_word_t);
+}
+
+/* Return number of instructions in block b. */
+static inline size_t
+da_cfg_block_size(const da_cfg_t *cfg, size_t b)
+{
+	return cfg->start[b + 1] - cfg->start[b];
+}
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_CFG_H */
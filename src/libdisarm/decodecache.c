@@ -0,0 +1,279 @@
+/*
+ * decodecache.c - Memoized instruction decode cache
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include "args.h"
+#include "decodecache.h"
+#include "endian.h"
+#include "macros.h"
+#include "parser.h"
+#include "types.h"
+
+
+/* Return the index of the entry, or of the first entry of the set, of
+   instruction word data. */
+static inline size_t
+da_decode_cache_index(const da_decode_cache_t *cache, da_word_t data)
+{
+	uint32_t h = data * 0x9e3779b1;
+	return (h ^ (h >> 15)) & cache->mask;
+}
+
+/* Initialize empty cache of at least size entries (rounded up to a power
+   of two) with replacement policy. Return -1 on error. */
+DA_API int
+da_decode_cache_init(da_decode_cache_t *cache, size_t size,
+		     da_decode_policy_t policy)
+{
+	size_t n = (policy == DA_DECODE_CACHE_LRU2 ? 2 : 1);
+	while (n < size) n *= 2;
+
+	memset(cache, 0, sizeof(da_decode_cache_t));
+	cache->mem = malloc(n*sizeof(da_decode_cache_entry_t) +
+			    DA_DECODE_CACHE_ENTRY_SIZE - 1);
+	if (cache->mem == NULL) return -1;
+
+	/* Align entries to cache lines */
+	uintptr_t p = (uintptr_t)cache->mem;
+	p = (p + DA_DECODE_CACHE_ENTRY_SIZE - 1) &
+		~(uintptr_t)(DA_DECODE_CACHE_ENTRY_SIZE - 1);
+	cache->entries = (da_decode_cache_entry_t *)p;
+
+	cache->policy = policy;
+	cache->size = n;
+	cache->mask = (policy == DA_DECODE_CACHE_LRU2 ? (n - 1) & ~1 : n - 1);
+	memset(cache->entries, 0, n*sizeof(da_decode_cache_entry_t));
+
+	return 0;
+}
+
+DA_API void
+da_decode_cache_free(da_decode_cache_t *cache)
+{
+	free(cache->mem);
+	memset(cache, 0, sizeof(da_decode_cache_t));
+}
+
+/* Remove all entries and reset the counters. */
+DA_API void
+da_decode_cache_clear(da_decode_cache_t *cache)
+{
+	memset(cache->entries, 0,
+	       cache->size*sizeof(da_decode_cache_entry_t));
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+static pthread_key_t da_decode_cache_key;
+static pthread_once_t da_decode_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void
+da_decode_cache_destroy(void *cache)
+{
+	da_decode_cache_free(cache);
+	free(cache);
+}
+
+static void
+da_decode_cache_key_create(void)
+{
+	pthread_key_create(&da_decode_cache_key, da_decode_cache_destroy);
+}
+
+/* Return the cache of the calling thread, a direct mapped cache of
+   DA_DECODE_CACHE_THREAD_SIZE entries that is created on first use and
+   freed when the thread exits. Return NULL on error. */
+DA_API da_decode_cache_t *
+da_decode_cache_thread(void)
+{
+	pthread_once(&da_decode_cache_key_once, da_decode_cache_key_create);
+
+	da_decode_cache_t *cache = pthread_getspecific(da_decode_cache_key);
+	if (cache != NULL) return cache;
+
+	cache = malloc(sizeof(da_decode_cache_t));
+	if (cache == NULL) return NULL;
+
+	if (da_decode_cache_init(cache, DA_DECODE_CACHE_THREAD_SIZE,
+				 DA_DECODE_CACHE_DIRECT) < 0) {
+		free(cache);
+		return NULL;
+	}
+
+	if (pthread_setspecific(da_decode_cache_key, cache) != 0) {
+		da_decode_cache_destroy(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+#else /* ! HAVE_PTHREAD */
+
+static da_decode_cache_t da_decode_cache_global;
+static int da_decode_cache_global_init = 0;
+
+DA_API da_decode_cache_t *
+da_decode_cache_thread(void)
+{
+	if (!da_decode_cache_global_init) {
+		if (da_decode_cache_init(&da_decode_cache_global,
+					 DA_DECODE_CACHE_THREAD_SIZE,
+					 DA_DECODE_CACHE_DIRECT) < 0) {
+			return NULL;
+		}
+		da_decode_cache_global_init = 1;
+	}
+
+	return &da_decode_cache_global;
+}
+
+#endif /* HAVE_PTHREAD */
+
+
+/* Return the entry of instruction word data, or NULL and the entry to
+   replace in victim if it is not cached. */
+static inline da_decode_cache_entry_t *
+da_decode_cache_lookup(da_decode_cache_t *cache, da_word_t data,
+		       da_decode_cache_entry_t **victim)
+{
+	da_decode_cache_entry_t *e =
+		&cache->entries[da_decode_cache_index(cache, data)];
+
+	if (cache->policy == DA_DECODE_CACHE_DIRECT) {
+		if (e->valid && e->data == data) return e;
+		*victim = e;
+		return NULL;
+	}
+
+	if (e[0].valid && e[0].data == data) {
+		e[0].recent = 1;
+		e[1].recent = 0;
+		return &e[0];
+	} else if (e[1].valid && e[1].data == data) {
+		e[1].recent = 1;
+		e[0].recent = 0;
+		return &e[1];
+	}
+
+	/* Replace an empty way or else the least recently used way */
+	int way = (e[0].recent || (e[0].valid && !e[1].valid));
+	e[way].recent = 1;
+	e[!way].recent = 0;
+	*victim = &e[way];
+	return NULL;
+}
+
+/* Decode arguments of instruction through the cache. */
+static inline void
+da_decode_cache_args(da_decode_cache_t *cache, da_instr_args_t *args,
+		     const da_instr_t *instr)
+{
+	da_decode_cache_entry_t *victim;
+	da_decode_cache_entry_t *e =
+		da_decode_cache_lookup(cache, instr->data, &victim);
+
+	if (e != NULL) {
+		cache->hits += 1;
+		*args = e->args;
+		return;
+	}
+
+	cache->misses += 1;
+	da_instr_parse_args(args, instr);
+
+	victim->data = instr->data;
+	victim->group = instr->group;
+	victim->valid = 1;
+	victim->args = *args;
+}
+
+/* Parse instruction word data as da_instr_parse and da_instr_parse_args
+   do, using the cache. */
+DA_API void
+da_decode_cache_parse(da_decode_cache_t *cache, da_instr_t *instr,
+		      da_instr_args_t *args, da_word_t data, int big_endian)
+{
+	da_word_t host = (big_endian ? be32toh(data) : le32toh(data));
+	da_decode_cache_entry_t *victim;
+	da_decode_cache_entry_t *e = da_decode_cache_lookup(cache, host,
+							    &victim);
+
+	if (e != NULL) {
+		cache->hits += 1;
+		instr->data = host;
+		instr->group = e->group;
+		*args = e->args;
+		return;
+	}
+
+	cache->misses += 1;
+	da_instr_parse(instr, data, big_endian);
+	da_instr_parse_args(args, instr);
+
+	victim->data = host;
+	victim->group = instr->group;
+	victim->valid = 1;
+	victim->args = *args;
+}
+
+/* Parse arguments of instruction as da_instr_parse_args does, using the
+   cache. */
+DA_API void
+da_decode_cache_parse_args(da_decode_cache_t *cache, da_instr_args_t *args,
+			   const da_instr_t *instr)
+{
+	da_decode_cache_args(cache, args, instr);
+}
+
+DA_API void
+da_decode_cache_parse_args_block(da_decode_cache_t *cache,
+				 da_instr_args_t *args,
+				 const da_instr_t *instrs, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_decode_cache_args(cache, &args[i], &instrs[i]);
+	}
+}
+
+/* Parse count words as da_instr_parse_block and da_instr_parse_args_block
+   do. Groups are looked up in the group table, which is as fast as the
+   cache, and only the arguments are taken from the cache. */
+DA_API void
+da_decode_cache_parse_block(da_decode_cache_t *cache, da_instr_t *instrs,
+			    da_instr_args_t *args, const da_word_t *data,
+			    size_t count, int big_endian)
+{
+	da_instr_parse_block(instrs, data, count, big_endian);
+	da_decode_cache_parse_args_block(cache, args, instrs, count);
+}
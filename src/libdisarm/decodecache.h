@@ -0,0 +1,96 @@
+/*
+ * decodecache.h - Memoized instruction decode cache header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_DECODECACHE_H
+#define _LIBDISARM_DECODECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Size of a cache entry, one cache line */
+#define DA_DECODE_CACHE_ENTRY_SIZE  64
+
+/* Size of the caches returned by da_decode_cache_thread */
+#define DA_DECODE_CACHE_THREAD_SIZE  1024
+
+DA_BEGIN_DECLS
+
+/* Replacement policy */
+typedef enum {
+	DA_DECODE_CACHE_DIRECT = 0,  /* Direct mapped, a miss replaces */
+	DA_DECODE_CACHE_LRU2         /* Two way set associative, a miss
+					replaces the least recently used */
+} da_decode_policy_t;
+
+/* Decoded instruction word, aligned to a cache line. */
+typedef struct {
+	da_word_t data;
+	uint8_t group;
+	uint8_t valid;
+	uint8_t recent;
+	uint8_t reserved;
+	da_instr_args_t args;
+	uint8_t pad[DA_DECODE_CACHE_ENTRY_SIZE - 8 - sizeof(da_instr_args_t)];
+} da_decode_cache_entry_t;
+
+/* Memo table of decoded instructions, indexed by a hash of the
+   instruction word. hits and misses count the lookups. */
+typedef struct {
+	da_decode_cache_entry_t *entries;
+	void *mem;
+	size_t size;
+	size_t mask;
+	da_decode_policy_t policy;
+
+	unsigned long hits;
+	unsigned long misses;
+} da_decode_cache_t;
+
+
+int da_decode_cache_init(da_decode_cache_t *cache, size_t size,
+			 da_decode_policy_t policy);
+void da_decode_cache_free(da_decode_cache_t *cache);
+void da_decode_cache_clear(da_decode_cache_t *cache);
+
+da_decode_cache_t *da_decode_cache_thread(void);
+
+void da_decode_cache_parse(da_decode_cache_t *cache, da_instr_t *instr,
+			   da_instr_args_t *args, da_word_t data,
+			   int big_endian);
+void da_decode_cache_parse_args(da_decode_cache_t *cache,
+				da_instr_args_t *args,
+				const da_instr_t *instr);
+void da_decode_cache_parse_args_block(da_decode_cache_t *cache,
+				      da_instr_args_t *args,
+				      const da_instr_t *instrs,
+				      size_t count);
+void da_decode_cache_parse_block(da_decode_cache_t *cache,
+				 da_instr_t *instrs, da_instr_args_t *args,
+				 const da_word_t *data, size_t count,
+				 int big_endian);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_DECODECACHE_H */
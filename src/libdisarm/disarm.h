@@ -21,11 +21,25 @@
 #ifndef _LIBDISARM_DISARM_H
 #define _LIBDISARM_DISARM_H
 
+#include <libdisarm/access.h>
 #include <libdisarm/args.h>
+#include <libdisarm/block.h>
+#include <libdisarm/cfg.h>
+#include <libdisarm/decodecache.h>
+#include <libdisarm/elf.h>
 #include <libdisarm/macros.h>
+#include <libdisarm/packed.h>
+#include <libdisarm/pagecache.h>
 #include <libdisarm/parser.h>
 #include <libdisarm/print.h>
+#include <libdisarm/query.h>
+#include <libdisarm/regs.h>
+#include <libdisarm/symtab.h>
+#include <libdisarm/textcache.h>
+#include <libdisarm/thumb.h>
+#include <libdisarm/trace.h>
 #include <libdisarm/types.h>
+#include <libdisarm/xref.h>
 
 
 #endif /* ! _LIBDISARM_DISARM_H */
@@ -0,0 +1,555 @@
+/*
+ * elf.c - ELF image loader
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+# include <sys/mman.h>
+#endif
+
+#include "elf.h"
+#include "macros.h"
+#include "types.h"
+
+/* ELF32 header fields */
+#define EHDR_SIZE       52
+#define EHDR_CLASS      4
+#define EHDR_DATA       5
+#define EHDR_TYPE       16
+#define EHDR_MACHINE    18
+#define EHDR_ENTRY      24
+#define EHDR_PHOFF      28
+#define EHDR_SHOFF      32
+#define EHDR_FLAGS      36
+#define EHDR_PHENTSIZE  42
+#define EHDR_PHNUM      44
+#define EHDR_SHENTSIZE  46
+#define EHDR_SHNUM      48
+#define EHDR_SHSTRNDX   50
+
+#define ELFCLASS32   1
+#define ELFDATA2LSB  1
+#define ELFDATA2MSB  2
+#define ET_REL       1
+#define EM_ARM       40
+#define EF_ARM_BE8   0x00800000
+
+/* Program header fields */
+#define PHDR_SIZE    32
+#define PHDR_TYPE    0
+#define PHDR_OFFSET  4
+#define PHDR_VADDR   8
+#define PHDR_FILESZ  16
+#define PHDR_FLAGS   24
+
+#define PT_LOAD  1
+#define PF_X     1
+
+/* Section header fields */
+#define SHDR_SIZE    40
+#define SHDR_NAME    0
+#define SHDR_TYPE    4
+#define SHDR_FLAGS   8
+#define SHDR_ADDR    12
+#define SHDR_OFFSET  16
+#define SHDR_SIZE_   20
+#define SHDR_LINK    24
+
+#define SHT_PROGBITS  1
+#define SHT_SYMTAB    2
+#define SHT_DYNSYM    11
+#define SHF_ALLOC      0x2
+#define SHF_EXECINSTR  0x4
+#define SHN_LORESERVE  0xff00
+#define SHN_XINDEX     0xffff
+
+/* Symbol fields */
+#define SYM_SIZE   16
+#define SYM_NAME   0
+#define SYM_VALUE  4
+#define SYM_SIZE_  8
+#define SYM_INFO   12
+#define SYM_SHNDX  14
+
+#define STT_NOTYPE  0
+#define STT_OBJECT  1
+#define STT_FUNC    2
+
+/* How an image opened by da_elf_open is released */
+#define ELF_OWNED_READ  1
+#define ELF_OWNED_MAP   2
+
+/* Mapping symbol in a section */
+typedef struct {
+	da_addr_t addr;
+	unsigned int shndx;
+	da_elf_mode_t mode;
+} elf_map_t;
+
+/* Image being loaded and the byte order of its headers */
+typedef struct {
+	const unsigned char *image;
+	size_t size;
+	int msb;
+	unsigned int shnum;
+	size_t shoff;
+	size_t shentsize;
+} elf_ctx_t;
+
+
+static da_uint_t
+elf_half(const elf_ctx_t *ctx, size_t off)
+{
+	const unsigned char *p = ctx->image + off;
+	return ctx->msb ? (p[0] << 8) | p[1] : (p[1] << 8) | p[0];
+}
+
+static da_uint_t
+elf_word(const elf_ctx_t *ctx, size_t off)
+{
+	const unsigned char *p = ctx->image + off;
+	if (ctx->msb) {
+		return ((da_uint_t)p[0] << 24) | (p[1] << 16) |
+			(p[2] << 8) | p[3];
+	}
+	return ((da_uint_t)p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+}
+
+/* Return true if size bytes at offset are inside the image. */
+static int
+elf_inside(const elf_ctx_t *ctx, size_t offset, size_t size)
+{
+	return offset <= ctx->size && size <= ctx->size - offset;
+}
+
+/* Return offset of the header of section i. */
+static size_t
+elf_shdr(const elf_ctx_t *ctx, unsigned int i)
+{
+	return ctx->shoff + i*ctx->shentsize;
+}
+
+/* Return the NUL terminated string at offset in string table section
+   strndx, or NULL if it is invalid. */
+static const char *
+elf_string(const elf_ctx_t *ctx, unsigned int strndx, da_uint_t offset)
+{
+	if (strndx == 0 || strndx >= ctx->shnum) return NULL;
+
+	size_t sh = elf_shdr(ctx, strndx);
+	size_t start = elf_word(ctx, sh + SHDR_OFFSET);
+	size_t size = elf_word(ctx, sh + SHDR_SIZE_);
+	if (!elf_inside(ctx, start, size) || offset >= size) return NULL;
+
+	const char *s = (const char *)ctx->image + start + offset;
+	if (memchr(s, '\0', size - offset) == NULL) return NULL;
+	return s;
+}
+
+static int
+elf_map_cmp(const void *a, const void *b)
+{
+	const elf_map_t *ma = a;
+	const elf_map_t *mb = b;
+	if (ma->shndx != mb->shndx) return ma->shndx < mb->shndx ? -1 : 1;
+	if (ma->addr != mb->addr) return ma->addr < mb->addr ? -1 : 1;
+	return 0;
+}
+
+static int
+elf_sym_cmp(const void *a, const void *b)
+{
+	const da_elf_sym_t *sa = a;
+	const da_elf_sym_t *sb = b;
+	if (sa->addr != sb->addr) return sa->addr < sb->addr ? -1 : 1;
+	return strcmp(sa->name, sb->name);
+}
+
+static int
+elf_range_cmp(const void *a, const void *b)
+{
+	const da_elf_range_t *ra = a;
+	const da_elf_range_t *rb = b;
+	if (ra->addr != rb->addr) return ra->addr < rb->addr ? -1 : 1;
+	return (ra->data > rb->data) - (ra->data < rb->data);
+}
+
+/* Return the mode of mapping symbol name, or -1 if it is not one. */
+static int
+elf_map_mode(const char *name)
+{
+	if (name[0] != '$' || (name[2] != '\0' && name[2] != '.')) return -1;
+	switch (name[1]) {
+	case 'a': return DA_ELF_MODE_ARM;
+	case 't': return DA_ELF_MODE_THUMB;
+	case 'd': return DA_ELF_MODE_DATA;
+	default: return -1;
+	}
+}
+
+/* Read the symbols of the first symbol table. Labels are added to
+   elf->syms and mapping symbols to maps. */
+static int
+elf_load_syms(da_elf_t *elf, const elf_ctx_t *ctx, int relocatable,
+	      elf_map_t **maps, size_t *nmaps)
+{
+	unsigned int i, symndx = 0;
+	for (i = 1; i < ctx->shnum; i++) {
+		da_uint_t type = elf_word(ctx, elf_shdr(ctx, i) + SHDR_TYPE);
+		if (type == SHT_SYMTAB) {
+			symndx = i;
+			break;
+		} else if (type == SHT_DYNSYM && symndx == 0) {
+			symndx = i;
+		}
+	}
+	if (symndx == 0) return 0;
+
+	size_t sh = elf_shdr(ctx, symndx);
+	size_t start = elf_word(ctx, sh + SHDR_OFFSET);
+	size_t count = elf_word(ctx, sh + SHDR_SIZE_) / SYM_SIZE;
+	unsigned int strndx = elf_word(ctx, sh + SHDR_LINK);
+	if (!elf_inside(ctx, start, count*SYM_SIZE)) return -1;
+
+	elf->syms = malloc(count*sizeof(da_elf_sym_t));
+	*maps = malloc(count*sizeof(elf_map_t));
+	if (count > 0 && (elf->syms == NULL || *maps == NULL)) return -1;
+
+	size_t k;
+	for (k = 1; k < count; k++) {
+		size_t sym = start + k*SYM_SIZE;
+		unsigned int info = ctx->image[sym + SYM_INFO];
+		unsigned int shndx = elf_half(ctx, sym + SYM_SHNDX);
+		if (shndx == 0 || shndx >= SHN_LORESERVE ||
+		    shndx >= ctx->shnum) continue;
+
+		const char *name = elf_string(ctx, strndx,
+					      elf_word(ctx, sym + SYM_NAME));
+		if (name == NULL || name[0] == '\0') continue;
+
+		da_addr_t addr = elf_word(ctx, sym + SYM_VALUE);
+		if (relocatable) {
+			addr += elf_word(ctx, elf_shdr(ctx, shndx) +
+					 SHDR_ADDR);
+		}
+
+		int mode = elf_map_mode(name);
+		if (mode >= 0) {
+			elf_map_t *map = &(*maps)[(*nmaps)++];
+			map->addr = addr;
+			map->shndx = shndx;
+			map->mode = mode;
+			continue;
+		}
+
+		unsigned int type = info & 0xf;
+		if (type != STT_NOTYPE && type != STT_OBJECT &&
+		    type != STT_FUNC) continue;
+
+		da_elf_sym_t *s = &elf->syms[elf->nsyms++];
+		s->func = (type == STT_FUNC);
+		s->thumb = (s->func && (addr & 1));
+		s->addr = addr & ~(da_addr_t)s->thumb;
+		s->size = elf_word(ctx, sym + SYM_SIZE_);
+		s->name = name;
+	}
+
+	qsort(*maps, *nmaps, sizeof(elf_map_t), elf_map_cmp);
+	qsort(elf->syms, elf->nsyms, sizeof(da_elf_sym_t), elf_sym_cmp);
+	return 0;
+}
+
+/* Add range of size bytes at address addr, merging it with the previous
+   range of the same section if it continues it in the same mode. */
+static void
+elf_add_range(da_elf_t *elf, da_addr_t addr, size_t size,
+	      const unsigned char *data, da_elf_mode_t mode,
+	      const char *section)
+{
+	if (size == 0) return;
+
+	if (elf->nranges > 0) {
+		da_elf_range_t *prev = &elf->ranges[elf->nranges-1];
+		if (prev->section == section && prev->mode == mode &&
+		    prev->data + prev->size == data) {
+			prev->size += size;
+			return;
+		}
+	}
+
+	da_elf_range_t *range = &elf->ranges[elf->nranges++];
+	range->addr = addr;
+	range->size = size;
+	range->data = data;
+	range->mode = mode;
+	range->section = section;
+}
+
+/* Add the executable sections split by the mapping symbols. */
+static int
+elf_load_sections(da_elf_t *elf, const elf_ctx_t *ctx, unsigned int shstrndx,
+		  const elf_map_t *maps, size_t nmaps)
+{
+	size_t m = 0;
+	unsigned int i;
+	for (i = 1; i < ctx->shnum; i++) {
+		size_t sh = elf_shdr(ctx, i);
+		da_uint_t flags = elf_word(ctx, sh + SHDR_FLAGS);
+		if (elf_word(ctx, sh + SHDR_TYPE) != SHT_PROGBITS ||
+		    (flags & (SHF_ALLOC | SHF_EXECINSTR)) !=
+		    (SHF_ALLOC | SHF_EXECINSTR)) continue;
+
+		da_addr_t start = elf_word(ctx, sh + SHDR_ADDR);
+		size_t offset = elf_word(ctx, sh + SHDR_OFFSET);
+		size_t size = elf_word(ctx, sh + SHDR_SIZE_);
+		if (!elf_inside(ctx, offset, size)) return -1;
+
+		const char *name = elf_string(ctx, shstrndx,
+					      elf_word(ctx, sh + SHDR_NAME));
+		if (name == NULL) name = "";
+
+		/* Code is ARM until the first mapping symbol */
+		const unsigned char *data = ctx->image + offset;
+		da_addr_t addr = start;
+		da_elf_mode_t mode = DA_ELF_MODE_ARM;
+
+		while (m < nmaps && maps[m].shndx < i) m += 1;
+		for (; m < nmaps && maps[m].shndx == i; m++) {
+			da_addr_t at = maps[m].addr;
+			if (at > start + size) at = start + size;
+			if (at > addr) {
+				elf_add_range(elf, addr, at - addr,
+					      data + (addr - start), mode,
+					      name);
+				addr = at;
+			}
+			mode = maps[m].mode;
+		}
+
+		elf_add_range(elf, addr, start + size - addr,
+			      data + (addr - start), mode, name);
+	}
+
+	return 0;
+}
+
+/* Add the executable PT_LOAD segments as ARM code. */
+static int
+elf_load_segments(da_elf_t *elf, const elf_ctx_t *ctx, size_t phoff,
+		  unsigned int phnum, size_t phentsize)
+{
+	unsigned int i;
+	for (i = 0; i < phnum; i++) {
+		size_t ph = phoff + i*phentsize;
+		if (elf_word(ctx, ph + PHDR_TYPE) != PT_LOAD ||
+		    !(elf_word(ctx, ph + PHDR_FLAGS) & PF_X)) continue;
+
+		size_t offset = elf_word(ctx, ph + PHDR_OFFSET);
+		size_t size = elf_word(ctx, ph + PHDR_FILESZ);
+		if (!elf_inside(ctx, offset, size)) return -1;
+
+		elf_add_range(elf, elf_word(ctx, ph + PHDR_VADDR), size,
+			      ctx->image + offset, DA_ELF_MODE_ARM, NULL);
+	}
+
+	return 0;
+}
+
+/* Load the ELF32 ARM image of size bytes. The image is not copied and
+   must not be freed before elf. Return -1 if it is not a valid image. */
+DA_API int
+da_elf_load(da_elf_t *elf, const void *image, size_t size)
+{
+	memset(elf, 0, sizeof(da_elf_t));
+	elf->image = image;
+	elf->size = size;
+
+	const unsigned char *e = image;
+	if (size < EHDR_SIZE || memcmp(e, "\177ELF", 4) != 0 ||
+	    e[EHDR_CLASS] != ELFCLASS32 ||
+	    (e[EHDR_DATA] != ELFDATA2LSB && e[EHDR_DATA] != ELFDATA2MSB)) {
+		return -1;
+	}
+
+	elf_ctx_t ctx;
+	ctx.image = e;
+	ctx.size = size;
+	ctx.msb = (e[EHDR_DATA] == ELFDATA2MSB);
+	if (elf_half(&ctx, EHDR_MACHINE) != EM_ARM) return -1;
+
+	/* BE8 images have little endian instructions */
+	elf->big_endian = ctx.msb &&
+		!(elf_word(&ctx, EHDR_FLAGS) & EF_ARM_BE8);
+	elf->entry = elf_word(&ctx, EHDR_ENTRY);
+
+	size_t phoff = elf_word(&ctx, EHDR_PHOFF);
+	unsigned int phnum = elf_half(&ctx, EHDR_PHNUM);
+	size_t phentsize = elf_half(&ctx, EHDR_PHENTSIZE);
+	if (phnum > 0 && (phentsize < PHDR_SIZE ||
+			  !elf_inside(&ctx, phoff, phnum*phentsize))) {
+		return -1;
+	}
+
+	ctx.shoff = elf_word(&ctx, EHDR_SHOFF);
+	ctx.shnum = elf_half(&ctx, EHDR_SHNUM);
+	ctx.shentsize = elf_half(&ctx, EHDR_SHENTSIZE);
+	unsigned int shstrndx = elf_half(&ctx, EHDR_SHSTRNDX);
+	if (ctx.shoff != 0) {
+		if (ctx.shentsize < SHDR_SIZE ||
+		    !elf_inside(&ctx, ctx.shoff, ctx.shentsize)) return -1;
+
+		/* Large counts are kept in the first section header */
+		if (ctx.shnum == 0) {
+			ctx.shnum = elf_word(&ctx, ctx.shoff + SHDR_SIZE_);
+		}
+		if (shstrndx == SHN_XINDEX) {
+			shstrndx = elf_word(&ctx, ctx.shoff + SHDR_LINK);
+		}
+		if (!elf_inside(&ctx, ctx.shoff,
+				(size_t)ctx.shnum*ctx.shentsize)) return -1;
+	} else {
+		ctx.shnum = 0;
+	}
+
+	elf_map_t *maps = NULL;
+	size_t nmaps = 0;
+	int r = elf_load_syms(elf, &ctx, elf_half(&ctx, EHDR_TYPE) == ET_REL,
+			      &maps, &nmaps);
+	if (r < 0) {
+		free(maps);
+		da_elf_free(elf);
+		return -1;
+	}
+
+	/* Each mapping symbol splits at most one range */
+	elf->ranges = malloc((ctx.shnum + phnum + nmaps + 1)*
+			     sizeof(da_elf_range_t));
+	if (elf->ranges == NULL) {
+		free(maps);
+		da_elf_free(elf);
+		return -1;
+	}
+
+	r = elf_load_sections(elf, &ctx, shstrndx, maps, nmaps);
+	if (r == 0 && elf->nranges == 0) {
+		r = elf_load_segments(elf, &ctx, phoff, phnum, phentsize);
+	}
+	free(maps);
+	if (r < 0) {
+		da_elf_free(elf);
+		return -1;
+	}
+
+	qsort(elf->ranges, elf->nranges, sizeof(da_elf_range_t),
+	      elf_range_cmp);
+	return 0;
+}
+
+/* Load the ELF32 ARM image in file path. The file is mapped to memory if
+   possible. Return -1 on error. */
+DA_API int
+da_elf_open(da_elf_t *elf, const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+
+	size_t size = st.st_size;
+	void *image = NULL;
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+	if (size > 0) {
+		image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (image == MAP_FAILED) image = NULL;
+	}
+	int owned = (image != NULL ? ELF_OWNED_MAP : ELF_OWNED_READ);
+#else
+	int owned = ELF_OWNED_READ;
+#endif
+
+	if (image == NULL) {
+		/* Read the file if it cannot be mapped */
+		image = malloc(size > 0 ? size : 1);
+		size_t len = 0;
+		while (image != NULL && len < size) {
+			ssize_t n = read(fd, (char *)image + len, size - len);
+			if (n <= 0) {
+				free(image);
+				image = NULL;
+			} else {
+				len += n;
+			}
+		}
+	}
+	close(fd);
+	if (image == NULL) return -1;
+
+	int r = da_elf_load(elf, image, size);
+	if (r < 0) {
+		elf->image = image;
+		elf->size = size;
+	}
+	elf->owned = owned;
+	if (r < 0) da_elf_free(elf);
+
+	return r;
+}
+
+DA_API void
+da_elf_free(da_elf_t *elf)
+{
+	free(elf->ranges);
+	free(elf->syms);
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+	if (elf->owned == ELF_OWNED_MAP) {
+		munmap((void *)elf->image, elf->size);
+	}
+#endif
+	if (elf->owned == ELF_OWNED_READ) free((void *)elf->image);
+
+	memset(elf, 0, sizeof(da_elf_t));
+}
+
+/* Return the index of the first symbol at or after address addr, or
+   nsyms if there is none. */
+DA_API size_t
+da_elf_sym_find(const da_elf_t *elf, da_addr_t addr)
+{
+	size_t lo = 0, hi = elf->nsyms;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo)/2;
+		if (elf->syms[mid].addr < addr) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
@@ -0,0 +1,84 @@
+/*
+ * elf.h - ELF image loader header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_ELF_H
+#define _LIBDISARM_ELF_H
+
+#include <stddef.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+DA_BEGIN_DECLS
+
+/* Instruction set of a range, given by the mapping symbols $a, $t and
+   $d. */
+typedef enum {
+	DA_ELF_MODE_ARM = 0,
+	DA_ELF_MODE_THUMB,
+	DA_ELF_MODE_DATA
+} da_elf_mode_t;
+
+/* Part of an executable section or segment, in one mode. The data points
+   into the image. Section is the name of the section or NULL if the
+   range is part of a segment. */
+typedef struct {
+	da_addr_t addr;
+	size_t size;
+	const unsigned char *data;
+	da_elf_mode_t mode;
+	const char *section;
+} da_elf_range_t;
+
+/* Named function, object or label. The name points into the image. Func
+   is nonzero for functions, thumb for Thumb functions. */
+typedef struct {
+	da_addr_t addr;
+	da_uint_t size;
+	const char *name;
+	int func;
+	int thumb;
+} da_elf_sym_t;
+
+/* ELF32 ARM image. Ranges are the executable sections, or executable
+   PT_LOAD segments if the image has no sections, split by mapping
+   symbols and sorted by address. Symbols are sorted by address. Owned
+   is nonzero if the image is released by da_elf_free. */
+typedef struct {
+	const unsigned char *image;
+	size_t size;
+	int owned;
+	int big_endian;
+	da_addr_t entry;
+	da_elf_range_t *ranges;
+	size_t nranges;
+	da_elf_sym_t *syms;
+	size_t nsyms;
+} da_elf_t;
+
+
+int da_elf_open(da_elf_t *elf, const char *path);
+int da_elf_load(da_elf_t *elf, const void *image, size_t size);
+void da_elf_free(da_elf_t *elf);
+size_t da_elf_sym_find(const da_elf_t *elf, da_addr_t addr);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_ELF_H */
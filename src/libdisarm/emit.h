@@ -0,0 +1,141 @@
+/*
+ * emit.h - Text emitter header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_EMIT_H
+#define _LIBDISARM_EMIT_H
+
+#include <string.h>
+
+#include "types.h"
+
+
+/* The emitters write at p without bounds checks and return the new end of
+   the text. Fragments are copied with whole 8-byte stores, so the buffer
+   must have DA_EMIT_SIZE bytes of room for the text of one instruction. */
+#define DA_EMIT_SIZE  128
+
+
+/* Text of up to eight characters, not null terminated */
+typedef struct {
+	char text[8];
+	unsigned char len;
+} da_frag_t;
+
+#define DA_FRAG(s)  { s, sizeof(s) - 1 }
+
+
+static const char da_hex_digit_map[] = "0123456789abcdef";
+
+static const da_frag_t da_reg_frag_map[] = {
+	DA_FRAG("r0"),  DA_FRAG("r1"),  DA_FRAG("r2"),  DA_FRAG("r3"),
+	DA_FRAG("r4"),  DA_FRAG("r5"),  DA_FRAG("r6"),  DA_FRAG("r7"),
+	DA_FRAG("r8"),  DA_FRAG("r9"),  DA_FRAG("r10"), DA_FRAG("r11"),
+	DA_FRAG("r12"), DA_FRAG("r13"), DA_FRAG("r14"), DA_FRAG("r15")
+};
+
+
+static inline char *
+da_emit_frag(char *p, const da_frag_t *frag)
+{
+	memcpy(p, frag->text, sizeof(frag->text));
+	return p + frag->len;
+}
+
+static inline char *
+da_emit_char(char *p, char c)
+{
+	*p = c;
+	return p + 1;
+}
+
+/* Append c only if flag is set. */
+static inline char *
+da_emit_char_if(char *p, char c, int flag)
+{
+	*p = c;
+	return p + (flag != 0);
+}
+
+/* Append string of known length. */
+static inline char *
+da_emit_str(char *p, const char *s, size_t len)
+{
+	memcpy(p, s, len);
+	return p + len;
+}
+
+/* Append "r%d". */
+static inline char *
+da_emit_reg(char *p, da_uint_t reg)
+{
+	return da_emit_frag(p, &da_reg_frag_map[reg & DA_REG_MASK]);
+}
+
+/* Append value as with "%x". */
+static inline char *
+da_emit_hex_digits(char *p, da_uint_t value)
+{
+#ifdef __GNUC__
+	int n = (value ? (35 - __builtin_clz(value)) >> 2 : 1);
+#else
+	int n = 1;
+	while (n < 8 && (value >> (n << 2))) n += 1;
+#endif
+	char *end = p + n;
+	do {
+		*--end = da_hex_digit_map[value & 0xf];
+		value >>= 4;
+	} while (end > p);
+	return p + n;
+}
+
+/* Append value as with "0x%x". */
+static inline char *
+da_emit_hex(char *p, da_uint_t value)
+{
+	p[0] = '0';
+	p[1] = 'x';
+	return da_emit_hex_digits(p + 2, value);
+}
+
+/* Append value as with "%u". */
+static inline char *
+da_emit_dec(char *p, da_uint_t value)
+{
+	if (value < 10) {
+		return da_emit_char(p, '0' + value);
+	} else if (value < 100) {
+		p[0] = '0' + value / 10;
+		p[1] = '0' + value % 10;
+		return p + 2;
+	} else {
+		char digits[10];
+		int n = 0;
+		do {
+			digits[n++] = '0' + (value % 10);
+			value /= 10;
+		} while (value);
+		while (n > 0) *p++ = digits[--n];
+		return p;
+	}
+}
+
+
+#endif /* ! _LIBDISARM_EMIT_H */
@@ -59,28 +59,33 @@
         (((x) & 0xff00000000000000ull) >> 56))
 # endif /* HAVE_BYTESWAP_H */
 
-# ifdef WORDS_BIGENDIAN
-#  define be16toh(x)  (x)
-#  define be32toh(x)  (x)
-#  define be64toh(x)  (x)
-#  define le16toh(x)  bswap16((uint16_t)(x))
-#  define le32toh(x)  bswap32((uint32_t)(x))
-#  define le64toh(x)  bswap64((uint64_t)(x))
-# else /* ! WORDS_BIGENDIAN */
-#  define be16toh(x)  bswap16((uint16_t)(x))
-#  define be32toh(x)  bswap32((uint32_t)(x))
-#  define be64toh(x)  bswap64((uint64_t)(x)) 
-#  define le16toh(x)  (x)
-#  define le32toh(x)  (x)
-#  define le64toh(x)  (x)
-# endif /* WORDS_BIGENDIAN */
+/* The C library may define these already, e.g. glibc in <endian.h> */
+# ifndef be16toh
+#  ifdef WORDS_BIGENDIAN
+#   define be16toh(x)  (x)
+#   define be32toh(x)  (x)
+#   define be64toh(x)  (x)
+#   define le16toh(x)  bswap16((uint16_t)(x))
+#   define le32toh(x)  bswap32((uint32_t)(x))
+#   define le64toh(x)  bswap64((uint64_t)(x))
+#  else /* ! WORDS_BIGENDIAN */
+#   define be16toh(x)  bswap16((uint16_t)(x))
+#   define be32toh(x)  bswap32((uint32_t)(x))
+#   define be64toh(x)  bswap64((uint64_t)(x)) 
+#   define le16toh(x)  (x)
+#   define le32toh(x)  (x)
+#   define le64toh(x)  (x)
+#  endif /* WORDS_BIGENDIAN */
+# endif /* ! be16toh */
 
-# define htobe16(x)  be16toh(x)
-# define htobe32(x)  be32toh(x)
-# define htobe64(x)  be64toh(x)
-# define htole16(x)  le16toh(x)
-# define htole32(x)  le32toh(x)
-# define htole64(x)  le32toh(x)
+# ifndef htobe16
+#  define htobe16(x)  be16toh(x)
+#  define htobe32(x)  be32toh(x)
+#  define htobe64(x)  be64toh(x)
+#  define htole16(x)  le16toh(x)
+#  define htole32(x)  le32toh(x)
+#  define htole64(x)  le32toh(x)
+# endif /* ! htobe16 */
 
 #endif /* HAVE_SYS_ENDIAN_H */
 
@@ -0,0 +1,200 @@
+/*
+ * mktables.c - Lookup table generator
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* This program runs on the build machine and writes C source for the lookup
+   tables used by the library. It must not depend on config.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "group.h"
+#include "names.h"
+#include "thumbtree.h"
+#include "types.h"
+
+
+#define USAGE  "Usage: %s TABLE\n"
+
+
+static void
+print_group_table(FILE *f)
+{
+	int i;
+
+	fprintf(f, "static const unsigned char "
+		"da_group_table[DA_GROUP_TABLE_SIZE] = {");
+	for (i = 0; i < (1 << DA_GROUP_INDEX_BITS); i++) {
+		if (i % 16 == 0) fprintf(f, "\n\t");
+		else fprintf(f, " ");
+		fprintf(f, "%2d,", da_parse_group_tree(DA_GROUP_INDEX_WORD(i)));
+	}
+	fprintf(f, "\n};\n");
+}
+
+/* Group and arguments of every Thumb encoding */
+static void
+print_thumb_table(FILE *f)
+{
+	int i;
+
+	fprintf(f, "static const da_thumb_args_t da_thumb_table[65536] = {");
+	for (i = 0; i < 65536; i++) {
+		da_thumb_args_t args;
+		da_thumb_decode(&args, i);
+
+		if (i % 4 == 0) fprintf(f, "\n\t");
+		else fprintf(f, " ");
+		fprintf(f, "{ %d, %d, %d, %d, %d, %d, %d },", args.group,
+			args.op, args.cond, args.rd, args.rn, args.rm,
+			args.imm);
+	}
+	fprintf(f, "\n};\n");
+}
+
+/* Print text as a da_frag_t initializer. */
+static void
+print_frag(FILE *f, const char *text)
+{
+	size_t len = strlen(text);
+	size_t i;
+
+	if (len > 8) {
+		fprintf(stderr, "Fragment too long: %s\n", text);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(f, "\t{ \"");
+	for (i = 0; i < len; i++) {
+		if (text[i] == '\t') fprintf(f, "\\t");
+		else fputc(text[i], f);
+	}
+	fprintf(f, "\", %d },\n", (int)len);
+}
+
+/* Mnemonic, cond and flags suffix and tab of data processing instructions,
+   indexed by (op << 5) | (cond << 1) | flags. */
+static void
+print_data_op_table(FILE *f)
+{
+	int op, cond, flags;
+
+	fprintf(f, "static const da_frag_t da_data_op_frag_map[] = {\n");
+	for (op = 0; op < DA_DATA_OP_MAX; op++) {
+		for (cond = 0; cond < DA_COND_MAX; cond++) {
+			for (flags = 0; flags < 2; flags++) {
+				char text[16];
+				snprintf(text, sizeof(text), "%s%s%s\t",
+					 da_data_op_map[op], da_cond_map[cond],
+					 ((flags && (op < DA_DATA_OP_TST ||
+						     op > DA_DATA_OP_CMN)) ?
+					  "s" : ""));
+				print_frag(f, text);
+			}
+		}
+	}
+	fprintf(f, "};\n\n");
+}
+
+/* Mnemonic of word and byte load/store instructions, indexed by
+   (load << 6) | (cond << 2) | (byte << 1) | translate. */
+static void
+print_ls_table(FILE *f)
+{
+	int load, cond, byte, translate;
+
+	fprintf(f, "static const da_frag_t da_ls_frag_map[] = {\n");
+	for (load = 0; load < 2; load++) {
+		for (cond = 0; cond < DA_COND_MAX; cond++) {
+			for (byte = 0; byte < 2; byte++) {
+				for (translate = 0; translate < 2;
+				     translate++) {
+					char text[16];
+					snprintf(text, sizeof(text),
+						 "%sr%s%s%s\t",
+						 (load ? "ld" : "st"),
+						 da_cond_map[cond],
+						 (byte ? "b" : ""),
+						 (translate ? "t" : ""));
+					print_frag(f, text);
+				}
+			}
+		}
+	}
+	fprintf(f, "};\n\n");
+}
+
+/* Runs of consecutive registers in each half of a register list. Each
+   run is stored as start | (end << 4). */
+static void
+print_reglist_table(FILE *f)
+{
+	int half;
+
+	fprintf(f, "static const da_reglist_half_t da_reglist_half_map[] = {\n");
+	for (half = 0; half < 256; half++) {
+		int runs[4];
+		int n = 0;
+		int i = 0;
+
+		while (i < 8) {
+			if (half & (1 << i)) {
+				int start = i;
+				while (i < 7 && (half & (1 << (i+1)))) i += 1;
+				runs[n++] = start | (i << 4);
+			}
+			i += 1;
+		}
+
+		fprintf(f, "\t{ %d, {", n);
+		for (i = 0; i < 4; i++) {
+			fprintf(f, " 0x%02x%s", (i < n ? runs[i] : 0),
+				(i < 3 ? "," : ""));
+		}
+		fprintf(f, " } },\n");
+	}
+	fprintf(f, "};\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, USAGE, argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("/* Generated by mktables. Do not edit. */\n\n");
+
+	if (!strcmp(argv[1], "group")) {
+		print_group_table(stdout);
+	} else if (!strcmp(argv[1], "print")) {
+		print_data_op_table(stdout);
+		print_ls_table(stdout);
+		print_reglist_table(stdout);
+	} else if (!strcmp(argv[1], "thumb")) {
+		print_thumb_table(stdout);
+	} else {
+		fprintf(stderr, USAGE, argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	return EXIT_SUCCESS;
+}
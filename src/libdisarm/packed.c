@@ -0,0 +1,207 @@
+/*
+ * packed.c - Packed instruction
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+
+#include "args.h"
+#include "macros.h"
+#include "packed.h"
+#include "parser.h"
+#include "types.h"
+
+
+/* Number of words decoded at a time by da_instr_parse_packed_block */
+#define DA_PACKED_PARSE_SIZE  256
+
+/* Maximum number of argument fields of a group */
+#define DA_PACKED_FIELDS_MAX  12
+
+
+/* Where an argument field is stored */
+typedef enum {
+	DA_PACKED_END = 0,
+	DA_PACKED_COND,
+	DA_PACKED_REG,
+	DA_PACKED_BITS,
+	DA_PACKED_IMM
+} da_packed_kind_t;
+
+typedef struct {
+	unsigned char kind;
+	unsigned char width;
+} da_packed_field_t;
+
+#define C  { DA_PACKED_COND, 4 }
+#define R  { DA_PACKED_REG, 4 }
+#define B(width)  { DA_PACKED_BITS, width }
+#define I  { DA_PACKED_IMM, 32 }
+
+/* Argument fields of each group, in the order of the args structs. All
+   fields of the args structs are 32 bits wide. */
+static const da_packed_field_t
+da_packed_field_map[DA_GROUP_MAX][DA_PACKED_FIELDS_MAX] = {
+	[DA_GROUP_BKPT] = { C, I },
+	[DA_GROUP_BL] = { C, B(1), I },
+	[DA_GROUP_BLX_IMM] = { B(1), I },
+	[DA_GROUP_BLX_REG] = { C, B(1), R },
+	[DA_GROUP_CLZ] = { C, R, R },
+	[DA_GROUP_CP_DATA] = { C, B(4), R, R, B(4), B(3), R },
+	[DA_GROUP_CP_LS] = { C, B(1), B(1), B(1), B(1), B(1), R, R, B(4),
+			     I },
+	[DA_GROUP_CP_REG] = { C, B(3), B(1), R, R, B(4), B(3), R },
+	[DA_GROUP_DATA_IMM] = { C, B(4), B(1), R, R, I },
+	[DA_GROUP_DATA_IMM_SH] = { C, B(4), B(1), R, R, B(5), B(2), R },
+	[DA_GROUP_DATA_REG_SH] = { C, B(4), B(1), R, R, R, B(2), R },
+	[DA_GROUP_DSP_ADD_SUB] = { C, B(2), R, R, R },
+	[DA_GROUP_DSP_MUL] = { C, B(2), R, R, R, B(1), B(1), R },
+	[DA_GROUP_L_SIGN_IMM] = { C, B(1), B(1), R, R, B(1), I },
+	[DA_GROUP_L_SIGN_REG] = { C, B(1), B(1), B(1), R, R, B(1), R },
+	[DA_GROUP_LS_HW_IMM] = { C, B(1), B(1), B(1), R, R, I },
+	[DA_GROUP_LS_HW_REG] = { C, B(1), B(1), B(1), B(1), R, R, R },
+	[DA_GROUP_LS_IMM] = { C, B(1), B(1), B(1), B(1), R, R, I },
+	[DA_GROUP_LS_MULTI] = { C, B(1), B(1), B(1), B(1), B(1), R, I },
+	[DA_GROUP_LS_REG] = { C, B(1), B(1), B(1), B(1), B(1), R, R, B(5),
+			      B(2), R },
+	[DA_GROUP_LS_TWO_IMM] = { C, B(1), B(1), R, R, B(1), I },
+	[DA_GROUP_LS_TWO_REG] = { C, B(1), B(1), B(1), R, R, B(1), R },
+	[DA_GROUP_MRS] = { C, B(1), R },
+	[DA_GROUP_MSR] = { C, B(1), B(4), R },
+	[DA_GROUP_MSR_IMM] = { C, B(1), B(4), I },
+	[DA_GROUP_MUL] = { C, B(1), B(1), R, R, R, R },
+	[DA_GROUP_MULL] = { C, B(1), B(1), B(1), R, R, R, R },
+	[DA_GROUP_SWI] = { C, I },
+	[DA_GROUP_SWP] = { C, B(1), R, R, R }
+};
+
+#undef C
+#undef R
+#undef B
+#undef I
+
+
+DA_API void
+da_instr_pack(da_instr_packed_t *packed, const da_instr_t *instr,
+	      const da_instr_args_t *args)
+{
+	const da_packed_field_t *field = da_packed_field_map[instr->group];
+	const unsigned char *slot = (const unsigned char *)args;
+	unsigned int reg_shift = 0;
+	unsigned int bit_shift = 0;
+
+	packed->group = instr->group;
+	packed->cond = DA_COND_AL;
+	packed->regs = 0;
+	packed->bits = 0;
+	packed->imm = 0;
+
+	for (; field->kind != DA_PACKED_END; field++) {
+		uint32_t value;
+		memcpy(&value, slot, sizeof(value));
+		slot += sizeof(value);
+
+		switch (field->kind) {
+		case DA_PACKED_COND:
+			packed->cond = value;
+			break;
+		case DA_PACKED_REG:
+			packed->regs |= value << reg_shift;
+			reg_shift += 4;
+			break;
+		case DA_PACKED_BITS:
+			packed->bits |= value << bit_shift;
+			bit_shift += field->width;
+			break;
+		case DA_PACKED_IMM:
+			packed->imm = value;
+			break;
+		}
+	}
+}
+
+DA_API void
+da_instr_pack_block(da_instr_packed_t *packed, const da_instr_t *instrs,
+		    const da_instr_args_t *args, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_instr_pack(&packed[i], &instrs[i], &args[i]);
+	}
+}
+
+/* Decode count words to packed instructions. */
+DA_API void
+da_instr_parse_packed_block(da_instr_packed_t *packed, const da_word_t *data,
+			    size_t count, int big_endian)
+{
+	da_instr_t instrs[DA_PACKED_PARSE_SIZE];
+	da_instr_args_t args[DA_PACKED_PARSE_SIZE];
+
+	while (count > 0) {
+		size_t n = (count < DA_PACKED_PARSE_SIZE ? count :
+			    DA_PACKED_PARSE_SIZE);
+
+		da_instr_parse_block(instrs, data, n, big_endian);
+		da_instr_parse_args_block(args, instrs, n);
+		da_instr_pack_block(packed, instrs, args, n);
+
+		packed += n;
+		data += n;
+		count -= n;
+	}
+}
+
+/* Unpack the arguments of packed instruction. Fields of args that are not
+   used by the group are left unchanged. */
+DA_API void
+da_instr_unpack_args(da_instr_args_t *args, const da_instr_packed_t *packed)
+{
+	const da_packed_field_t *field = da_packed_field_map[packed->group];
+	unsigned char *slot = (unsigned char *)args;
+	uint32_t regs = packed->regs;
+	uint32_t bits = packed->bits;
+
+	for (; field->kind != DA_PACKED_END; field++) {
+		uint32_t value = 0;
+
+		switch (field->kind) {
+		case DA_PACKED_COND:
+			value = packed->cond;
+			break;
+		case DA_PACKED_REG:
+			value = regs & DA_REG_MASK;
+			regs >>= 4;
+			break;
+		case DA_PACKED_BITS:
+			value = bits & ((1 << field->width) - 1);
+			bits >>= field->width;
+			break;
+		case DA_PACKED_IMM:
+			value = packed->imm;
+			break;
+		}
+
+		memcpy(slot, &value, sizeof(value));
+		slot += sizeof(value);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * packed.h - Packed instruction header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_PACKED_H
+#define _LIBDISARM_PACKED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+DA_BEGIN_DECLS
+
+/* Decoded instruction in 12 bytes. The argument fields of the group are
+   stored in order: registers in the nibbles of regs, from the lowest,
+   flags and other small fields in bits, from the lowest bit, and the
+   widest field, if any, in imm. */
+typedef struct {
+	uint8_t group;
+	uint8_t cond;
+	uint16_t regs;
+	uint32_t bits;
+	int32_t imm;
+} da_instr_packed_t;
+
+
+void da_instr_pack(da_instr_packed_t *packed, const da_instr_t *instr,
+		   const da_instr_args_t *args);
+void da_instr_pack_block(da_instr_packed_t *packed,
+			 const da_instr_t *instrs,
+			 const da_instr_args_t *args, size_t count);
+void da_instr_parse_packed_block(da_instr_packed_t *packed,
+				 const da_word_t *data, size_t count,
+				 int big_endian);
+
+void da_instr_unpack_args(da_instr_args_t *args,
+			  const da_instr_packed_t *packed);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_PACKED_H */
@@ -0,0 +1,493 @@
+/*
+ * pagecache.c - On-disk cache of rendered pages
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "args.h"
+#include "emit.h"
+#include "macros.h"
+#include "pagecache.h"
+#include "parser.h"
+#include "print.h"
+#include "types.h"
+
+/* Entry header: magic, version, big endian flag, count and text size.
+   The magic is in host byte order so entries of hosts with the other
+   byte order are misses. The version is changed when the printed text
+   changes; it is part of the hash so old entries are just evicted. */
+#define DA_PAGE_MAGIC    0x43504144
+#define DA_PAGE_VERSION  2
+#define DA_PAGE_HEADER   5
+
+/* Name of an entry: hash in hex followed by the suffix */
+#define DA_PAGE_SUFFIX    ".dapc"
+#define DA_PAGE_NAME_LEN  (16 + sizeof(DA_PAGE_SUFFIX) - 1)
+
+/* Size of a path of an entry or temporary file */
+#define DA_PAGE_PATH_SIZE  (DA_PAGE_CACHE_DIR_MAX + 32)
+
+/* Seconds between updates of the time of use of an entry */
+#define DA_PAGE_TOUCH_INTERVAL  60
+
+/* Prefix of temporary files and seconds after which one is taken to be
+   left by a run that was killed */
+#define DA_PAGE_TMP_PREFIX  "tmp-"
+#define DA_PAGE_TMP_AGE     3600
+
+/* Size that a store exceeding max bytes trims the cache to, below max
+   so the stores that follow do not trim it again */
+#define DA_PAGE_TRIM(max)  ((max) - (max)/10)
+
+/* Number of words decoded at a time */
+#define DA_PAGE_CHUNK  256
+
+/* Counters are shared by the threads rendering pages */
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+# define DA_ADD(p, v)  __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+# define DA_TRYLOCK(p)  (__atomic_exchange_n(p, 1, __ATOMIC_ACQUIRE) == 0)
+# define DA_UNLOCK(p)  __atomic_store_n(p, 0, __ATOMIC_RELEASE)
+#else
+# define DA_ADD(p, v)  (*(p) += (v))
+# define DA_TRYLOCK(p)  (*(p) == 0 && (*(p) = 1))
+# define DA_UNLOCK(p)  (*(p) = 0)
+#endif
+
+/* Entry file found when scanning the cache directory */
+typedef struct {
+	time_t mtime;
+	off_t size;
+	char name[DA_PAGE_NAME_LEN + 1];
+} da_page_file_t;
+
+
+/* Return the hash of count words. The hash only selects the entry; the
+   words are compared on lookup. */
+static uint64_t
+da_page_hash(const da_word_t *words, size_t count, int big_endian)
+{
+	uint64_t h = 0x9e3779b97f4a7c15ull ^ ((uint64_t)count << 8) ^
+		(DA_PAGE_VERSION << 1) ^ (big_endian != 0);
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		h = (h ^ words[i]) * 0xff51afd7ed558ccdull;
+		h ^= h >> 29;
+	}
+
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+/* Return the size of the fixed part of an entry of count words. */
+static size_t
+da_page_fixed_size(size_t count)
+{
+	return (DA_PAGE_HEADER + count + (count + 1) + 3*count) *
+		sizeof(uint32_t);
+}
+
+/* Make room for size bytes in the buffer of page. */
+static int
+da_page_reserve(da_page_t *page, size_t size)
+{
+	if (size <= page->alloc) return 0;
+
+	unsigned char *buf = realloc(page->buf, size);
+	if (buf == NULL) return -1;
+	page->buf = buf;
+	page->alloc = size;
+	return 0;
+}
+
+/* Point the fields of page into the entry of count words in its
+   buffer. */
+static void
+da_page_set(da_page_t *page, size_t count)
+{
+	const uint32_t *p = (const uint32_t *)page->buf + DA_PAGE_HEADER;
+	page->count = count;
+	page->words = p;
+	page->offsets = p + count;
+	page->rels = p + 2*count + 1;
+	page->text = (const char *)(p + 5*count + 1);
+}
+
+DA_API void
+da_page_init(da_page_t *page)
+{
+	memset(page, 0, sizeof(da_page_t));
+}
+
+DA_API void
+da_page_free(da_page_t *page)
+{
+	free(page->buf);
+	memset(page, 0, sizeof(da_page_t));
+}
+
+/* Decode and print count words into the buffer of page. Return the size
+   of the entry or -1 if out of memory. */
+static ssize_t
+da_page_build(da_page_t *page, const da_word_t *words, size_t count,
+	      int big_endian)
+{
+	size_t fixed = da_page_fixed_size(count);
+	if (da_page_reserve(page, fixed + count*DA_EMIT_SIZE) < 0) return -1;
+
+	uint32_t *header = (uint32_t *)page->buf;
+	uint32_t *offsets = header + DA_PAGE_HEADER + count;
+	uint32_t *rels = offsets + count + 1;
+	char *text = (char *)(rels + 3*count);
+	memcpy(header + DA_PAGE_HEADER, words, count*sizeof(da_word_t));
+
+	da_instr_t instrs[DA_PAGE_CHUNK];
+	da_instr_args_t args[DA_PAGE_CHUNK];
+	size_t used = 0;
+	size_t i, j;
+	for (i = 0; i < count; i += DA_PAGE_CHUNK) {
+		size_t n = (count - i < DA_PAGE_CHUNK ? count - i :
+			    DA_PAGE_CHUNK);
+		da_instr_parse_block(instrs, words + i, n, big_endian);
+		da_instr_parse_args_block(args, instrs, n);
+
+		for (j = 0; j < n; j++) {
+			da_instr_rel_t rel;
+			offsets[i + j] = used;
+			used += da_instr_snprint_rel(text + used, DA_EMIT_SIZE,
+						     &instrs[j], &args[j],
+						     &rel);
+			rels[3*(i + j)] = rel.present;
+			rels[3*(i + j) + 1] = rel.delta;
+			rels[3*(i + j) + 2] = rel.bits;
+		}
+	}
+	offsets[count] = used;
+
+	header[0] = DA_PAGE_MAGIC;
+	header[1] = DA_PAGE_VERSION;
+	header[2] = (big_endian != 0);
+	header[3] = count;
+	header[4] = used;
+
+	da_page_set(page, count);
+	return fixed + used;
+}
+
+/* Read the entry in path into page. Return 1 if it holds count words
+   equal to words, 0 if not or if the entry is corrupt. */
+static int
+da_page_load(da_page_t *page, const char *path, const da_word_t *words,
+	     size_t count, int big_endian)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return 0;
+
+	struct stat st;
+	size_t fixed = da_page_fixed_size(count);
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < fixed ||
+	    (size_t)st.st_size > fixed + count*DA_EMIT_SIZE ||
+	    da_page_reserve(page, st.st_size) < 0) {
+		close(fd);
+		return 0;
+	}
+
+	size_t size = st.st_size;
+	size_t len = 0;
+	while (len < size) {
+		ssize_t r = read(fd, page->buf + len, size - len);
+		if (r <= 0) break;
+		len += r;
+	}
+	close(fd);
+	if (len < size) return 0;
+
+	const uint32_t *header = (const uint32_t *)page->buf;
+	if (header[0] != DA_PAGE_MAGIC || header[1] != DA_PAGE_VERSION ||
+	    header[2] != (big_endian != 0) || header[3] != count ||
+	    header[4] != size - fixed ||
+	    memcmp(header + DA_PAGE_HEADER, words,
+		   count*sizeof(da_word_t)) != 0) {
+		return 0;
+	}
+
+	/* The text of each word must lie in the text of the entry and fit
+	   in the output line of the instruction */
+	da_page_set(page, count);
+	const uint32_t *offsets = page->offsets;
+	if (offsets[0] != 0 || offsets[count] != header[4]) return 0;
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		if (offsets[i+1] < offsets[i] ||
+		    offsets[i+1] - offsets[i] > DA_EMIT_SIZE) {
+			return 0;
+		}
+	}
+
+	/* Entries that are used are kept longer */
+	if (st.st_mtime + DA_PAGE_TOUCH_INTERVAL < time(NULL)) {
+		utime(path, NULL);
+	}
+
+	return 1;
+}
+
+/* Return true if name is the name of an entry. */
+static int
+da_page_is_entry(const char *name)
+{
+	return strlen(name) == DA_PAGE_NAME_LEN &&
+		strcmp(name + 16, DA_PAGE_SUFFIX) == 0;
+}
+
+/* Return true if name is the name of a temporary file. */
+static int
+da_page_is_tmp(const char *name)
+{
+	return strncmp(name, DA_PAGE_TMP_PREFIX,
+		       sizeof(DA_PAGE_TMP_PREFIX) - 1) == 0;
+}
+
+/* Find the entries of cache. Set files to a list of them, which must be
+   freed, if it is not NULL. Return the number of entries, or -1 on
+   error, and set the size of the cache to their total size. Old
+   temporary files are removed. */
+static ssize_t
+da_page_cache_scan(da_page_cache_t *cache, da_page_file_t **files)
+{
+	DIR *dir = opendir(cache->dir);
+	if (dir == NULL) return -1;
+
+	da_page_file_t *list = NULL;
+	size_t count = 0, alloc = 0;
+	unsigned long long total = 0;
+
+	time_t now = time(NULL);
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL) {
+		int tmp = da_page_is_tmp(ent->d_name);
+		if (!tmp && !da_page_is_entry(ent->d_name)) continue;
+
+		char path[DA_PAGE_PATH_SIZE];
+		struct stat st;
+		snprintf(path, sizeof(path), "%s/%s", cache->dir, ent->d_name);
+		if (stat(path, &st) < 0 || !S_ISREG(st.st_mode)) continue;
+
+		if (tmp) {
+			if (st.st_mtime + DA_PAGE_TMP_AGE < now) unlink(path);
+			continue;
+		}
+
+		total += st.st_size;
+		if (files == NULL) {
+			count += 1;
+			continue;
+		}
+
+		if (count == alloc) {
+			alloc = (alloc > 0 ? 2*alloc : 256);
+			da_page_file_t *l = realloc(list, alloc*
+						    sizeof(da_page_file_t));
+			if (l == NULL) {
+				free(list);
+				closedir(dir);
+				return -1;
+			}
+			list = l;
+		}
+
+		da_page_file_t *file = &list[count++];
+		file->mtime = st.st_mtime;
+		file->size = st.st_size;
+		strcpy(file->name, ent->d_name);
+	}
+
+	closedir(dir);
+	cache->size = total;
+	if (files != NULL) *files = list;
+	return count;
+}
+
+static int
+da_page_file_cmp(const void *a, const void *b)
+{
+	const da_page_file_t *fa = a;
+	const da_page_file_t *fb = b;
+	if (fa->mtime != fb->mtime) return fa->mtime < fb->mtime ? -1 : 1;
+	return strcmp(fa->name, fb->name);
+}
+
+/* Remove the least recently used entries until the cache takes at most
+   limit bytes. Return -1 on error. */
+static int
+da_page_cache_trim(da_page_cache_t *cache, unsigned long long limit)
+{
+	da_page_file_t *files;
+	ssize_t count = da_page_cache_scan(cache, &files);
+	if (count < 0) return -1;
+
+	qsort(files, count, sizeof(da_page_file_t), da_page_file_cmp);
+
+	ssize_t i;
+	for (i = 0; i < count && cache->size > limit; i++) {
+		char path[DA_PAGE_PATH_SIZE];
+		snprintf(path, sizeof(path), "%s/%s", cache->dir,
+			 files[i].name);
+		if (unlink(path) == 0 || errno == ENOENT) {
+			cache->size -= files[i].size;
+		}
+	}
+
+	free(files);
+	return 0;
+}
+
+/* Write the entry of size bytes in page to path. Errors are ignored;
+   the entry is written to a temporary file first so readers never see
+   part of it. */
+static void
+da_page_store(da_page_cache_t *cache, const da_page_t *page, size_t size,
+	      const char *path)
+{
+	char tmp[DA_PAGE_PATH_SIZE];
+	snprintf(tmp, sizeof(tmp), "%s/" DA_PAGE_TMP_PREFIX "XXXXXX",
+		 cache->dir);
+	int fd = mkstemp(tmp);
+	if (fd < 0) return;
+
+	size_t len = 0;
+	while (len < size) {
+		ssize_t r = write(fd, page->buf + len, size - len);
+		if (r <= 0) break;
+		len += r;
+	}
+
+	/* An entry written by another run may be replaced */
+	struct stat st;
+	off_t old_size = 0;
+	if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+		old_size = st.st_size;
+	}
+
+	if (close(fd) < 0 || len < size || rename(tmp, path) < 0) {
+		unlink(tmp);
+		return;
+	}
+
+	DA_ADD(&cache->size, size - old_size);
+
+	/* One thread at a time removes entries while the others go on */
+	if (cache->size > cache->max_size && DA_TRYLOCK(&cache->evicting)) {
+		da_page_cache_trim(cache, DA_PAGE_TRIM(cache->max_size));
+		DA_UNLOCK(&cache->evicting);
+	}
+}
+
+/* Set page to the text of count words, read from cache or rendered and
+   added to it. cache may be NULL to only render. Return 1 if the page
+   was cached, 0 if it was rendered or -1 if out of memory. */
+DA_API int
+da_page_cache_render(da_page_cache_t *cache, da_page_t *page,
+		     const da_word_t *words, size_t count, int big_endian)
+{
+	char path[DA_PAGE_PATH_SIZE];
+
+	if (cache != NULL) {
+		snprintf(path, sizeof(path), "%s/%016llx" DA_PAGE_SUFFIX,
+			 cache->dir, (unsigned long long)
+			 da_page_hash(words, count, big_endian));
+		if (da_page_load(page, path, words, count, big_endian)) {
+			DA_ADD(&cache->hits, 1);
+			return 1;
+		}
+		DA_ADD(&cache->misses, 1);
+	}
+
+	ssize_t size = da_page_build(page, words, count, big_endian);
+	if (size < 0) return -1;
+
+	if (cache != NULL) da_page_store(cache, page, size, path);
+	return 0;
+}
+
+/* Open the cache in directory dir, which is created if it does not
+   exist, of at most max_size bytes. Return -1 on error. */
+DA_API int
+da_page_cache_open(da_page_cache_t *cache, const char *dir,
+		   unsigned long long max_size)
+{
+	memset(cache, 0, sizeof(da_page_cache_t));
+
+	size_t len = strlen(dir);
+	if (len > DA_PAGE_CACHE_DIR_MAX) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	if (mkdir(dir, 0777) < 0 && errno != EEXIST) return -1;
+
+	cache->dir = malloc(len + 1);
+	if (cache->dir == NULL) return -1;
+	memcpy(cache->dir, dir, len + 1);
+	cache->max_size = max_size;
+
+	if (da_page_cache_scan(cache, NULL) < 0) {
+		free(cache->dir);
+		cache->dir = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Remove the least recently used entries until the cache takes at most
+   max_size bytes. Return -1 on error. */
+DA_API int
+da_page_cache_evict(da_page_cache_t *cache)
+{
+	return da_page_cache_trim(cache, cache->max_size);
+}
+
+/* Evict entries if the cache is too large and free it. */
+DA_API void
+da_page_cache_close(da_page_cache_t *cache)
+{
+	if (cache->dir != NULL && cache->size > cache->max_size) {
+		da_page_cache_evict(cache);
+	}
+	free(cache->dir);
+	memset(cache, 0, sizeof(da_page_cache_t));
+}
@@ -0,0 +1,100 @@
+/*
+ * pagecache.h - On-disk cache of rendered pages header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_PAGECACHE_H
+#define _LIBDISARM_PAGECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/print.h>
+#include <libdisarm/types.h>
+
+
+/* Words in a page, 4 KB */
+#define DA_PAGE_CACHE_WORDS  1024
+
+/* Longest cache directory name */
+#define DA_PAGE_CACHE_DIR_MAX  4000
+
+DA_BEGIN_DECLS
+
+/* Address independent text of count words, in the format of a cache
+   entry held in buf: the words, then count + 1 text offsets, then three
+   words of da_instr_rel_t per word and then the text. The text of word i
+   is text[offsets[i]..offsets[i+1]) and is followed by the address
+   described by rels[3*i..3*i+2]. */
+typedef struct {
+	size_t count;
+	const da_word_t *words;
+	const uint32_t *offsets;
+	const uint32_t *rels;
+	const char *text;
+	unsigned char *buf;
+	size_t alloc;
+} da_page_t;
+
+/* Directory of pages keyed by a hash of their words. Pages are written
+   by da_page_cache_render and the least recently used are removed when
+   the entries take more than max_size bytes, by the store that exceeds
+   it and by da_page_cache_close. */
+typedef struct {
+	char *dir;
+	unsigned long long max_size;
+	unsigned long long size;
+	int evicting;
+
+	unsigned long hits;
+	unsigned long misses;
+} da_page_cache_t;
+
+
+int da_page_cache_open(da_page_cache_t *cache, const char *dir,
+		       unsigned long long max_size);
+void da_page_cache_close(da_page_cache_t *cache);
+int da_page_cache_evict(da_page_cache_t *cache);
+
+void da_page_init(da_page_t *page);
+void da_page_free(da_page_t *page);
+int da_page_cache_render(da_page_cache_t *cache, da_page_t *page,
+			 const da_word_t *words, size_t count,
+			 int big_endian);
+
+/* Return the text of word i of page and its length in len. */
+static inline const char *
+da_page_text(const da_page_t *page, size_t i, size_t *len)
+{
+	*len = page->offsets[i+1] - page->offsets[i];
+	return page->text + page->offsets[i];
+}
+
+/* Get the description of the address after the text of word i. */
+static inline void
+da_page_rel(const da_page_t *page, size_t i, da_instr_rel_t *rel)
+{
+	rel->present = page->rels[3*i];
+	rel->delta = page->rels[3*i+1];
+	rel->bits = page->rels[3*i+2];
+}
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_PAGECACHE_H */
@@ -27,111 +27,381 @@
 #include <assert.h>
 
 #include "endian.h"
+#include "group.h"
 #include "macros.h"
+#include "names.h"
+#include "parser.h"
 #include "types.h"
 
+#if defined(DA_SIMD) && defined(HAVE_EMMINTRIN_H) && defined(__SSE2__)
+# define DA_SIMD_SSE2  1
+# include <emmintrin.h>
+# if defined(HAVE_IMMINTRIN_H) && defined(__GNUC__) &&  \
+	(__GNUC__ >= 5 || defined(__clang__))
+#  define DA_SIMD_AVX2  1
+#  include <immintrin.h>
+# endif
+#endif
+
+
+/* Number of words converted per pass in da_instr_parse_block */
+#define DA_PARSE_BLOCK_SIZE  256
+
+
+#ifdef DA_GROUP_TABLE
+
+/* Generated by mktables from the decode tree in group.h */
+# include "group_table.h"
 
-/* Figure 3-2 in ARM Architecture Reference */
 static da_group_t
-da_parse_group_mul_ls(da_word_t data)
-{
-	if ((data >> 6) & 1) {
-		if ((data >> 20) & 1) {
-			if ((data >> 22) & 1) {
-				return DA_GROUP_L_SIGN_IMM;
-			} else return DA_GROUP_L_SIGN_REG;
-		} else if ((data >> 22) & 1) {
-			return DA_GROUP_LS_TWO_IMM;
-		} else return DA_GROUP_LS_TWO_REG;
-	} else {
-		if ((data >> 5) & 1) {
-			if ((data >> 22) & 1) {
-				return DA_GROUP_LS_HW_IMM;
-			} else return DA_GROUP_LS_HW_REG;
-		} else {
-			if ((data >> 24) & 1) return DA_GROUP_SWP;
-			else if ((data >> 23) & 1) {
-				return DA_GROUP_MULL;
-			} else return DA_GROUP_MUL;
-		}
-	}
+da_parse_group(da_word_t data)
+{
+	return da_group_table[DA_GROUP_INDEX(data)];
 }
 
+#else /* ! DA_GROUP_TABLE */
+
 static da_group_t
-da_parse_group_type_0(da_word_t data)
-{
-	if ((data >> 4) & 1) {
-		if ((data >> 7) & 1) return da_parse_group_mul_ls(data);
-		else if ((((data >> 23) & 0x3) == 0x2) &&
-			 (((data >> 20) & 1) == 0)) {
-			if ((data >> 6) & 1) {
-				if ((data >> 5) & 1) return DA_GROUP_BKPT;
-				else return DA_GROUP_DSP_ADD_SUB;
-			} else {
-				if ((data >> 22) & 1) return DA_GROUP_CLZ;
-				else return DA_GROUP_BLX_REG;
-			}
-		} else return DA_GROUP_DATA_REG_SH;
-	} else {
-		if ((((data >> 23) & 0x3) == 0x2) &&
-		    (((data >> 20) & 1) == 0)) {
-			if ((data >> 7) & 1) return DA_GROUP_DSP_MUL;
-			else if ((data >> 21) & 1) return DA_GROUP_MSR;
-			else return DA_GROUP_MRS;
-		} else return DA_GROUP_DATA_IMM_SH;
-	}
+da_parse_group(da_word_t data)
+{
+	return da_parse_group_tree(data);
 }
 
-static da_group_t
-da_parse_group_cond(da_word_t data)
-{
-	switch ((data >> 25) & 0x7) {
-	case 0: return da_parse_group_type_0(data);
-	case 1:
-		if ((((data >> 23) & 0x3) == 0x2) &&
-		    (((data >> 20) & 1) == 0)) {
-			if ((data >> 21) & 1) {
-				return DA_GROUP_MSR_IMM;
-			} else return DA_GROUP_UNDEF_1;
-		} else return DA_GROUP_DATA_IMM;
-	case 2: return DA_GROUP_LS_IMM;
-	case 3:
-		if ((data >> 4) & 1) return DA_GROUP_UNDEF_2;
-		else return DA_GROUP_LS_REG;
-	case 4: return DA_GROUP_LS_MULTI;
-	case 5: return DA_GROUP_BL;
-	case 6: return DA_GROUP_CP_LS;
-	case 7:
-		if ((data >> 24) & 1) return DA_GROUP_SWI;
-		else if ((data >> 4) & 1) return DA_GROUP_CP_REG;
-		else return DA_GROUP_CP_DATA;
-	default:
-		assert(0); /* Control shouldn't reach here. */
+#endif /* DA_GROUP_TABLE */
+
+
+/* Names of the groups, as the members of da_instr_args_t */
+static const char *const da_group_names[DA_GROUP_MAX] = {
+	[DA_GROUP_BKPT] = "bkpt",
+	[DA_GROUP_BL] = "bl",
+	[DA_GROUP_BLX_IMM] = "blx_imm",
+	[DA_GROUP_BLX_REG] = "blx_reg",
+	[DA_GROUP_CLZ] = "clz",
+	[DA_GROUP_CP_DATA] = "cp_data",
+	[DA_GROUP_CP_LS] = "cp_ls",
+	[DA_GROUP_CP_REG] = "cp_reg",
+	[DA_GROUP_DATA_IMM] = "data_imm",
+	[DA_GROUP_DATA_IMM_SH] = "data_imm_sh",
+	[DA_GROUP_DATA_REG_SH] = "data_reg_sh",
+	[DA_GROUP_DSP_ADD_SUB] = "dsp_add_sub",
+	[DA_GROUP_DSP_MUL] = "dsp_mul",
+	[DA_GROUP_L_SIGN_IMM] = "l_sign_imm",
+	[DA_GROUP_L_SIGN_REG] = "l_sign_reg",
+	[DA_GROUP_LS_HW_IMM] = "ls_hw_imm",
+	[DA_GROUP_LS_HW_REG] = "ls_hw_reg",
+	[DA_GROUP_LS_IMM] = "ls_imm",
+	[DA_GROUP_LS_MULTI] = "ls_multi",
+	[DA_GROUP_LS_REG] = "ls_reg",
+	[DA_GROUP_LS_TWO_IMM] = "ls_two_imm",
+	[DA_GROUP_LS_TWO_REG] = "ls_two_reg",
+	[DA_GROUP_MRS] = "mrs",
+	[DA_GROUP_MSR] = "msr",
+	[DA_GROUP_MSR_IMM] = "msr_imm",
+	[DA_GROUP_MUL] = "mul",
+	[DA_GROUP_MULL] = "mull",
+	[DA_GROUP_SWI] = "swi",
+	[DA_GROUP_SWP] = "swp",
+	[DA_GROUP_UNDEF_1] = "undef_1",
+	[DA_GROUP_UNDEF_2] = "undef_2",
+	[DA_GROUP_UNDEF_3] = "undef_3",
+	[DA_GROUP_UNDEF_4] = "undef_4",
+	[DA_GROUP_UNDEF_5] = "undef_5"
+};
+
+
+DA_API void
+da_instr_parse(da_instr_t *instr, da_word_t data, int big_endian)
+{
+	instr->data = (big_endian ? be32toh(data) : le32toh(data));
+	instr->group = da_parse_group(instr->data);
+}
+
+/* Convert words to host byte order. These loops have no branches in the body
+   so the compiler can turn them into vector byte swaps. */
+static void
+da_words_be32toh(da_word_t *dest, const da_word_t *src, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) dest[i] = be32toh(src[i]);
+}
+
+static void
+da_words_le32toh(da_word_t *dest, const da_word_t *src, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) dest[i] = le32toh(src[i]);
+}
+
+#if defined(DA_SIMD_SSE2) && !defined(DA_GROUP_TABLE)
+
+/* Vector version of the decode tree in group.h for builds without the group
+   table. The group index of eight words is held in 16-bit lanes and every
+   branch of the tree is evaluated in each lane, with the results merged
+   through compare masks. */
+
+static inline __m128i
+da_sse2_bit(__m128i x, int bit)
+{
+	__m128i m = _mm_set1_epi16(1 << bit);
+	return _mm_cmpeq_epi16(_mm_and_si128(x, m), m);
+}
+
+static inline __m128i
+da_sse2_match(__m128i x, int mask, int value)
+{
+	return _mm_cmpeq_epi16(_mm_and_si128(x, _mm_set1_epi16(mask)),
+			       _mm_set1_epi16(value));
+}
+
+static inline __m128i
+da_sse2_sel(__m128i m, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+static inline __m128i
+da_sse2_selc(__m128i m, int a, int b)
+{
+	return _mm_xor_si128(_mm_set1_epi16(b),
+			     _mm_and_si128(m, _mm_set1_epi16(a ^ b)));
+}
+
+static inline __m128i
+da_sse2_index(__m128i w)
+{
+	__m128i nv = _mm_cmpeq_epi32(_mm_srli_epi32(w, 28),
+				     _mm_set1_epi32(0xf));
+	return _mm_or_si128(_mm_and_si128(nv, _mm_set1_epi32(0x1000)),
+			    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(w, 16),
+						       _mm_set1_epi32(0xff0)),
+					 _mm_and_si128(_mm_srli_epi32(w, 4),
+						       _mm_set1_epi32(0xf))));
+}
+
+static inline __m128i
+da_sse2_group(__m128i x)
+{
+	__m128i b4 = da_sse2_bit(x, 0);
+	__m128i b5 = da_sse2_bit(x, 1);
+	__m128i b6 = da_sse2_bit(x, 2);
+	__m128i b7 = da_sse2_bit(x, 3);
+	__m128i b20 = da_sse2_bit(x, 4);
+	__m128i b21 = da_sse2_bit(x, 5);
+	__m128i b22 = da_sse2_bit(x, 6);
+	__m128i b23 = da_sse2_bit(x, 7);
+	__m128i b24 = da_sse2_bit(x, 8);
+	/* Bits 24-23 are 10 and bit 20 is clear */
+	__m128i misc = da_sse2_match(x, 0x190, 0x100);
+
+	__m128i mul_ls =
+		da_sse2_sel(b6,
+			    da_sse2_sel(b20,
+					da_sse2_selc(b22, DA_GROUP_L_SIGN_IMM,
+						     DA_GROUP_L_SIGN_REG),
+					da_sse2_selc(b22, DA_GROUP_LS_TWO_IMM,
+						     DA_GROUP_LS_TWO_REG)),
+			    da_sse2_sel(b5,
+					da_sse2_selc(b22, DA_GROUP_LS_HW_IMM,
+						     DA_GROUP_LS_HW_REG),
+					da_sse2_sel(b24,
+						    _mm_set1_epi16(DA_GROUP_SWP),
+						    da_sse2_selc(b23,
+								 DA_GROUP_MULL,
+								 DA_GROUP_MUL))));
+	__m128i type_0_reg =
+		da_sse2_sel(misc,
+			    da_sse2_sel(b6,
+					da_sse2_selc(b5, DA_GROUP_BKPT,
+						     DA_GROUP_DSP_ADD_SUB),
+					da_sse2_selc(b22, DA_GROUP_CLZ,
+						     DA_GROUP_BLX_REG)),
+			    _mm_set1_epi16(DA_GROUP_DATA_REG_SH));
+	__m128i type_0_imm =
+		da_sse2_sel(misc,
+			    da_sse2_sel(b7, _mm_set1_epi16(DA_GROUP_DSP_MUL),
+					da_sse2_selc(b21, DA_GROUP_MSR,
+						     DA_GROUP_MRS)),
+			    _mm_set1_epi16(DA_GROUP_DATA_IMM_SH));
+
+	__m128i r = da_sse2_sel(b4, da_sse2_sel(b7, mul_ls, type_0_reg),
+				type_0_imm);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0x200),
+			da_sse2_sel(misc, da_sse2_selc(b21, DA_GROUP_MSR_IMM,
+						       DA_GROUP_UNDEF_1),
+				    _mm_set1_epi16(DA_GROUP_DATA_IMM)), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0x400),
+			_mm_set1_epi16(DA_GROUP_LS_IMM), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0x600),
+			da_sse2_selc(b4, DA_GROUP_UNDEF_2, DA_GROUP_LS_REG), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0x800),
+			_mm_set1_epi16(DA_GROUP_LS_MULTI), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0xa00),
+			_mm_set1_epi16(DA_GROUP_BL), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0xc00),
+			_mm_set1_epi16(DA_GROUP_CP_LS), r);
+	r = da_sse2_sel(da_sse2_match(x, 0xe00, 0xe00),
+			da_sse2_sel(b24, _mm_set1_epi16(DA_GROUP_SWI),
+				    da_sse2_selc(b4, DA_GROUP_CP_REG,
+						 DA_GROUP_CP_DATA)), r);
+
+	/* Unconditional instructions */
+	__m128i u = _mm_set1_epi16(DA_GROUP_UNDEF_3);
+	u = da_sse2_sel(da_sse2_match(x, 0xe00, 0x800),
+			_mm_set1_epi16(DA_GROUP_UNDEF_4), u);
+	u = da_sse2_sel(da_sse2_match(x, 0xe00, 0xa00),
+			_mm_set1_epi16(DA_GROUP_BLX_IMM), u);
+	u = da_sse2_sel(da_sse2_match(x, 0xc00, 0xc00),
+			_mm_set1_epi16(DA_GROUP_UNDEF_5), u);
+
+	return da_sse2_sel(da_sse2_bit(x, 12), u, r);
+}
+
+/* Classify 16 words per iteration, return number of words done. */
+static size_t
+da_parse_groups_sse2(unsigned char *groups, const da_word_t *data,
+		     size_t count)
+{
+	size_t i;
+	for (i = 0; i + 16 <= count; i += 16) {
+		const __m128i *p = (const __m128i *)&data[i];
+		__m128i lo = _mm_packs_epi32(
+			da_sse2_index(_mm_loadu_si128(p)),
+			da_sse2_index(_mm_loadu_si128(p + 1)));
+		__m128i hi = _mm_packs_epi32(
+			da_sse2_index(_mm_loadu_si128(p + 2)),
+			da_sse2_index(_mm_loadu_si128(p + 3)));
+		_mm_storeu_si128((__m128i *)&groups[i],
+				 _mm_packus_epi16(da_sse2_group(lo),
+						  da_sse2_group(hi)));
 	}
+
+	return i;
 }
 
-static da_group_t
-da_parse_group(da_word_t data)
+#endif /* DA_SIMD_SSE2 && ! DA_GROUP_TABLE */
+
+#if defined(DA_SIMD_AVX2) && defined(DA_GROUP_TABLE)
+
+/* The group index of eight words is computed lane-wise and the groups are
+   fetched from the table with a gather. Each gather reads 32 bits at a byte
+   offset, which is why the table is padded and the loads are masked. The
+   packs work within 128-bit halves, so the result is put back in word order
+   with a final dword permute. Return number of words done. */
+static __attribute__ ((__target__("avx2"))) size_t
+da_parse_groups_avx2(unsigned char *groups, const da_word_t *data,
+		     size_t count)
 {
-	switch ((data >> 28) & 0xf) {
-	case 0xf:
-		switch ((data >> 25) & 0x7) {
-		case 0: 
-		case 1:
-		case 2:
-		case 3: return DA_GROUP_UNDEF_3;
-		case 4:	return DA_GROUP_UNDEF_4;
-		case 5:	return DA_GROUP_BLX_IMM;
-		case 6:
-		case 7:	return DA_GROUP_UNDEF_5;
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	const __m256i byte = _mm256_set1_epi32(0xff);
+	size_t i;
+	for (i = 0; i + 32 <= count; i += 32) {
+		__m256i r[4];
+		int j;
+		for (j = 0; j < 4; j++) {
+			__m256i w = _mm256_loadu_si256(
+				(const __m256i *)&data[i + 8*j]);
+			__m256i nv = _mm256_cmpeq_epi32(_mm256_srli_epi32(w, 28),
+							_mm256_set1_epi32(0xf));
+			__m256i index = _mm256_or_si256(
+				_mm256_and_si256(nv, _mm256_set1_epi32(0x1000)),
+				_mm256_or_si256(
+					_mm256_and_si256(_mm256_srli_epi32(w, 16),
+							 _mm256_set1_epi32(0xff0)),
+					_mm256_and_si256(_mm256_srli_epi32(w, 4),
+							 _mm256_set1_epi32(0xf))));
+			r[j] = _mm256_and_si256(byte, _mm256_i32gather_epi32(
+				(const int *)da_group_table, index, 1));
+		}
+
+		__m256i p = _mm256_packus_epi16(_mm256_packs_epi32(r[0], r[1]),
+						_mm256_packs_epi32(r[2], r[3]));
+		_mm256_storeu_si256((__m256i *)&groups[i],
+				    _mm256_permutevar8x32_epi32(p, order));
 	}
-	default: return da_parse_group_cond(data);
+
+	return i;
+}
+
+#endif /* DA_SIMD_AVX2 && DA_GROUP_TABLE */
+
+/* Classify count words in host byte order into the groups array. */
+DA_API void
+da_instr_parse_groups(unsigned char *groups, const da_word_t *data,
+		      size_t count)
+{
+	size_t i = 0;
+
+#ifdef DA_GROUP_TABLE
+# ifdef DA_SIMD_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		i = da_parse_groups_avx2(groups, data, count);
 	}
+# endif
+#elif defined(DA_SIMD_SSE2)
+	i = da_parse_groups_sse2(groups, data, count);
+#endif
+
+	for (; i < count; i++) groups[i] = da_parse_group(data[i]);
 }
 
+/* Parse count words from data into the instrs array. */
 DA_API void
-da_instr_parse(da_instr_t *instr, da_word_t data, int big_endian)
+da_instr_parse_block(da_instr_t *instrs, const da_word_t *data, size_t count,
+		     int big_endian)
 {
-	instr->data = (big_endian ? be32toh(data) : le32toh(data));
-	instr->group = da_parse_group(instr->data);
+	da_word_t words[DA_PARSE_BLOCK_SIZE];
+	unsigned char groups[DA_PARSE_BLOCK_SIZE];
+
+	while (count > 0) {
+		size_t n = ((count < DA_PARSE_BLOCK_SIZE) ?
+			    count : DA_PARSE_BLOCK_SIZE);
+		size_t i;
+
+		if (big_endian) da_words_be32toh(words, data, n);
+		else da_words_le32toh(words, data, n);
+
+		da_instr_parse_groups(groups, words, n);
+
+		for (i = 0; i < n; i++) {
+			instrs[i].data = words[i];
+			instrs[i].group = groups[i];
+		}
+
+		instrs += n;
+		data += n;
+		count -= n;
+	}
+}
+
+/* Return name of group, or NULL if it is not a group. */
+DA_API const char *
+da_group_name(da_group_t group)
+{
+	if ((unsigned int)group >= DA_GROUP_MAX) return NULL;
+	return da_group_names[group];
+}
+
+/* Return name of condition, "al" for always, or NULL. */
+DA_API const char *
+da_cond_name(da_cond_t cond)
+{
+	if ((unsigned int)cond >= DA_COND_MAX) return NULL;
+	else if (cond == DA_COND_AL) return "al";
+	return da_cond_map[cond];
+}
+
+/* Return name of data processing opcode, or NULL. */
+DA_API const char *
+da_data_op_name(da_data_op_t op)
+{
+	if ((unsigned int)op >= DA_DATA_OP_MAX) return NULL;
+	return da_data_op_map[op];
+}
+
+/* Return name of shift type, or NULL. */
+DA_API const char *
+da_shift_name(da_shift_t sh)
+{
+	if ((unsigned int)sh >= DA_SHIFT_MAX) return NULL;
+	return da_shift_map[sh];
 }
@@ -21,12 +21,22 @@
 #ifndef _LIBDISARM_PARSER_H
 #define _LIBDISARM_PARSER_H
 
+#include <stddef.h>
+
 #include <libdisarm/macros.h>
 #include <libdisarm/types.h>
 
 DA_BEGIN_DECLS
 
 void da_instr_parse(da_instr_t *instr, da_word_t data, int big_endian);
+void da_instr_parse_block(da_instr_t *instrs, const da_word_t *data,
+			  size_t count, int big_endian);
+void da_instr_parse_groups(unsigned char *groups, const da_word_t *data,
+			   size_t count);
+const char *da_group_name(da_group_t group);
+const char *da_cond_name(da_cond_t cond);
+const char *da_data_op_name(da_data_op_t op);
+const char *da_shift_name(da_shift_t sh);
 
 DA_END_DECLS
 
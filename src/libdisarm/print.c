@@ -24,598 +24,1160 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "args.h"
+#include "emit.h"
 #include "macros.h"
+#include "packed.h"
 #include "print.h"
+#include "symtab.h"
+#include "thumb.h"
 #include "types.h"
 
 
-static const char *const da_cond_map[] = {
-	"eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc",
-	"hi", "ls", "ge", "lt", "gt", "le", "", "nv"
+/* Runs of consecutive registers in one half of a register list */
+typedef struct {
+	unsigned char count;
+	unsigned char runs[4];
+} da_reglist_half_t;
+
+/* Generated by mktables: da_data_op_frag_map, da_ls_frag_map and
+   da_reglist_half_map */
+#include "print_table.h"
+
+
+/* Condition followed by tab */
+static const da_frag_t da_cond_tab_frag_map[] = {
+	DA_FRAG("eq\t"), DA_FRAG("ne\t"), DA_FRAG("cs\t"), DA_FRAG("cc\t"),
+	DA_FRAG("mi\t"), DA_FRAG("pl\t"), DA_FRAG("vs\t"), DA_FRAG("vc\t"),
+	DA_FRAG("hi\t"), DA_FRAG("ls\t"), DA_FRAG("ge\t"), DA_FRAG("lt\t"),
+	DA_FRAG("gt\t"), DA_FRAG("le\t"), DA_FRAG("\t"),   DA_FRAG("nv\t")
 };
 
-static const char *const da_shift_map[] = {
-	"lsl", "lsr", "asr", "ror"
+static const da_frag_t da_cond_frag_map[] = {
+	DA_FRAG("eq"), DA_FRAG("ne"), DA_FRAG("cs"), DA_FRAG("cc"),
+	DA_FRAG("mi"), DA_FRAG("pl"), DA_FRAG("vs"), DA_FRAG("vc"),
+	DA_FRAG("hi"), DA_FRAG("ls"), DA_FRAG("ge"), DA_FRAG("lt"),
+	DA_FRAG("gt"), DA_FRAG("le"), DA_FRAG(""),   DA_FRAG("nv")
 };
 
-static const char *const da_data_op_map[] = {
-	"and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
-	"tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn"
+/* Condition of coprocessor instructions, where NV is printed as "2" */
+static const da_frag_t da_cp_cond_frag_map[] = {
+	DA_FRAG("eq"), DA_FRAG("ne"), DA_FRAG("cs"), DA_FRAG("cc"),
+	DA_FRAG("mi"), DA_FRAG("pl"), DA_FRAG("vs"), DA_FRAG("vc"),
+	DA_FRAG("hi"), DA_FRAG("ls"), DA_FRAG("ge"), DA_FRAG("lt"),
+	DA_FRAG("gt"), DA_FRAG("le"), DA_FRAG(""),   DA_FRAG("2")
 };
 
+static const da_frag_t da_shift_frag_map[] = {
+	DA_FRAG(", lsl "), DA_FRAG(", lsr "), DA_FRAG(", asr "),
+	DA_FRAG(", ror ")
+};
 
-static void
-da_reglist_fprint(FILE *f, da_uint_t reglist)
-{
-	int comma = 0;
-	int range_start = -1;
-	int i = 0;
-	for (i = 0; reglist; i++) {
-		if (reglist & 1 && range_start == -1) {
-			range_start = i;
+
+/* Append ", r%d". */
+static inline char *
+da_emit_next_reg(char *p, da_uint_t reg)
+{
+	p[0] = ',';
+	p[1] = ' ';
+	return da_emit_reg(p + 2, reg);
+}
+
+/* Append ", #%s0x%x" for a signed offset. */
+static inline char *
+da_emit_off(char *p, int off)
+{
+	p = da_emit_str(p, ", #-", 4 - (off >= 0));
+	return da_emit_hex(p, abs(off));
+}
+
+/* Append the address comment of a PC relative instruction. */
+static inline char *
+da_emit_addr_comment(char *p, da_addr_t addr)
+{
+	p = da_emit_str(p, "\t; ", 3);
+	return da_emit_hex(p, addr);
+}
+
+static char *
+da_emit_reglist(char *p, da_uint_t reglist)
+{
+	const da_reglist_half_t *lo = &da_reglist_half_map[reglist & 0xff];
+	const da_reglist_half_t *hi = &da_reglist_half_map[(reglist >> 8) &
+							   0xff];
+	unsigned int runs[8];
+	int n = 0;
+	int i;
+
+	for (i = 0; i < lo->count; i++) runs[n++] = lo->runs[i];
+	for (i = 0; i < hi->count; i++) {
+		unsigned int run = hi->runs[i] + 0x88;
+		/* Join runs that cross from r7 to r8 */
+		if (i == 0 && n > 0 && (runs[n-1] >> 4) == 7 &&
+		    (run & 0xf) == 8) {
+			runs[n-1] = (runs[n-1] & 0xf) | (run & 0xf0);
+		} else {
+			runs[n++] = run;
 		}
+	}
 
-		reglist >>= 1;
-
-		if (!(reglist & 1)) {
-			if (range_start == i) {
-				if (comma) fprintf(f, ",");
-				fprintf(f, " r%d", i);
-				comma = 1;
-			} else if (i > 0 && range_start == i-1) {
-				if (comma) fprintf(f, ",");
-				fprintf(f, " r%d, r%d",
-					range_start, i);
-				comma = 1;
-			} else if (range_start >= 0) {
-				if (comma) fprintf(f, ",");
-				fprintf(f, " r%d-r%d", range_start, i);
-				comma = 1;
-			}
-			range_start = -1;
+	for (i = 0; i < n; i++) {
+		unsigned int start = runs[i] & 0xf;
+		unsigned int end = runs[i] >> 4;
+
+		p = da_emit_str(p, (i > 0 ? ", " : " "), 1 + (i > 0));
+		p = da_emit_reg(p, start);
+		if (end == start + 1) {
+			p = da_emit_next_reg(p, end);
+		} else if (end > start) {
+			p = da_emit_char(p, '-');
+			p = da_emit_reg(p, end);
 		}
 	}
+
+	return p;
 }
 
+/* Append the operands of a data processing instruction. */
+static inline char *
+da_emit_data_regs(char *p, da_data_op_t op, da_reg_t rd, da_reg_t rn)
+{
+	if (op >= DA_DATA_OP_TST && op <= DA_DATA_OP_CMN) {
+		return da_emit_reg(p, rn);
+	} else if (op == DA_DATA_OP_MOV || op == DA_DATA_OP_MVN) {
+		return da_emit_reg(p, rd);
+	} else {
+		p = da_emit_reg(p, rd);
+		return da_emit_next_reg(p, rn);
+	}
+}
 
-static void
-da_instr_fprint_bkpt(FILE *f, const da_instr_t *instr,
-		     const da_args_bkpt_t *args, da_addr_t addr)
+/* Append an immediate shift. */
+static inline char *
+da_emit_imm_shift(char *p, da_shift_t sh, da_uint_t sha)
 {
-	fprintf(f, "bkpt%s\t0x%x", da_cond_map[args->cond], args->imm);
+	if (sh == DA_SHIFT_LSR || sh == DA_SHIFT_ASR) {
+		sha = ((sha > 0) ? sha : 32);
+	}
+
+	if (sha > 0) {
+		p = da_emit_frag(p, &da_shift_frag_map[sh]);
+		p = da_emit_char(p, '#');
+		p = da_emit_hex(p, sha);
+	} else if (sh == DA_SHIFT_ROR) {
+		p = da_emit_str(p, ", rrx", 5);
+	}
+
+	return p;
 }
 
-static void
-da_instr_fprint_bl(FILE *f, const da_instr_t *instr,
-		   const da_args_bl_t *args, da_addr_t addr)
+/* Append "r%d, [r%d" and the closing bracket for post-indexing. */
+static inline char *
+da_emit_ls_regs(char *p, da_reg_t rd, da_reg_t rn, da_uint_t p_bit)
 {
-	da_uint_t target = da_instr_branch_target(args->off, addr);
-	fprintf(f, "b%s%s\t0x%x", (args->link ? "l" : ""),
-		da_cond_map[args->cond], target);
+	p = da_emit_reg(p, rd);
+	p = da_emit_str(p, ", [", 3);
+	p = da_emit_reg(p, rn);
+	return da_emit_char_if(p, ']', !p_bit);
 }
 
-static void
-da_instr_fprint_blx_imm(FILE *f, const da_instr_t *instr,
-			const da_args_blx_imm_t *args, da_addr_t addr)
+/* Append ", %sr%d" for a register offset. */
+static inline char *
+da_emit_ls_reg_off(char *p, da_uint_t sign, da_reg_t rm)
+{
+	p = da_emit_str(p, ", -", 3 - (sign != 0));
+	return da_emit_reg(p, rm);
+}
+
+/* Append the closing bracket for pre-indexing. */
+static inline char *
+da_emit_ls_pre(char *p, da_uint_t p_bit, da_uint_t write)
+{
+	p = da_emit_char_if(p, ']', p_bit);
+	return da_emit_char_if(p, '!', p_bit && write);
+}
+
+/* Append mnemonic and status register field operand of msr. */
+static inline char *
+da_emit_msr(char *p, da_cond_t cond, da_uint_t r, da_uint_t mask)
+{
+	p = da_emit_str(p, "msr", 3);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[cond]);
+	p = da_emit_str(p, (r ? "SPSR_" : "CPSR_"), 5);
+	p = da_emit_char_if(p, 'c', mask & 1);
+	p = da_emit_char_if(p, 'x', mask & 2);
+	p = da_emit_char_if(p, 's', mask & 4);
+	return da_emit_char_if(p, 'f', mask & 8);
+}
+
+/* Append "%c%c" for the x and y bits of DSP multiplies. */
+static inline char *
+da_emit_dsp_xy(char *p, da_uint_t x, da_uint_t y)
+{
+	p[0] = (x ? 't' : 'b');
+	p[1] = (y ? 't' : 'b');
+	return p + 2;
+}
+
+
+static char *
+da_instr_print_bkpt(char *p, const da_instr_t *instr,
+		    const da_args_bkpt_t *args, da_addr_t addr)
+{
+	p = da_emit_str(p, "bkpt", 4);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	return da_emit_hex(p, args->imm);
+}
+
+static char *
+da_instr_print_bl(char *p, const da_instr_t *instr,
+		  const da_args_bl_t *args, da_addr_t addr)
 {
 	da_uint_t target = da_instr_branch_target(args->off, addr);
-	fprintf(f, "blx\t0x%x", target | args->h);
+	p = da_emit_char(p, 'b');
+	p = da_emit_char_if(p, 'l', args->link);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	return da_emit_hex(p, target);
 }
 
-static void
-da_instr_fprint_blx_reg(FILE *f, const da_instr_t *instr,
-			const da_args_blx_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_blx_imm(char *p, const da_instr_t *instr,
+		       const da_args_blx_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "b%sx%s\tr%d", (args->link ? "l" : ""),
-		da_cond_map[args->cond], args->rm);
+	da_uint_t target = da_instr_blx_target(args->off, args->h, addr);
+	p = da_emit_str(p, "blx\t", 4);
+	return da_emit_hex(p, target - args->h);
 }
 
-static void
-da_instr_fprint_clz(FILE *f, const da_instr_t *instr,
-		    const da_args_clz_t *args, da_addr_t addr)
+static char *
+da_instr_print_blx_reg(char *p, const da_instr_t *instr,
+		       const da_args_blx_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "clz%s\tr%d, r%d", da_cond_map[args->cond],
-		args->rd, args->rm);
+	p = da_emit_char(p, 'b');
+	p = da_emit_char_if(p, 'l', args->link);
+	p = da_emit_char(p, 'x');
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	return da_emit_reg(p, args->rm);
 }
 
-static void
-da_instr_fprint_cp_data(FILE *f, const da_instr_t *instr,
-			const da_args_cp_data_t *args, da_addr_t addr)
+static char *
+da_instr_print_clz(char *p, const da_instr_t *instr,
+		   const da_args_clz_t *args, da_addr_t addr)
 {
-	fprintf(f, "cdp%s\tp%d, %d, cr%d, cr%d, cr%d, %d",
-		(args->cond != DA_COND_NV ? da_cond_map[args->cond] : "2"),
-		args->cp_num, args->op_1, args->crd, args->crn, args->crm,
-		args->op_2);
+	p = da_emit_str(p, "clz", 3);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	p = da_emit_reg(p, args->rd);
+	return da_emit_next_reg(p, args->rm);
 }
 
-static void
-da_instr_fprint_cp_ls(FILE *f, const da_instr_t *instr,
-		      const da_args_cp_ls_t *args, da_addr_t addr)
+static char *
+da_instr_print_cp_data(char *p, const da_instr_t *instr,
+		       const da_args_cp_data_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sc%s%s\tp%d, cr%d, [r%d", (args->load ? "ld" : "st"),
-		(args->cond != DA_COND_NV ? da_cond_map[args->cond] : "2"),
-		(args->n ? "l" : ""), args->cp_num, args->crd, args->rn);
+	p = da_emit_str(p, "cdp", 3);
+	p = da_emit_frag(p, &da_cp_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "\tp", 2);
+	p = da_emit_dec(p, args->cp_num);
+	p = da_emit_str(p, ", ", 2);
+	p = da_emit_dec(p, args->op_1);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crd);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crn);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crm);
+	p = da_emit_str(p, ", ", 2);
+	return da_emit_dec(p, args->op_2);
+}
 
-	if (!args->p) fprintf(f, "]");
+static char *
+da_instr_print_cp_ls(char *p, const da_instr_t *instr,
+		     const da_args_cp_ls_t *args, da_addr_t addr)
+{
+	p = da_emit_str(p, (args->load ? "ldc" : "stc"), 3);
+	p = da_emit_frag(p, &da_cp_cond_frag_map[args->cond]);
+	p = da_emit_char_if(p, 'l', args->n);
+	p = da_emit_str(p, "\tp", 2);
+	p = da_emit_dec(p, args->cp_num);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crd);
+	p = da_emit_str(p, ", [", 3);
+	p = da_emit_reg(p, args->rn);
+	p = da_emit_char_if(p, ']', !args->p);
 
 	if (!(args->sign || args->p)) {
-		fprintf(f, ", {%d}", args->imm);
+		p = da_emit_str(p, ", {", 3);
+		p = da_emit_dec(p, args->imm);
+		p = da_emit_char(p, '}');
 	} else if (args->imm > 0) {
-		fprintf(f, ", #%s0x%x", (args->sign ? "" : "-"),
-			(args->imm << 2));
+		p = da_emit_str(p, ", #-", 4 - (args->sign != 0));
+		p = da_emit_hex(p, args->imm << 2);
 	}
 
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	return da_emit_ls_pre(p, args->p, args->write);
 }
 
-static void
-da_instr_fprint_cp_reg(FILE *f, const da_instr_t *instr,
-		       const da_args_cp_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_cp_reg(char *p, const da_instr_t *instr,
+		      const da_args_cp_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "m%s%s\tp%d, %d, r%d, cr%d, cr%d, %d",
-		(args->load ? "rc" : "cr"),
-		(args->cond != DA_COND_NV ? da_cond_map[args->cond] : "2"),
-		args->cp_num, args->op_1, args->rd, args->crn, args->crm,
-		args->op_2);
+	p = da_emit_str(p, (args->load ? "mrc" : "mcr"), 3);
+	p = da_emit_frag(p, &da_cp_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "\tp", 2);
+	p = da_emit_dec(p, args->cp_num);
+	p = da_emit_str(p, ", ", 2);
+	p = da_emit_dec(p, args->op_1);
+	p = da_emit_next_reg(p, args->rd);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crn);
+	p = da_emit_str(p, ", cr", 4);
+	p = da_emit_dec(p, args->crm);
+	p = da_emit_str(p, ", ", 2);
+	return da_emit_dec(p, args->op_2);
 }
 
-static void
-da_instr_fprint_data_imm(FILE *f, const da_instr_t *instr,
-			 const da_args_data_imm_t *args, da_addr_t addr)
-{
-	fprintf(f, "%s%s%s\t", da_data_op_map[args->op],
-		da_cond_map[args->cond],
-		((args->flags && (args->op < DA_DATA_OP_TST ||
-				  args->op > DA_DATA_OP_CMN)) ? "s" : ""));
-
-	if (args->op >= DA_DATA_OP_TST && args->op <= DA_DATA_OP_CMN) {
-		fprintf(f, "r%d", args->rn);
-	} else if (args->op == DA_DATA_OP_MOV || args->op == DA_DATA_OP_MVN) {
-		fprintf(f, "r%d", args->rd);
-	} else {
-		fprintf(f, "r%d, r%d", args->rd, args->rn);
-	}
-
-	fprintf(f, ", #0x%x", args->imm);
+static char *
+da_instr_print_data_imm(char *p, const da_instr_t *instr,
+			const da_args_data_imm_t *args, da_addr_t addr)
+{
+	p = da_emit_frag(p, &da_data_op_frag_map[(args->op << 5) |
+						 (args->cond << 1) |
+						 args->flags]);
+	p = da_emit_data_regs(p, args->op, args->rd, args->rn);
+	p = da_emit_str(p, ", #", 3);
+	p = da_emit_hex(p, args->imm);
 
 	if (args->rn == DA_REG_R15) {
 		if (args->op == DA_DATA_OP_ADD) {
-			fprintf(f, "\t; 0x%x", addr + 8 + args->imm);
+			p = da_emit_addr_comment(p, addr + 8 + args->imm);
 		} else if (args->op == DA_DATA_OP_SUB) {
-			fprintf(f, "\t; 0x%x", addr + 8 - args->imm);
+			p = da_emit_addr_comment(p, addr + 8 - args->imm);
 		}
 	}
-}
 
-static void
-da_instr_fprint_data_imm_sh(FILE *f, const da_instr_t *instr,
-			    const da_args_data_imm_sh_t *args, da_addr_t addr)
-{
-	fprintf(f, "%s%s%s\t", da_data_op_map[args->op],
-		da_cond_map[args->cond],
-		((args->flags &&
-		  (args->op < DA_DATA_OP_TST ||
-		   args->op > DA_DATA_OP_CMN)) ? "s" : ""));
-
-	if (args->op >= DA_DATA_OP_TST && args->op <= DA_DATA_OP_CMN) {
-		fprintf(f, "r%d, r%d", args->rn, args->rm);
-	} else if (args->op == DA_DATA_OP_MOV || args->op == DA_DATA_OP_MVN) {
-		fprintf(f, "r%d, r%d", args->rd, args->rm);
-	} else {
-		fprintf(f, "r%d, r%d, r%d", args->rd, args->rn, args->rm);
-	}
-
-	da_uint_t sha = args->sha;
-	
-	if (args->sh == DA_SHIFT_LSR || args->sh == DA_SHIFT_ASR) {
-		sha = ((sha > 0) ? sha : 32);
-	}
-
-	if (sha > 0) {
-		fprintf(f, ", %s #0x%x", da_shift_map[args->sh], sha);
-	} else if (args->sh == DA_SHIFT_ROR) {
-		fprintf(f, ", rrx");
-	}
+	return p;
 }
 
-static void
-da_instr_fprint_data_reg_sh(FILE *f, const da_instr_t *instr,
-			    const da_args_data_reg_sh_t *args, da_addr_t addr)
-{
-	fprintf(f, "%s%s%s\t", da_data_op_map[args->op],
-		da_cond_map[args->cond],
-		((args->flags &&
-		  (args->op < DA_DATA_OP_TST ||
-		   args->op > DA_DATA_OP_CMN)) ? "s" : ""));
-
-	if (args->op >= DA_DATA_OP_TST && args->op <= DA_DATA_OP_CMN) {
-		fprintf(f, "r%d, r%d", args->rn, args->rm);
-	} else if (args->op == DA_DATA_OP_MOV || args->op == DA_DATA_OP_MVN) {
-		fprintf(f, "r%d, r%d", args->rd, args->rm);
-	} else {
-		fprintf(f, "r%d, r%d, r%d", args->rd, args->rn, args->rm);
-	}
+static char *
+da_instr_print_data_imm_sh(char *p, const da_instr_t *instr,
+			   const da_args_data_imm_sh_t *args, da_addr_t addr)
+{
+	p = da_emit_frag(p, &da_data_op_frag_map[(args->op << 5) |
+						 (args->cond << 1) |
+						 args->flags]);
+	p = da_emit_data_regs(p, args->op, args->rd, args->rn);
+	p = da_emit_next_reg(p, args->rm);
+	return da_emit_imm_shift(p, args->sh, args->sha);
+}
 
-	fprintf(f, ", %s r%d", da_shift_map[args->sh], args->rs);
+static char *
+da_instr_print_data_reg_sh(char *p, const da_instr_t *instr,
+			   const da_args_data_reg_sh_t *args, da_addr_t addr)
+{
+	p = da_emit_frag(p, &da_data_op_frag_map[(args->op << 5) |
+						 (args->cond << 1) |
+						 args->flags]);
+	p = da_emit_data_regs(p, args->op, args->rd, args->rn);
+	p = da_emit_next_reg(p, args->rm);
+	p = da_emit_frag(p, &da_shift_frag_map[args->sh]);
+	return da_emit_reg(p, args->rs);
 }
 
-static void
-da_instr_fprint_dsp_add_sub(FILE *f, const da_instr_t *instr,
-			    const da_args_dsp_add_sub_t *args, da_addr_t addr)
+static char *
+da_instr_print_dsp_add_sub(char *p, const da_instr_t *instr,
+			   const da_args_dsp_add_sub_t *args, da_addr_t addr)
 {
-	fprintf(f, "q%s%s%s\tr%d, r%d, r%d", ((args->op & 2) ? "d" : ""),
-		((args->op & 1) ? "sub" : "add"), da_cond_map[args->cond],
-		args->rd, args->rm, args->rn);
+	p = da_emit_char(p, 'q');
+	p = da_emit_char_if(p, 'd', args->op & 2);
+	p = da_emit_str(p, ((args->op & 1) ? "sub" : "add"), 3);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	p = da_emit_reg(p, args->rd);
+	p = da_emit_next_reg(p, args->rm);
+	return da_emit_next_reg(p, args->rn);
 }
 
-static void
-da_instr_fprint_dsp_mul(FILE *f, const da_instr_t *instr,
-			const da_args_dsp_mul_t *args, da_addr_t addr)
+static char *
+da_instr_print_dsp_mul(char *p, const da_instr_t *instr,
+		       const da_args_dsp_mul_t *args, da_addr_t addr)
 {
 	switch (args->op) {
 	case 0:
-		fprintf(f, "smla%s%s%s\tr%d, r%d, r%d, r%d",
-			(args->x ? "t" : "b"), (args->y ? "t" : "b"),
-			da_cond_map[args->cond], args->rd, args->rm, args->rs,
-			args->rn);
-		break;
+		p = da_emit_str(p, "smla", 4);
+		p = da_emit_dsp_xy(p, args->x, args->y);
+		p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rm);
+		p = da_emit_next_reg(p, args->rs);
+		return da_emit_next_reg(p, args->rn);
 	case 1:
-		fprintf(f, "s%sw%s%s\tr%d, r%d, r%d",
-			(args->x ? "mul" : "mla"), (args->y ? "t" : "b"),
-			da_cond_map[args->cond], args->rd, args->rm, args->rs);
-		if (!args->x) fprintf(f, ", r%d", args->rn);
-		break;
+		p = da_emit_str(p, (args->x ? "smulw" : "smlaw"), 5);
+		p = da_emit_char(p, (args->y ? 't' : 'b'));
+		p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rm);
+		p = da_emit_next_reg(p, args->rs);
+		if (!args->x) p = da_emit_next_reg(p, args->rn);
+		return p;
 	case 2:
-		fprintf(f, "smlal%s%s%s\tr%d, r%d, r%d, r%d",
-			(args->x ? "t" : "b"), (args->y ? "t" : "b"),
-			da_cond_map[args->cond], args->rn, args->rd, args->rm,
-			args->rs);
-		break;
-	case 3:
-		fprintf(f, "smul%s%s%s\tr%d, r%d, r%d",
-			(args->x ? "t" : "b"), (args->y ? "t" : "b"),
-			da_cond_map[args->cond], args->rd, args->rm, args->rs);
-		break;
+		p = da_emit_str(p, "smlal", 5);
+		p = da_emit_dsp_xy(p, args->x, args->y);
+		p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+		p = da_emit_reg(p, args->rn);
+		p = da_emit_next_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rm);
+		return da_emit_next_reg(p, args->rs);
+	default:
+		p = da_emit_str(p, "smul", 4);
+		p = da_emit_dsp_xy(p, args->x, args->y);
+		p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rm);
+		return da_emit_next_reg(p, args->rs);
 	}
 }
 
-static void
-da_instr_fprint_l_sign_imm(FILE *f, const da_instr_t *instr,
-			   const da_args_l_sign_imm_t *args, da_addr_t addr)
+static char *
+da_instr_print_l_sign_imm(char *p, const da_instr_t *instr,
+			  const da_args_l_sign_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "ldr%ss%s\tr%d, [r%d", da_cond_map[args->cond],
-		(args->hword ? "h" : "b"), args->rd, args->rn);
+	p = da_emit_str(p, "ldr", 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, (args->hword ? "sh\t" : "sb\t"), 3);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
 
-	if (!args->p) fprintf(f, "]");
+	if (args->off != 0) p = da_emit_off(p, args->off);
 
-	if (args->off != 0) {
-		fprintf(f, ", #%s0x%x", (args->off < 0 ? "-" : ""),
-			abs(args->off));
-	}
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_ls_pre(p, args->p, args->write);
 
 	if (args->rn == DA_REG_R15) {
-		fprintf(f, "\t; 0x%x", addr + 8 + args->off);
+		p = da_emit_addr_comment(p, addr + 8 + args->off);
 	}
+
+	return p;
 }
 
-static void
-da_instr_fprint_l_sign_reg(FILE *f, const da_instr_t *instr,
-			   const da_args_l_sign_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_l_sign_reg(char *p, const da_instr_t *instr,
+			  const da_args_l_sign_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "ldr%ss%s\tr%d, [r%d", da_cond_map[args->cond],
-		(args->hword ? "h" : "b"), args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
-
-	fprintf(f, ", %sr%d", (args->sign ? "" : "-"), args->rm);
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_str(p, "ldr", 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, (args->hword ? "sh\t" : "sb\t"), 3);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
+	p = da_emit_ls_reg_off(p, args->sign, args->rm);
+	return da_emit_ls_pre(p, args->p, args->write);
 }
 
-static void
-da_instr_fprint_ls_hw_imm(FILE *f, const da_instr_t *instr,
-			  const da_args_ls_hw_imm_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_hw_imm(char *p, const da_instr_t *instr,
+			 const da_args_ls_hw_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%sh\tr%d, [r%d", (args->load ? "ld" : "st"),
-		da_cond_map[args->cond], args->rd, args->rn);
+	p = da_emit_str(p, (args->load ? "ldr" : "str"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "h\t", 2);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
 
-	if (!args->p) fprintf(f, "]");
+	if (args->off != 0) p = da_emit_off(p, args->off);
 
-	if (args->off != 0) {
-		fprintf(f, ", #%s0x%x", (args->off < 0 ? "-" : ""),
-			abs(args->off));
-	}
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_ls_pre(p, args->p, args->write);
 
 	if (args->rn == DA_REG_R15) {
-		fprintf(f, "\t; 0x%x", addr + 8 + args->off);
+		p = da_emit_addr_comment(p, addr + 8 + args->off);
 	}
+
+	return p;
 }
 
-static void
-da_instr_fprint_ls_hw_reg(FILE *f, const da_instr_t *instr,
-			  const da_args_ls_hw_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_hw_reg(char *p, const da_instr_t *instr,
+			 const da_args_ls_hw_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%sh\tr%d, [r%d", (args->load ? "ld" : "st"),
-		da_cond_map[args->cond], args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
-
-	fprintf(f, ", %sr%d", (args->sign ? "" : "-"), args->rm);
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_str(p, (args->load ? "ldr" : "str"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "h\t", 2);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
+	p = da_emit_ls_reg_off(p, args->sign, args->rm);
+	return da_emit_ls_pre(p, args->p, args->write);
 }
 
-static void
-da_instr_fprint_ls_imm(FILE *f, const da_instr_t *instr,
-		       const da_args_ls_imm_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_imm(char *p, const da_instr_t *instr,
+		      const da_args_ls_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%s%s%s\tr%d, [r%d", (args->load ? "ld" : "st"),
-		da_cond_map[args->cond], (args->byte ? "b" : ""),
-		((!args->p && args->w) ? "t" : ""), args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
+	p = da_emit_frag(p, &da_ls_frag_map[(args->load << 6) |
+					    (args->cond << 2) |
+					    (args->byte << 1) |
+					    (!args->p && args->w)]);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
 
-	if (args->off != 0) {
-		fprintf(f, ", #%s0x%x", (args->off < 0 ? "-" : ""),
-			abs(args->off));
-	}
+	if (args->off != 0) p = da_emit_off(p, args->off);
 
-	if (args->p) fprintf(f, "]%s", (args->w ? "!" : ""));
+	p = da_emit_ls_pre(p, args->p, args->w);
 
 	if (args->rn == DA_REG_R15) {
-		fprintf(f, "\t; 0x%x", addr + 8 + args->off);
+		p = da_emit_addr_comment(p, addr + 8 + args->off);
 	}
+
+	return p;
 }
 
-static void
-da_instr_fprint_ls_multi(FILE *f, const da_instr_t *instr,
-			 const da_args_ls_multi_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_multi(char *p, const da_instr_t *instr,
+			const da_args_ls_multi_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sm%s%s%s\tr%d%s, {", (args->load ? "ld" : "st"),
-		da_cond_map[args->cond], (args->u ? "i" : "d"),
-		(args->p ? "b" : "a"), args->rn, (args->write ? "!" : ""));
-      
-	da_reglist_fprint(f, args->reglist);
-
-	fprintf(f, " }%s", (args->s ? "^" : ""));
+	p = da_emit_str(p, (args->load ? "ldm" : "stm"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p[0] = (args->u ? 'i' : 'd');
+	p[1] = (args->p ? 'b' : 'a');
+	p[2] = '\t';
+	p = da_emit_reg(p + 3, args->rn);
+	p = da_emit_char_if(p, '!', args->write);
+	p = da_emit_str(p, ", {", 3);
+	p = da_emit_reglist(p, args->reglist);
+	p = da_emit_str(p, " }", 2);
+	return da_emit_char_if(p, '^', args->s);
 }
 
-static void
-da_instr_fprint_ls_reg(FILE *f, const da_instr_t *instr,
-		       const da_args_ls_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_reg(char *p, const da_instr_t *instr,
+		      const da_args_ls_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%s%s%s\tr%d, [r%d", (args->load ? "ld" : "st"),
-		da_cond_map[args->cond], (args->byte ? "b" : ""),
-		((!args->p && args->write) ? "t" : ""), args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
-
-	fprintf(f, ", %sr%d", (args->sign ? "" : "-"), args->rm);
-
-	da_uint_t sha = args->sha;
-	
-	if (args->sh == DA_SHIFT_LSR || args->sh == DA_SHIFT_ASR) {
-		sha = (sha ? sha : 32);
-	}
-
-	if (sha > 0) {
-		fprintf(f, ", %s #0x%x", da_shift_map[args->sh], sha);
-	} else if (args->sh == DA_SHIFT_ROR) {
-		fprintf(f, ", rrx");
-	}
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_frag(p, &da_ls_frag_map[(args->load << 6) |
+					    (args->cond << 2) |
+					    (args->byte << 1) |
+					    (!args->p && args->write)]);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
+	p = da_emit_ls_reg_off(p, args->sign, args->rm);
+	p = da_emit_imm_shift(p, args->sh, args->sha);
+	return da_emit_ls_pre(p, args->p, args->write);
 }
 
-static void
-da_instr_fprint_ls_two_imm(FILE *f, const da_instr_t *instr,
-			   const da_args_ls_two_imm_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_two_imm(char *p, const da_instr_t *instr,
+			  const da_args_ls_two_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%sd\tr%d, [r%d", (args->store ? "st" : "ld"),
-		da_cond_map[args->cond], args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
+	p = da_emit_str(p, (args->store ? "str" : "ldr"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "d\t", 2);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
 
-	if (args->off != 0) {
-		fprintf(f, ", #%s0x%x", (args->off < 0 ? "-" : ""),
-			abs(args->off));
-	}
+	if (args->off != 0) p = da_emit_off(p, args->off);
 
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_ls_pre(p, args->p, args->write);
 
 	if (args->rn == DA_REG_R15) {
-		fprintf(f, "\t; 0x%x", addr + 8 + args->off);
+		p = da_emit_addr_comment(p, addr + 8 + args->off);
 	}
+
+	return p;
 }
 
-static void
-da_instr_fprint_ls_two_reg(FILE *f, const da_instr_t *instr,
-			   const da_args_ls_two_reg_t *args, da_addr_t addr)
+static char *
+da_instr_print_ls_two_reg(char *p, const da_instr_t *instr,
+			  const da_args_ls_two_reg_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sr%sd\tr%d, [r%d", (args->store ? "st" : "ld"),
-		da_cond_map[args->cond], args->rd, args->rn);
-
-	if (!args->p) fprintf(f, "]");
-
-	fprintf(f, ", %sr%d", (args->sign ? "" : "-"), args->rm);
-
-	if (args->p) fprintf(f, "]%s", (args->write ? "!" : ""));
+	p = da_emit_str(p, (args->store ? "str" : "ldr"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_str(p, "d\t", 2);
+	p = da_emit_ls_regs(p, args->rd, args->rn, args->p);
+	p = da_emit_ls_reg_off(p, args->sign, args->rm);
+	return da_emit_ls_pre(p, args->p, args->write);
 }
 
-static void
-da_instr_fprint_mrs(FILE *f, const da_instr_t *instr,
-		    const da_args_mrs_t *args, da_addr_t addr)
+static char *
+da_instr_print_mrs(char *p, const da_instr_t *instr,
+		   const da_args_mrs_t *args, da_addr_t addr)
 {
-	fprintf(f, "mrs%s\tr%d, %s", da_cond_map[args->cond],
-		args->rd, (args->r ? "SPSR" : "CPSR"));
+	p = da_emit_str(p, "mrs", 3);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	p = da_emit_reg(p, args->rd);
+	return da_emit_str(p, (args->r ? ", SPSR" : ", CPSR"), 6);
 }
 
-static void
-da_instr_fprint_msr(FILE *f, const da_instr_t *instr,
-		    const da_args_msr_t *args, da_addr_t addr)
+static char *
+da_instr_print_msr(char *p, const da_instr_t *instr,
+		   const da_args_msr_t *args, da_addr_t addr)
 {
-	fprintf(f, "msr%s\t%s_%s%s%s%s", da_cond_map[args->cond],
-		(args->r ? "SPSR" : "CPSR"), ((args->mask & 1) ? "c" : ""),
-		((args->mask & 2) ? "x" : ""), ((args->mask & 4) ? "s" : ""),
-		((args->mask & 8) ? "f" : ""));
-
-	fprintf(f, ", r%d", args->rm);
+	p = da_emit_msr(p, args->cond, args->r, args->mask);
+	return da_emit_next_reg(p, args->rm);
 }
 
-static void
-da_instr_fprint_msr_imm(FILE *f, const da_instr_t *instr,
-			const da_args_msr_imm_t *args, da_addr_t addr)
+static char *
+da_instr_print_msr_imm(char *p, const da_instr_t *instr,
+		       const da_args_msr_imm_t *args, da_addr_t addr)
 {
-	fprintf(f, "msr%s\t%s_%s%s%s%s, #0x%x", da_cond_map[args->cond],
-		(args->r ? "SPSR" : "CPSR"), ((args->mask & 1) ? "c" : ""),
-		((args->mask & 2) ? "x" : ""), ((args->mask & 4) ? "s" : ""),
-		((args->mask & 8) ? "f" : ""), args->imm);
+	p = da_emit_msr(p, args->cond, args->r, args->mask);
+	p = da_emit_str(p, ", #", 3);
+	return da_emit_hex(p, args->imm);
 }
 
-static void
-da_instr_fprint_mul(FILE *f, const da_instr_t *instr,
-		    const da_args_mul_t *args, da_addr_t addr)
+static char *
+da_instr_print_mul(char *p, const da_instr_t *instr,
+		   const da_args_mul_t *args, da_addr_t addr)
 {
-	fprintf(f, "m%s%s%s\tr%d, r%d, r%d", (args->acc ? "la" : "ul"),
-		da_cond_map[args->cond], (args->flags ? "s" : ""),
-		args->rd, args->rm, args->rs);
+	p = da_emit_str(p, (args->acc ? "mla" : "mul"), 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_char_if(p, 's', args->flags);
+	p = da_emit_char(p, '\t');
+	p = da_emit_reg(p, args->rd);
+	p = da_emit_next_reg(p, args->rm);
+	p = da_emit_next_reg(p, args->rs);
 
-	if (args->acc) fprintf(f, ", r%d", args->rn);
+	if (args->acc) p = da_emit_next_reg(p, args->rn);
+
+	return p;
 }
 
-static void
-da_instr_fprint_mull(FILE *f, const da_instr_t *instr,
-		     const da_args_mull_t *args, da_addr_t addr)
+static char *
+da_instr_print_mull(char *p, const da_instr_t *instr,
+		    const da_args_mull_t *args, da_addr_t addr)
 {
-	fprintf(f, "%sm%sl%s%s\tr%d, r%d, r%d, r%d",
-		(args->sign ? "s" : "u"), (args->acc ? "la" : "ul"),
-		da_cond_map[args->cond], (args->flags ? "s" : ""),
-		args->rd_lo, args->rd_hi, args->rm, args->rs);
+	p = da_emit_char(p, (args->sign ? 's' : 'u'));
+	p = da_emit_str(p, (args->acc ? "mlal" : "mull"), 4);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_char_if(p, 's', args->flags);
+	p = da_emit_char(p, '\t');
+	p = da_emit_reg(p, args->rd_lo);
+	p = da_emit_next_reg(p, args->rd_hi);
+	p = da_emit_next_reg(p, args->rm);
+	return da_emit_next_reg(p, args->rs);
 }
 
-static void
-da_instr_fprint_swi(FILE *f, const da_instr_t *instr,
-		    const da_args_swi_t *args, da_addr_t addr)
+static char *
+da_instr_print_swi(char *p, const da_instr_t *instr,
+		   const da_args_swi_t *args, da_addr_t addr)
 {
-	fprintf(f, "swi%s\t0x%x", da_cond_map[args->cond], args->imm);
+	p = da_emit_str(p, "swi", 3);
+	p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+	return da_emit_hex(p, args->imm);
 }
 
-static void
-da_instr_fprint_swp(FILE *f, const da_instr_t *instr,
-		    const da_args_swp_t *args, da_addr_t addr)
+static char *
+da_instr_print_swp(char *p, const da_instr_t *instr,
+		   const da_args_swp_t *args, da_addr_t addr)
 {
-	fprintf(f, "swp%s%s\tr%d, r%d, [r%d]", da_cond_map[args->cond],
-		(args->byte ? "b" : ""), args->rd, args->rm, args->rn);
+	p = da_emit_str(p, "swp", 3);
+	p = da_emit_frag(p, &da_cond_frag_map[args->cond]);
+	p = da_emit_char_if(p, 'b', args->byte);
+	p = da_emit_char(p, '\t');
+	p = da_emit_reg(p, args->rd);
+	p = da_emit_next_reg(p, args->rm);
+	p = da_emit_str(p, ", [", 3);
+	p = da_emit_reg(p, args->rn);
+	return da_emit_char(p, ']');
 }
 
-DA_API void
-da_instr_fprint(FILE *f, const da_instr_t *instr, const da_instr_args_t *args,
-		da_addr_t addr)
+static char *
+da_instr_print(char *p, const da_instr_t *instr,
+	       const da_instr_args_t *args, da_addr_t addr)
 {
 	switch (instr->group) {
 	case DA_GROUP_BKPT:
-		da_instr_fprint_bkpt(f, instr, &args->bkpt, addr);
-		break;
+		return da_instr_print_bkpt(p, instr, &args->bkpt, addr);
 	case DA_GROUP_BL:
-		da_instr_fprint_bl(f, instr, &args->bl, addr);
-		break;
+		return da_instr_print_bl(p, instr, &args->bl, addr);
 	case DA_GROUP_BLX_IMM:
-		da_instr_fprint_blx_imm(f, instr, &args->blx_imm, addr);
-		break;
+		return da_instr_print_blx_imm(p, instr, &args->blx_imm, addr);
 	case DA_GROUP_BLX_REG:
-		da_instr_fprint_blx_reg(f, instr, &args->blx_reg, addr);
-		break;
+		return da_instr_print_blx_reg(p, instr, &args->blx_reg, addr);
 	case DA_GROUP_CLZ:
-		da_instr_fprint_clz(f, instr, &args->clz, addr);
-		break;
+		return da_instr_print_clz(p, instr, &args->clz, addr);
 	case DA_GROUP_CP_DATA:
-		da_instr_fprint_cp_data(f, instr, &args->cp_data, addr);
-		break;
+		return da_instr_print_cp_data(p, instr, &args->cp_data, addr);
 	case DA_GROUP_CP_LS:
-		da_instr_fprint_cp_ls(f, instr, &args->cp_ls, addr);
-		break;
+		return da_instr_print_cp_ls(p, instr, &args->cp_ls, addr);
 	case DA_GROUP_CP_REG:
-		da_instr_fprint_cp_reg(f, instr, &args->cp_reg, addr);
-		break;
+		return da_instr_print_cp_reg(p, instr, &args->cp_reg, addr);
 	case DA_GROUP_DATA_IMM:
-		da_instr_fprint_data_imm(f, instr, &args->data_imm, addr);
-		break;
+		return da_instr_print_data_imm(p, instr, &args->data_imm, addr);
 	case DA_GROUP_DATA_IMM_SH:
-		da_instr_fprint_data_imm_sh(f, instr, &args->data_imm_sh,
-					    addr);
-		break;
+		return da_instr_print_data_imm_sh(p, instr,
+						  &args->data_imm_sh, addr);
 	case DA_GROUP_DATA_REG_SH:
-		da_instr_fprint_data_reg_sh(f, instr, &args->data_reg_sh,
-					    addr);
-		break;
+		return da_instr_print_data_reg_sh(p, instr,
+						  &args->data_reg_sh, addr);
 	case DA_GROUP_DSP_ADD_SUB:
-		da_instr_fprint_dsp_add_sub(f, instr, &args->dsp_add_sub,
-					    addr);
-		break;
+		return da_instr_print_dsp_add_sub(p, instr,
+						  &args->dsp_add_sub, addr);
 	case DA_GROUP_DSP_MUL:
-		da_instr_fprint_dsp_mul(f, instr, &args->dsp_mul, addr);
-		break;
+		return da_instr_print_dsp_mul(p, instr, &args->dsp_mul, addr);
 	case DA_GROUP_L_SIGN_IMM:
-		da_instr_fprint_l_sign_imm(f, instr, &args->l_sign_imm, addr);
-		break;
+		return da_instr_print_l_sign_imm(p, instr,
+						 &args->l_sign_imm, addr);
 	case DA_GROUP_L_SIGN_REG:
-		da_instr_fprint_l_sign_reg(f, instr, &args->l_sign_reg, addr);
-		break;
+		return da_instr_print_l_sign_reg(p, instr,
+						 &args->l_sign_reg, addr);
 	case DA_GROUP_LS_HW_IMM:
-		da_instr_fprint_ls_hw_imm(f, instr, &args->ls_hw_imm, addr);
-		break;
+		return da_instr_print_ls_hw_imm(p, instr,
+						&args->ls_hw_imm, addr);
 	case DA_GROUP_LS_HW_REG:
-		da_instr_fprint_ls_hw_reg(f, instr, &args->ls_hw_reg, addr);
-		break;
+		return da_instr_print_ls_hw_reg(p, instr,
+						&args->ls_hw_reg, addr);
 	case DA_GROUP_LS_IMM:
-		da_instr_fprint_ls_imm(f, instr, &args->ls_imm, addr);
-		break;
+		return da_instr_print_ls_imm(p, instr, &args->ls_imm, addr);
 	case DA_GROUP_LS_MULTI:
-		da_instr_fprint_ls_multi(f, instr, &args->ls_multi, addr);
-		break;
+		return da_instr_print_ls_multi(p, instr, &args->ls_multi, addr);
 	case DA_GROUP_LS_REG:
-		da_instr_fprint_ls_reg(f, instr, &args->ls_reg, addr);
-		break;
+		return da_instr_print_ls_reg(p, instr, &args->ls_reg, addr);
 	case DA_GROUP_LS_TWO_IMM:
-		da_instr_fprint_ls_two_imm(f, instr, &args->ls_two_imm, addr);
-		break;
+		return da_instr_print_ls_two_imm(p, instr,
+						 &args->ls_two_imm, addr);
 	case DA_GROUP_LS_TWO_REG:
-		da_instr_fprint_ls_two_reg(f, instr, &args->ls_two_reg, addr);
-		break;
+		return da_instr_print_ls_two_reg(p, instr,
+						 &args->ls_two_reg, addr);
 	case DA_GROUP_MRS:
-		da_instr_fprint_mrs(f, instr, &args->mrs, addr);
-		break;
+		return da_instr_print_mrs(p, instr, &args->mrs, addr);
 	case DA_GROUP_MSR:
-		da_instr_fprint_msr(f, instr, &args->msr, addr);
-		break;
+		return da_instr_print_msr(p, instr, &args->msr, addr);
 	case DA_GROUP_MSR_IMM:
-		da_instr_fprint_msr_imm(f, instr, &args->msr_imm, addr);
-		break;
+		return da_instr_print_msr_imm(p, instr, &args->msr_imm, addr);
 	case DA_GROUP_MUL:
-		da_instr_fprint_mul(f, instr, &args->mul, addr);
-		break;
+		return da_instr_print_mul(p, instr, &args->mul, addr);
 	case DA_GROUP_MULL:
-		da_instr_fprint_mull(f, instr, &args->mull, addr);
-		break;
+		return da_instr_print_mull(p, instr, &args->mull, addr);
 	case DA_GROUP_SWI:
-		da_instr_fprint_swi(f, instr, &args->swi, addr);
-		break;
+		return da_instr_print_swi(p, instr, &args->swi, addr);
 	case DA_GROUP_SWP:
-		da_instr_fprint_swp(f, instr, &args->swp, addr);
-		break;
+		return da_instr_print_swp(p, instr, &args->swp, addr);
 	case DA_GROUP_UNDEF_1:
 	case DA_GROUP_UNDEF_2:
 	case DA_GROUP_UNDEF_3:
 	case DA_GROUP_UNDEF_4:
 	case DA_GROUP_UNDEF_5:
-		fprintf(f, "undefined");
+	case DA_GROUP_MAX:
+		return da_emit_str(p, "undefined", 9);
+	}
+
+	return p;
+}
+
+/* Copy text of length n to buffer of size len as snprintf would print
+   it. Return n. */
+static size_t
+da_copy_text(char *buf, size_t len, const char *text, size_t n)
+{
+	if (len > 0) {
+		size_t copy = ((n < len) ? n : len - 1);
+		memcpy(buf, text, copy);
+		buf[copy] = '\0';
+	}
+	return n;
+}
+
+/* Print instruction to buffer of size len. Return the length of the full
+   text as snprintf does; the text is truncated if that is not less than
+   len. */
+DA_API size_t
+da_instr_snprint(char *buf, size_t len, const da_instr_t *instr,
+		 const da_instr_args_t *args, da_addr_t addr)
+{
+	if (len >= DA_EMIT_SIZE) {
+		char *end = da_instr_print(buf, instr, args, addr);
+		*end = '\0';
+		return end - buf;
+	} else {
+		char text[DA_EMIT_SIZE];
+		char *end = da_instr_print(text, instr, args, addr);
+		return da_copy_text(buf, len, text, end - text);
+	}
+}
+
+/* Print packed instruction as da_instr_snprint does. */
+DA_API size_t
+da_instr_snprint_packed(char *buf, size_t len,
+			const da_instr_packed_t *packed, da_addr_t addr)
+{
+	/* The printers only use the group of the instruction */
+	da_instr_t instr = { 0, packed->group };
+	da_instr_args_t args;
+
+	da_instr_unpack_args(&args, packed);
+	return da_instr_snprint(buf, len, &instr, &args, addr);
+}
+
+/* Print count instructions, starting at address addr, to buffer of size
+   len. Each instruction is terminated by a null character and its text
+   starts at offset offsets[i] in buf. offsets must have room for count + 1
+   entries; the entry after the last instruction printed is the number of
+   bytes used. Return the number of instructions that fit in the buffer. */
+DA_API size_t
+da_instr_snprint_block(char *buf, size_t len, size_t *offsets,
+		       const da_instr_t *instrs, const da_instr_args_t *args,
+		       size_t count, da_addr_t addr)
+{
+	size_t used = 0;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		size_t n = da_instr_snprint(buf + used, len - used, &instrs[i],
+					    &args[i],
+					    addr + i*sizeof(da_word_t));
+		if (n >= len - used) break;
+
+		offsets[i] = used;
+		used += n + 1;
+	}
+
+	offsets[i] = used;
+	return i;
+}
+
+/* Return the address dependent end of the text of instruction. */
+static void
+da_instr_rel(da_instr_rel_t *rel, const da_instr_t *instr,
+	     const da_instr_args_t *args)
+{
+	rel->present = 1;
+	rel->bits = 0;
+
+	switch (instr->group) {
+	case DA_GROUP_BL:
+		rel->delta = da_instr_branch_target(args->bl.off, 0);
+		return;
+	case DA_GROUP_BLX_IMM:
+		rel->delta = da_instr_blx_target(args->blx_imm.off,
+						 args->blx_imm.h, 0);
+		rel->bits = args->blx_imm.h;
+		return;
+	case DA_GROUP_DATA_IMM:
+		if (args->data_imm.rn == DA_REG_R15) {
+			if (args->data_imm.op == DA_DATA_OP_ADD) {
+				rel->delta = 8 + args->data_imm.imm;
+				return;
+			} else if (args->data_imm.op == DA_DATA_OP_SUB) {
+				rel->delta = 8 - args->data_imm.imm;
+				return;
+			}
+		}
+		break;
+	case DA_GROUP_L_SIGN_IMM:
+		if (args->l_sign_imm.rn == DA_REG_R15) {
+			rel->delta = 8 + args->l_sign_imm.off;
+			return;
+		}
+		break;
+	case DA_GROUP_LS_HW_IMM:
+		if (args->ls_hw_imm.rn == DA_REG_R15) {
+			rel->delta = 8 + args->ls_hw_imm.off;
+			return;
+		}
+		break;
+	case DA_GROUP_LS_IMM:
+		if (args->ls_imm.rn == DA_REG_R15) {
+			rel->delta = 8 + args->ls_imm.off;
+			return;
+		}
+		break;
+	case DA_GROUP_LS_TWO_IMM:
+		if (args->ls_two_imm.rn == DA_REG_R15) {
+			rel->delta = 8 + args->ls_two_imm.off;
+			return;
+		}
 		break;
+	default:
+		break;
+	}
+
+	rel->present = 0;
+	rel->delta = 0;
+}
+
+/* Print the address independent part of the text of instruction as
+   da_instr_snprint does and store the description of the rest in rel.
+   The full text is this text followed by the text printed by
+   da_instr_snprint_rel_addr. */
+DA_API size_t
+da_instr_snprint_rel(char *buf, size_t len, const da_instr_t *instr,
+		     const da_instr_args_t *args, da_instr_rel_t *rel)
+{
+	char text[DA_EMIT_SIZE];
+	char *start = (len >= DA_EMIT_SIZE ? buf : text);
+	char *end = da_instr_print(start, instr, args, 0);
+
+	da_instr_rel(rel, instr, args);
+	if (rel->present) {
+		/* The address is at the end of the text */
+		char addr[DA_EMIT_SIZE];
+		end -= da_emit_hex(addr, rel->delta - rel->bits) - addr;
+	}
+
+	size_t n = end - start;
+	if (start == buf) {
+		*end = '\0';
+	} else if (len > 0) {
+		size_t copy = ((n < len) ? n : len - 1);
+		memcpy(buf, text, copy);
+		buf[copy] = '\0';
+	}
+	return n;
+}
+
+/* Print the address dependent part described by rel of the text of the
+   instruction at address addr. */
+DA_API size_t
+da_instr_snprint_rel_addr(char *buf, size_t len, const da_instr_rel_t *rel,
+			  da_addr_t addr)
+{
+	if (!rel->present) {
+		if (len > 0) buf[0] = '\0';
+		return 0;
+	}
+
+	char text[DA_EMIT_SIZE];
+	size_t n = da_emit_hex(text, addr + rel->delta - rel->bits) - text;
+	if (len > 0) {
+		size_t copy = ((n < len) ? n : len - 1);
+		memcpy(buf, text, copy);
+		buf[copy] = '\0';
 	}
+	return n;
+}
+
+/* Print instruction as da_instr_snprint does, with the branch target or
+   PC relative address printed as symbol+0xoffset if a symbol of symtab
+   covers it. */
+DA_API size_t
+da_instr_snprint_sym(char *buf, size_t len, const da_instr_t *instr,
+		     const da_instr_args_t *args, da_addr_t addr,
+		     const da_symtab_t *symtab)
+{
+	da_instr_rel_t rel;
+	size_t n = da_instr_snprint_rel(buf, len, instr, args, &rel);
+	if (!rel.present) return n;
+
+	size_t used = (n < len ? n : (len > 0 ? len - 1 : 0));
+	return n + da_symtab_snprint_addr(buf + used, len - used, symtab,
+					  addr + rel.delta);
+}
+
+DA_API void
+da_instr_fprint(FILE *f, const da_instr_t *instr, const da_instr_args_t *args,
+		da_addr_t addr)
+{
+	char text[DA_EMIT_SIZE];
+	size_t n = da_instr_print(text, instr, args, addr) - text;
+	fwrite(text, 1, n, f);
+}
+
+
+/* Thumb instructions */
+
+static const da_frag_t da_thumb_alu_frag_map[] = {
+	DA_FRAG("and\t"), DA_FRAG("eor\t"), DA_FRAG("lsl\t"), DA_FRAG("lsr\t"),
+	DA_FRAG("asr\t"), DA_FRAG("adc\t"), DA_FRAG("sbc\t"), DA_FRAG("ror\t"),
+	DA_FRAG("tst\t"), DA_FRAG("neg\t"), DA_FRAG("cmp\t"), DA_FRAG("cmn\t"),
+	DA_FRAG("orr\t"), DA_FRAG("mul\t"), DA_FRAG("bic\t"), DA_FRAG("mvn\t")
+};
+
+static const da_frag_t da_thumb_ls_frag_map[] = {
+	DA_FRAG("str\t"),   DA_FRAG("strh\t"),  DA_FRAG("strb\t"),
+	DA_FRAG("ldrsb\t"), DA_FRAG("ldr\t"),   DA_FRAG("ldrh\t"),
+	DA_FRAG("ldrb\t"),  DA_FRAG("ldrsh\t")
+};
+
+static const da_frag_t da_thumb_shift_frag_map[] = {
+	DA_FRAG("lsl\t"), DA_FRAG("lsr\t"), DA_FRAG("asr\t")
+};
+
+/* Append mnemonic and tab of data processing operation op. */
+static inline char *
+da_emit_thumb_data_op(char *p, da_uint_t op)
+{
+	return da_emit_frag(p, &da_data_op_frag_map[(op << 5) |
+						    (DA_COND_AL << 1)]);
+}
+
+/* Append ", #0x%x". */
+static inline char *
+da_emit_next_imm(char *p, da_uint_t imm)
+{
+	p = da_emit_str(p, ", #", 3);
+	return da_emit_hex(p, imm);
+}
+
+/* Return the word aligned pc used by pc relative instructions. */
+static inline da_addr_t
+da_thumb_pc(da_addr_t addr)
+{
+	return (addr + 4) & ~3;
+}
+
+static char *
+da_thumb_print(char *p, const da_thumb_instr_t *instr,
+	       const da_thumb_args_t *args, da_addr_t addr)
+{
+	switch (instr->group) {
+	case DA_THUMB_GROUP_ADD_PC_SP:
+		p = da_emit_str(p, "add\t", 4);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rn);
+		p = da_emit_next_imm(p, args->imm);
+		if (args->rn == DA_REG_R15) {
+			p = da_emit_addr_comment(p, da_thumb_pc(addr) +
+						 args->imm);
+		}
+		return p;
+	case DA_THUMB_GROUP_ADD_SUB_IMM:
+	case DA_THUMB_GROUP_ADD_SUB_REG:
+		p = da_emit_thumb_data_op(p, args->op);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rn);
+		if (instr->group == DA_THUMB_GROUP_ADD_SUB_REG) {
+			return da_emit_next_reg(p, args->rm);
+		}
+		return da_emit_next_imm(p, args->imm);
+	case DA_THUMB_GROUP_ADJUST_SP:
+		p = da_emit_thumb_data_op(p, args->op);
+		p = da_emit_reg(p, args->rd);
+		return da_emit_next_imm(p, args->imm);
+	case DA_THUMB_GROUP_B:
+		p = da_emit_str(p, "b\t", 2);
+		return da_emit_hex(p, addr + 4 + args->imm);
+	case DA_THUMB_GROUP_B_COND:
+		p = da_emit_char(p, 'b');
+		p = da_emit_frag(p, &da_cond_tab_frag_map[args->cond]);
+		return da_emit_hex(p, addr + 4 + args->imm);
+	case DA_THUMB_GROUP_BKPT:
+		p = da_emit_str(p, "bkpt\t", 5);
+		return da_emit_hex(p, args->imm);
+	case DA_THUMB_GROUP_BL_PREFIX:
+		/* Alone, the prefix is the add to lr that it performs */
+		p = da_emit_str(p, (args->imm < 0 ? "sub\t" : "add\t"), 4);
+		p = da_emit_str(p, "r14, r15, #", 11);
+		return da_emit_hex(p, abs(args->imm) << 12);
+	case DA_THUMB_GROUP_BL_SUFFIX:
+	case DA_THUMB_GROUP_BLX_SUFFIX:
+		/* Alone, the suffix branches relative to lr */
+		if (instr->group == DA_THUMB_GROUP_BLX_SUFFIX) {
+			p = da_emit_str(p, "blx\t[r14, #", 10);
+		} else {
+			p = da_emit_str(p, "bl\t[r14, #", 9);
+		}
+		p = da_emit_hex(p, args->imm << 1);
+		return da_emit_char(p, ']');
+	case DA_THUMB_GROUP_BX:
+		p = da_emit_str(p, (args->op ? "blx\t" : "bx\t"),
+				3 + args->op);
+		return da_emit_reg(p, args->rm);
+	case DA_THUMB_GROUP_DATA_IMM:
+		p = da_emit_thumb_data_op(p, args->op);
+		p = da_emit_reg(p, args->rd);
+		return da_emit_next_imm(p, args->imm);
+	case DA_THUMB_GROUP_DATA_REG:
+		p = da_emit_frag(p, &da_thumb_alu_frag_map[args->op]);
+		p = da_emit_reg(p, args->rd);
+		return da_emit_next_reg(p, args->rm);
+	case DA_THUMB_GROUP_HI_REG:
+		p = da_emit_thumb_data_op(p, args->op);
+		p = da_emit_reg(p, args->rd);
+		return da_emit_next_reg(p, args->rm);
+	case DA_THUMB_GROUP_LDR_PC:
+	case DA_THUMB_GROUP_LS_HW_IMM:
+	case DA_THUMB_GROUP_LS_IMM:
+	case DA_THUMB_GROUP_LS_SP:
+		p = da_emit_frag(p, &da_thumb_ls_frag_map[args->op]);
+		p = da_emit_ls_regs(p, args->rd, args->rn, 1);
+		if (args->imm != 0) p = da_emit_next_imm(p, args->imm);
+		p = da_emit_char(p, ']');
+		if (instr->group == DA_THUMB_GROUP_LDR_PC) {
+			p = da_emit_addr_comment(p, da_thumb_pc(addr) +
+						 args->imm);
+		}
+		return p;
+	case DA_THUMB_GROUP_LS_MULTI:
+		p = da_emit_str(p, (args->op ? "ldmia\t" : "stmia\t"), 6);
+		p = da_emit_reg(p, args->rn);
+		p = da_emit_str(p, "!, {", 4);
+		p = da_emit_reglist(p, args->imm);
+		return da_emit_str(p, " }", 2);
+	case DA_THUMB_GROUP_LS_REG:
+		p = da_emit_frag(p, &da_thumb_ls_frag_map[args->op]);
+		p = da_emit_ls_regs(p, args->rd, args->rn, 1);
+		p = da_emit_next_reg(p, args->rm);
+		return da_emit_char(p, ']');
+	case DA_THUMB_GROUP_PUSH_POP:
+		p = da_emit_str(p, (args->op ? "pop\t{" : "push\t{"),
+				5 + !args->op);
+		p = da_emit_reglist(p, (da_uint_t)args->imm & 0xffff);
+		return da_emit_str(p, " }", 2);
+	case DA_THUMB_GROUP_SHIFT_IMM:
+		p = da_emit_frag(p, &da_thumb_shift_frag_map[args->op]);
+		p = da_emit_reg(p, args->rd);
+		p = da_emit_next_reg(p, args->rm);
+		return da_emit_next_imm(p, args->imm);
+	case DA_THUMB_GROUP_SWI:
+		p = da_emit_str(p, "swi\t", 4);
+		return da_emit_hex(p, args->imm);
+	case DA_THUMB_GROUP_UNDEF:
+	case DA_THUMB_GROUP_MAX:
+		return da_emit_str(p, "undefined", 9);
+	}
+
+	return p;
+}
+
+/* Print Thumb instruction as da_instr_snprint does. A lone BL or BLX
+   prefix or suffix is printed as the operation it performs by itself;
+   use da_thumb_snprint_bl to print the pair as one branch. */
+DA_API size_t
+da_thumb_snprint(char *buf, size_t len, const da_thumb_instr_t *instr,
+		 const da_thumb_args_t *args, da_addr_t addr)
+{
+	if (len >= DA_EMIT_SIZE) {
+		char *end = da_thumb_print(buf, instr, args, addr);
+		*end = '\0';
+		return end - buf;
+	} else {
+		char text[DA_EMIT_SIZE];
+		char *end = da_thumb_print(text, instr, args, addr);
+		return da_copy_text(buf, len, text, end - text);
+	}
+}
+
+/* Append the mnemonic of a BL or BLX pair. */
+static char *
+da_thumb_print_bl_op(char *p, const da_thumb_args_t *suffix)
+{
+	int blx = (suffix->group == DA_THUMB_GROUP_BLX_SUFFIX);
+	return da_emit_str(p, (blx ? "blx\t" : "bl\t"), 3 + blx);
+}
+
+/* Print BL or BLX pair whose prefix is at address addr. */
+DA_API size_t
+da_thumb_snprint_bl(char *buf, size_t len, const da_thumb_args_t *prefix,
+		    const da_thumb_args_t *suffix, da_addr_t addr)
+{
+	char text[DA_EMIT_SIZE];
+	char *end = da_thumb_print_bl_op(text, suffix);
+	end = da_emit_hex(end, da_thumb_bl_target(prefix, suffix, addr));
+	return da_copy_text(buf, len, text, end - text);
+}
+
+/* Print BL or BLX pair as da_thumb_snprint_bl does, with the target
+   printed as symbol+0xoffset if a symbol of symtab covers it. */
+DA_API size_t
+da_thumb_snprint_bl_sym(char *buf, size_t len, const da_thumb_args_t *prefix,
+			const da_thumb_args_t *suffix, da_addr_t addr,
+			const da_symtab_t *symtab)
+{
+	char text[DA_EMIT_SIZE];
+	char *end = da_thumb_print_bl_op(text, suffix);
+	size_t n = da_copy_text(buf, len, text, end - text);
+
+	size_t used = (n < len ? n : (len > 0 ? len - 1 : 0));
+	return n + da_symtab_snprint_addr(buf + used, len - used, symtab,
+					  da_thumb_bl_target(prefix, suffix,
+							     addr));
+}
+
+DA_API void
+da_thumb_fprint(FILE *f, const da_thumb_instr_t *instr,
+		const da_thumb_args_t *args, da_addr_t addr)
+{
+	char text[DA_EMIT_SIZE];
+	char *end = da_thumb_print(text, instr, args, addr);
+	fwrite(text, 1, end - text, f);
 }
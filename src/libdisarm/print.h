@@ -21,12 +21,50 @@
 #ifndef _LIBDISARM_PRINT_H
 #define _LIBDISARM_PRINT_H
 
+#include <stddef.h>
 #include <stdio.h>
 
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/packed.h>
+#include <libdisarm/symtab.h>
+#include <libdisarm/thumb.h>
 #include <libdisarm/types.h>
 
 DA_BEGIN_DECLS
 
+/* Address dependent end of the text of an instruction: the branch target
+   or the address comment of a PC relative instruction, at addr + delta
+   for the instruction at address addr. It is printed as "0x%x" of
+   addr + delta - bits, where bits is the H bit of BLX immediate (see
+   da_instr_blx_target) and 0 otherwise. */
+typedef struct {
+	int present;
+	da_word_t delta;
+	da_word_t bits;
+} da_instr_rel_t;
+
+
+size_t da_instr_snprint(char *buf, size_t len, const da_instr_t *instr,
+			const da_instr_args_t *args, da_addr_t addr);
+size_t da_instr_snprint_block(char *buf, size_t len, size_t *offsets,
+			      const da_instr_t *instrs,
+			      const da_instr_args_t *args, size_t count,
+			      da_addr_t addr);
+size_t da_instr_snprint_packed(char *buf, size_t len,
+			       const da_instr_packed_t *packed,
+			       da_addr_t addr);
+size_t da_instr_snprint_rel(char *buf, size_t len, const da_instr_t *instr,
+			    const da_instr_args_t *args, da_instr_rel_t *rel);
+size_t da_instr_snprint_rel_addr(char *buf, size_t len,
+				 const da_instr_rel_t *rel, da_addr_t addr);
+size_t da_instr_snprint_sym(char *buf, size_t len, const da_instr_t *instr,
+			    const da_instr_args_t *args, da_addr_t addr,
+			    const da_symtab_t *symtab);
+size_t da_thumb_snprint_bl_sym(char *buf, size_t len,
+			       const da_thumb_args_t *prefix,
+			       const da_thumb_args_t *suffix, da_addr_t addr,
+			       const da_symtab_t *symtab);
 void da_instr_fprint(FILE *f, const da_instr_t *instr,
 		     const da_instr_args_t *args, da_addr_t addr);
 
@@ -0,0 +1,631 @@
+/*
+ * query.c - Instruction search
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "endian.h"
+#include "group.h"
+#include "macros.h"
+#include "names.h"
+#include "parser.h"
+#include "query.h"
+#include "types.h"
+
+#if defined(DA_SIMD) && defined(HAVE_EMMINTRIN_H) && defined(__SSE2__)
+# define DA_SIMD_SSE2  1
+# include <emmintrin.h>
+# if defined(HAVE_IMMINTRIN_H) && defined(__GNUC__) &&  \
+	(__GNUC__ >= 5 || defined(__clang__))
+#  define DA_SIMD_AVX2  1
+#  include <immintrin.h>
+# endif
+#endif
+
+
+/* Maximum length of the words of a query */
+#define DA_QUERY_TOKEN_SIZE  32
+
+/* Shift of fields that are not bits of the word, like rotated immediates
+   and signed offsets */
+#define DA_QUERY_COMPUTED  0xff
+
+/* Number of words compared at a time */
+#define DA_QUERY_STEP  32
+
+
+/* Field of the arguments of a group */
+typedef struct {
+	da_group_t group;
+	const char *name;
+	size_t offset;
+	unsigned int shift;
+	da_uint_t mask;
+} da_query_field_desc_t;
+
+#define N  DA_QUERY_COMPUTED
+#define FIELD(G, g, f, shift, mask) \
+	{ DA_GROUP_ ## G, #f, offsetof(da_instr_args_t, g.f), shift, mask }
+
+/* The fields of da_instr_args_t. The bit positions must match the DA_ARG
+   calls in args.c. */
+static const da_query_field_desc_t da_query_fields[] = {
+	FIELD(BKPT, bkpt, cond, 28, DA_COND_MASK),
+	FIELD(BKPT, bkpt, imm, N, 0),
+	FIELD(BL, bl, cond, 28, DA_COND_MASK),
+	FIELD(BL, bl, link, 24, 0x1),
+	FIELD(BL, bl, off, 0, 0xffffff),
+	FIELD(BLX_IMM, blx_imm, h, 24, 0x1),
+	FIELD(BLX_IMM, blx_imm, off, 0, 0xffffff),
+	FIELD(BLX_REG, blx_reg, cond, 28, DA_COND_MASK),
+	FIELD(BLX_REG, blx_reg, link, 5, 0x1),
+	FIELD(BLX_REG, blx_reg, rm, 0, DA_REG_MASK),
+	FIELD(CLZ, clz, cond, 28, DA_COND_MASK),
+	FIELD(CLZ, clz, rd, 12, DA_REG_MASK),
+	FIELD(CLZ, clz, rm, 0, DA_REG_MASK),
+	FIELD(CP_DATA, cp_data, cond, 28, DA_COND_MASK),
+	FIELD(CP_DATA, cp_data, op_1, 20, 0xf),
+	FIELD(CP_DATA, cp_data, crn, 16, DA_CPREG_MASK),
+	FIELD(CP_DATA, cp_data, crd, 12, DA_CPREG_MASK),
+	FIELD(CP_DATA, cp_data, cp_num, 8, 0xf),
+	FIELD(CP_DATA, cp_data, op_2, 5, 0x7),
+	FIELD(CP_DATA, cp_data, crm, 0, DA_CPREG_MASK),
+	FIELD(CP_LS, cp_ls, cond, 28, DA_COND_MASK),
+	FIELD(CP_LS, cp_ls, p, 24, 0x1),
+	FIELD(CP_LS, cp_ls, sign, 23, 0x1),
+	FIELD(CP_LS, cp_ls, n, 22, 0x1),
+	FIELD(CP_LS, cp_ls, write, 21, 0x1),
+	FIELD(CP_LS, cp_ls, load, 20, 0x1),
+	FIELD(CP_LS, cp_ls, rn, 16, DA_REG_MASK),
+	FIELD(CP_LS, cp_ls, crd, 12, DA_CPREG_MASK),
+	FIELD(CP_LS, cp_ls, cp_num, 8, 0xf),
+	FIELD(CP_LS, cp_ls, imm, 0, 0xff),
+	FIELD(CP_REG, cp_reg, cond, 28, DA_COND_MASK),
+	FIELD(CP_REG, cp_reg, op_1, 21, 0x7),
+	FIELD(CP_REG, cp_reg, load, 20, 0x1),
+	FIELD(CP_REG, cp_reg, crn, 16, DA_CPREG_MASK),
+	FIELD(CP_REG, cp_reg, rd, 12, DA_REG_MASK),
+	FIELD(CP_REG, cp_reg, cp_num, 8, 0xf),
+	FIELD(CP_REG, cp_reg, op_2, 5, 0x7),
+	FIELD(CP_REG, cp_reg, crm, 0, DA_CPREG_MASK),
+	FIELD(DATA_IMM, data_imm, cond, 28, DA_COND_MASK),
+	FIELD(DATA_IMM, data_imm, op, 21, DA_DATA_OP_MASK),
+	FIELD(DATA_IMM, data_imm, flags, 20, 0x1),
+	FIELD(DATA_IMM, data_imm, rn, 16, DA_REG_MASK),
+	FIELD(DATA_IMM, data_imm, rd, 12, DA_REG_MASK),
+	FIELD(DATA_IMM, data_imm, imm, N, 0),
+	FIELD(DATA_IMM_SH, data_imm_sh, cond, 28, DA_COND_MASK),
+	FIELD(DATA_IMM_SH, data_imm_sh, op, 21, DA_DATA_OP_MASK),
+	FIELD(DATA_IMM_SH, data_imm_sh, flags, 20, 0x1),
+	FIELD(DATA_IMM_SH, data_imm_sh, rn, 16, DA_REG_MASK),
+	FIELD(DATA_IMM_SH, data_imm_sh, rd, 12, DA_REG_MASK),
+	FIELD(DATA_IMM_SH, data_imm_sh, sha, 7, 0x1f),
+	FIELD(DATA_IMM_SH, data_imm_sh, sh, 5, DA_SHIFT_MASK),
+	FIELD(DATA_IMM_SH, data_imm_sh, rm, 0, DA_REG_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, cond, 28, DA_COND_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, op, 21, DA_DATA_OP_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, flags, 20, 0x1),
+	FIELD(DATA_REG_SH, data_reg_sh, rn, 16, DA_REG_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, rd, 12, DA_REG_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, rs, 8, DA_REG_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, sh, 5, DA_SHIFT_MASK),
+	FIELD(DATA_REG_SH, data_reg_sh, rm, 0, DA_REG_MASK),
+	FIELD(DSP_ADD_SUB, dsp_add_sub, cond, 28, DA_COND_MASK),
+	FIELD(DSP_ADD_SUB, dsp_add_sub, op, 21, 0x3),
+	FIELD(DSP_ADD_SUB, dsp_add_sub, rn, 16, DA_REG_MASK),
+	FIELD(DSP_ADD_SUB, dsp_add_sub, rd, 12, DA_REG_MASK),
+	FIELD(DSP_ADD_SUB, dsp_add_sub, rm, 0, DA_REG_MASK),
+	FIELD(DSP_MUL, dsp_mul, cond, 28, DA_COND_MASK),
+	FIELD(DSP_MUL, dsp_mul, op, 21, 0x3),
+	FIELD(DSP_MUL, dsp_mul, rd, 16, DA_REG_MASK),
+	FIELD(DSP_MUL, dsp_mul, rn, 12, DA_REG_MASK),
+	FIELD(DSP_MUL, dsp_mul, rs, 12, DA_REG_MASK),
+	FIELD(DSP_MUL, dsp_mul, y, 6, 0x1),
+	FIELD(DSP_MUL, dsp_mul, x, 5, 0x1),
+	FIELD(DSP_MUL, dsp_mul, rm, 0, DA_REG_MASK),
+	FIELD(L_SIGN_IMM, l_sign_imm, cond, 28, DA_COND_MASK),
+	FIELD(L_SIGN_IMM, l_sign_imm, p, 24, 0x1),
+	FIELD(L_SIGN_IMM, l_sign_imm, write, 21, 0x1),
+	FIELD(L_SIGN_IMM, l_sign_imm, rn, 16, DA_REG_MASK),
+	FIELD(L_SIGN_IMM, l_sign_imm, rd, 12, DA_REG_MASK),
+	FIELD(L_SIGN_IMM, l_sign_imm, hword, 5, 0x1),
+	FIELD(L_SIGN_IMM, l_sign_imm, off, N, 0),
+	FIELD(L_SIGN_REG, l_sign_reg, cond, 28, DA_COND_MASK),
+	FIELD(L_SIGN_REG, l_sign_reg, p, 24, 0x1),
+	FIELD(L_SIGN_REG, l_sign_reg, sign, 23, 0x1),
+	FIELD(L_SIGN_REG, l_sign_reg, write, 21, 0x1),
+	FIELD(L_SIGN_REG, l_sign_reg, rn, 16, DA_REG_MASK),
+	FIELD(L_SIGN_REG, l_sign_reg, rd, 12, DA_REG_MASK),
+	FIELD(L_SIGN_REG, l_sign_reg, hword, 5, 0x1),
+	FIELD(L_SIGN_REG, l_sign_reg, rm, 0, DA_REG_MASK),
+	FIELD(LS_HW_IMM, ls_hw_imm, cond, 28, DA_COND_MASK),
+	FIELD(LS_HW_IMM, ls_hw_imm, p, 24, 0x1),
+	FIELD(LS_HW_IMM, ls_hw_imm, write, 21, 0x1),
+	FIELD(LS_HW_IMM, ls_hw_imm, load, 20, 0x1),
+	FIELD(LS_HW_IMM, ls_hw_imm, rn, 16, DA_REG_MASK),
+	FIELD(LS_HW_IMM, ls_hw_imm, rd, 12, DA_REG_MASK),
+	FIELD(LS_HW_IMM, ls_hw_imm, off, N, 0),
+	FIELD(LS_HW_REG, ls_hw_reg, cond, 28, DA_COND_MASK),
+	FIELD(LS_HW_REG, ls_hw_reg, p, 24, 0x1),
+	FIELD(LS_HW_REG, ls_hw_reg, sign, 23, 0x1),
+	FIELD(LS_HW_REG, ls_hw_reg, write, 21, 0x1),
+	FIELD(LS_HW_REG, ls_hw_reg, load, 20, 0x1),
+	FIELD(LS_HW_REG, ls_hw_reg, rn, 16, DA_REG_MASK),
+	FIELD(LS_HW_REG, ls_hw_reg, rd, 12, DA_REG_MASK),
+	FIELD(LS_HW_REG, ls_hw_reg, rm, 0, DA_REG_MASK),
+	FIELD(LS_IMM, ls_imm, cond, 28, DA_COND_MASK),
+	FIELD(LS_IMM, ls_imm, p, 24, 0x1),
+	FIELD(LS_IMM, ls_imm, byte, 22, 0x1),
+	FIELD(LS_IMM, ls_imm, w, 21, 0x1),
+	FIELD(LS_IMM, ls_imm, load, 20, 0x1),
+	FIELD(LS_IMM, ls_imm, rn, 16, DA_REG_MASK),
+	FIELD(LS_IMM, ls_imm, rd, 12, DA_REG_MASK),
+	FIELD(LS_IMM, ls_imm, off, N, 0),
+	FIELD(LS_MULTI, ls_multi, cond, 28, DA_COND_MASK),
+	FIELD(LS_MULTI, ls_multi, p, 24, 0x1),
+	FIELD(LS_MULTI, ls_multi, u, 23, 0x1),
+	FIELD(LS_MULTI, ls_multi, s, 22, 0x1),
+	FIELD(LS_MULTI, ls_multi, write, 21, 0x1),
+	FIELD(LS_MULTI, ls_multi, load, 20, 0x1),
+	FIELD(LS_MULTI, ls_multi, rn, 16, DA_REG_MASK),
+	FIELD(LS_MULTI, ls_multi, reglist, 0, 0xffff),
+	FIELD(LS_REG, ls_reg, cond, 28, DA_COND_MASK),
+	FIELD(LS_REG, ls_reg, p, 24, 0x1),
+	FIELD(LS_REG, ls_reg, sign, 23, 0x1),
+	FIELD(LS_REG, ls_reg, byte, 22, 0x1),
+	FIELD(LS_REG, ls_reg, write, 21, 0x1),
+	FIELD(LS_REG, ls_reg, load, 20, 0x1),
+	FIELD(LS_REG, ls_reg, rn, 16, DA_REG_MASK),
+	FIELD(LS_REG, ls_reg, rd, 12, DA_REG_MASK),
+	FIELD(LS_REG, ls_reg, sha, 7, 0x1f),
+	FIELD(LS_REG, ls_reg, sh, 5, DA_SHIFT_MASK),
+	FIELD(LS_REG, ls_reg, rm, 0, DA_REG_MASK),
+	FIELD(LS_TWO_IMM, ls_two_imm, cond, 28, DA_COND_MASK),
+	FIELD(LS_TWO_IMM, ls_two_imm, p, 24, 0x1),
+	FIELD(LS_TWO_IMM, ls_two_imm, write, 21, 0x1),
+	FIELD(LS_TWO_IMM, ls_two_imm, rn, 16, DA_REG_MASK),
+	FIELD(LS_TWO_IMM, ls_two_imm, rd, 12, DA_REG_MASK),
+	FIELD(LS_TWO_IMM, ls_two_imm, store, 5, 0x1),
+	FIELD(LS_TWO_IMM, ls_two_imm, off, N, 0),
+	FIELD(LS_TWO_REG, ls_two_reg, cond, 28, DA_COND_MASK),
+	FIELD(LS_TWO_REG, ls_two_reg, p, 24, 0x1),
+	FIELD(LS_TWO_REG, ls_two_reg, sign, 23, 0x1),
+	FIELD(LS_TWO_REG, ls_two_reg, write, 21, 0x1),
+	FIELD(LS_TWO_REG, ls_two_reg, rn, 16, DA_REG_MASK),
+	FIELD(LS_TWO_REG, ls_two_reg, rd, 12, DA_REG_MASK),
+	FIELD(LS_TWO_REG, ls_two_reg, store, 5, 0x1),
+	FIELD(LS_TWO_REG, ls_two_reg, rm, 0, DA_REG_MASK),
+	FIELD(MRS, mrs, cond, 28, DA_COND_MASK),
+	FIELD(MRS, mrs, r, 22, 0x1),
+	FIELD(MRS, mrs, rd, 12, DA_REG_MASK),
+	FIELD(MSR, msr, cond, 28, DA_COND_MASK),
+	FIELD(MSR, msr, r, 22, 0x1),
+	FIELD(MSR, msr, mask, 16, 0xf),
+	FIELD(MSR, msr, rm, 0, DA_REG_MASK),
+	FIELD(MSR_IMM, msr_imm, cond, 28, DA_COND_MASK),
+	FIELD(MSR_IMM, msr_imm, r, 22, 0x1),
+	FIELD(MSR_IMM, msr_imm, mask, 16, 0xf),
+	FIELD(MSR_IMM, msr_imm, imm, N, 0),
+	FIELD(MUL, mul, cond, 28, DA_COND_MASK),
+	FIELD(MUL, mul, acc, 21, 0x1),
+	FIELD(MUL, mul, flags, 20, 0x1),
+	FIELD(MUL, mul, rd, 16, DA_REG_MASK),
+	FIELD(MUL, mul, rn, 12, DA_REG_MASK),
+	FIELD(MUL, mul, rs, 8, DA_REG_MASK),
+	FIELD(MUL, mul, rm, 0, DA_REG_MASK),
+	FIELD(MULL, mull, cond, 28, DA_COND_MASK),
+	FIELD(MULL, mull, sign, 22, 0x1),
+	FIELD(MULL, mull, acc, 21, 0x1),
+	FIELD(MULL, mull, flags, 20, 0x1),
+	FIELD(MULL, mull, rd_hi, 16, DA_REG_MASK),
+	FIELD(MULL, mull, rd_lo, 12, DA_REG_MASK),
+	FIELD(MULL, mull, rs, 8, DA_REG_MASK),
+	FIELD(MULL, mull, rm, 0, DA_REG_MASK),
+	FIELD(SWI, swi, cond, 28, DA_COND_MASK),
+	FIELD(SWI, swi, imm, 0, 0xffffff),
+	FIELD(SWP, swp, cond, 28, DA_COND_MASK),
+	FIELD(SWP, swp, byte, 22, 0x1),
+	FIELD(SWP, swp, rn, 16, DA_REG_MASK),
+	FIELD(SWP, swp, rd, 12, DA_REG_MASK),
+	FIELD(SWP, swp, rm, 10, DA_REG_MASK)
+};
+
+#define DA_QUERY_NFIELDS \
+	(sizeof(da_query_fields) / sizeof(da_query_fields[0]))
+
+/* The cond field of queries for any group */
+static const da_query_field_desc_t da_query_cond_field = {
+	DA_GROUP_MAX, "cond", 0, 28, DA_COND_MASK
+};
+
+
+/* Set the mask and value that all words of group have in common, and
+   whether all words that have them are of the group (exact), or all such
+   words with a condition other than nv (exact_cond). The group depends
+   only on the bits of the group index, so it is enough to look at one
+   word per index. */
+static void
+da_query_group_bits(da_group_t group, da_word_t *mask, da_word_t *value,
+		    int *exact, int *exact_cond)
+{
+	static const da_word_t index_bits = 0x0ff000f0;
+	da_word_t words[1 << DA_GROUP_INDEX_BITS];
+	unsigned char groups[1 << DA_GROUP_INDEX_BITS];
+	size_t n = 1 << DA_GROUP_INDEX_BITS;
+	size_t i;
+
+	for (i = 0; i < n; i++) words[i] = DA_GROUP_INDEX_WORD(i);
+	da_instr_parse_groups(groups, words, n);
+
+	da_word_t and_bits = ~(da_word_t)0;
+	da_word_t or_bits = 0;
+	size_t count = 0;
+	int nv = 1;
+	for (i = 0; i < n; i++) {
+		if (groups[i] != group) continue;
+		and_bits &= words[i];
+		or_bits |= words[i];
+		count += 1;
+		if (!(i & 0x1000)) nv = 0;
+	}
+
+	if (count == 0) {
+		*mask = 0;
+		*value = 0;
+		*exact = 0;
+		*exact_cond = 0;
+		return;
+	}
+
+	*mask = ~(and_bits ^ or_bits) & index_bits;
+	if (nv) *mask |= 0xf0000000;
+	*value = and_bits & *mask;
+
+	size_t matches = 0;
+	int other = 0;
+	for (i = 0; i < n; i++) {
+		if ((words[i] & *mask) != *value) continue;
+		matches += 1;
+		if (!(i & 0x1000) && groups[i] != group) other = 1;
+	}
+	*exact = (matches == count);
+	*exact_cond = !other;
+}
+
+/* Copy the next word of the query at *p to token and advance *p. Return
+   the length of the word, or -1 if it is too long. */
+static int
+da_query_token(const char **p, char *token)
+{
+	const char *s = *p;
+	while (*s == ' ' || *s == '\t') s += 1;
+
+	size_t len = 0;
+	while (s[len] != '\0' && s[len] != ' ' && s[len] != '\t') len += 1;
+	if (len >= DA_QUERY_TOKEN_SIZE) return -1;
+
+	memcpy(token, s, len);
+	token[len] = '\0';
+	*p = s + len;
+	return len;
+}
+
+/* Return index of name in map of size entries, or -1. */
+static int
+da_query_lookup(const char *const *map, size_t size, const char *name)
+{
+	size_t i;
+	for (i = 0; i < size; i++) {
+		if (map[i][0] != '\0' && !strcmp(map[i], name)) return i;
+	}
+	return -1;
+}
+
+/* Parse value of a field: a number, a register, a condition, a data
+   processing opcode or a shift. Return -1 if it is none of them. */
+static int
+da_query_value(const char *s, da_uint_t *value)
+{
+	char *end;
+	long long v = strtoll(s, &end, 0);
+	if (end != s && *end == '\0') {
+		*value = v;
+		return 0;
+	}
+
+	/* Registers and coprocessor registers */
+	const char *r = s;
+	if (r[0] == 'c' && r[1] == 'r') r += 1;
+	if (r[0] == 'r' && r[1] >= '0' && r[1] <= '9') {
+		v = strtol(r + 1, &end, 10);
+		if (*end == '\0' && v < DA_REG_MAX) {
+			*value = v;
+			return 0;
+		}
+	}
+	if (!strcmp(s, "sp")) *value = DA_REG_R13;
+	else if (!strcmp(s, "lr")) *value = DA_REG_R14;
+	else if (!strcmp(s, "pc")) *value = DA_REG_R15;
+	else if (!strcmp(s, "al")) *value = DA_COND_AL;
+	else {
+		int i = da_query_lookup(da_cond_map, DA_COND_MAX, s);
+		if (i < 0) i = da_query_lookup(da_data_op_map, DA_DATA_OP_MAX,
+					       s);
+		if (i < 0) i = da_query_lookup(da_shift_map, DA_SHIFT_MAX, s);
+		if (i < 0) return -1;
+		*value = i;
+	}
+
+	return 0;
+}
+
+/* Compile query text: a group name, or * for any group, followed by
+   constraints FIELD=VALUE on the fields of the group's arguments. VALUE
+   is a number, a register, a condition, an opcode or a shift name, or *
+   for any value. Queries for any group only take the cond field. Return
+   -1 if the query is invalid. */
+DA_API int
+da_query_compile(da_query_t *query, const char *text)
+{
+	char token[DA_QUERY_TOKEN_SIZE];
+	const char *p = text;
+	int exact = 1, exact_cond = 1, exact_fields = 1;
+	int cond = -1;
+
+	memset(query, 0, sizeof(da_query_t));
+	query->group = DA_GROUP_MAX;
+
+	if (da_query_token(&p, token) <= 0) return -1;
+	if (strcmp(token, "*")) {
+		int g;
+		for (g = 0; g < DA_GROUP_MAX; g++) {
+			if (!strcmp(da_group_name(g), token)) break;
+		}
+		if (g == DA_GROUP_MAX) return -1;
+
+		query->group = g;
+		da_query_group_bits(g, &query->mask, &query->value, &exact,
+				    &exact_cond);
+	}
+
+	for (;;) {
+		int len = da_query_token(&p, token);
+		if (len < 0) return -1;
+		else if (len == 0) break;
+
+		char *s = strchr(token, '=');
+		if (s == NULL) return -1;
+		*s++ = '\0';
+
+		const da_query_field_desc_t *field = NULL;
+		if (query->group == DA_GROUP_MAX) {
+			if (!strcmp(token, da_query_cond_field.name)) {
+				field = &da_query_cond_field;
+			}
+		} else {
+			size_t i;
+			for (i = 0; i < DA_QUERY_NFIELDS; i++) {
+				if (da_query_fields[i].group == query->group &&
+				    !strcmp(da_query_fields[i].name, token)) {
+					field = &da_query_fields[i];
+					break;
+				}
+			}
+		}
+		if (field == NULL) return -1;
+
+		if (!strcmp(s, "*")) continue;
+
+		da_uint_t value;
+		if (da_query_value(s, &value) < 0) return -1;
+
+		if (field->shift == DA_QUERY_COMPUTED) {
+			if (query->nfields == DA_QUERY_MAX_FIELDS) return -1;
+			query->fields[query->nfields].offset = field->offset;
+			query->fields[query->nfields].value = value;
+			query->nfields += 1;
+			exact_fields = 0;
+			continue;
+		}
+
+		if (value & ~field->mask) return -1;
+
+		/* Fields that overlap the group bits are checked by the
+		   group */
+		da_word_t bits = field->mask << field->shift;
+		if (query->mask & bits) exact_fields = 0;
+		query->mask |= bits;
+		query->value = (query->value & ~bits) | (value << field->shift);
+		if (!strcmp(field->name, "cond")) cond = value;
+	}
+
+	/* Words that match need no decoding if the mask and value only
+	   match words of the group */
+	query->exact = exact_fields &&
+		(exact || (exact_cond && cond >= 0 && cond != DA_COND_NV));
+
+	return 0;
+}
+
+/* Return true if instr matches query. */
+DA_API int
+da_query_match(const da_query_t *query, const da_instr_t *instr)
+{
+	if ((instr->data & query->mask) != query->value) return 0;
+	if (query->exact) return 1;
+	if (query->group != DA_GROUP_MAX && instr->group != query->group) {
+		return 0;
+	}
+
+	if (query->nfields > 0) {
+		da_instr_args_t args;
+		da_instr_parse_args(&args, instr);
+
+		size_t i;
+		for (i = 0; i < query->nfields; i++) {
+			const da_query_field_t *f = &query->fields[i];
+			da_uint_t value;
+			memcpy(&value, (const char *)&args + f->offset,
+			       sizeof(da_uint_t));
+			if (value != f->value) return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* Return bit i set for each of the DA_QUERY_STEP words from data that
+   have (data[i] & mask) == value. */
+static uint32_t
+da_query_compare(const da_word_t *data, da_word_t mask, da_word_t value)
+{
+	uint32_t bits = 0;
+	int i;
+	for (i = 0; i < DA_QUERY_STEP; i++) {
+		bits |= (uint32_t)((data[i] & mask) == value) << i;
+	}
+	return bits;
+}
+
+#ifdef DA_SIMD_SSE2
+static uint32_t
+da_query_compare_sse2(const da_word_t *data, da_word_t mask,
+		      da_word_t value)
+{
+	const __m128i m = _mm_set1_epi32(mask);
+	const __m128i v = _mm_set1_epi32(value);
+	uint32_t bits = 0;
+	int i;
+	for (i = 0; i < DA_QUERY_STEP; i += 16) {
+		__m128i c[4];
+		int j;
+		for (j = 0; j < 4; j++) {
+			__m128i w = _mm_loadu_si128(
+				(const __m128i *)&data[i + 4*j]);
+			c[j] = _mm_cmpeq_epi32(_mm_and_si128(w, m), v);
+		}
+
+		/* Pack the compare masks to bytes in word order */
+		__m128i b = _mm_packs_epi16(_mm_packs_epi32(c[0], c[1]),
+					    _mm_packs_epi32(c[2], c[3]));
+		bits |= (uint32_t)_mm_movemask_epi8(b) << i;
+	}
+	return bits;
+}
+#endif
+
+#ifdef DA_SIMD_AVX2
+static __attribute__ ((__target__("avx2"))) uint32_t
+da_query_compare_avx2(const da_word_t *data, da_word_t mask,
+		      da_word_t value)
+{
+	const __m256i m = _mm256_set1_epi32(mask);
+	const __m256i v = _mm256_set1_epi32(value);
+	uint32_t bits = 0;
+	int i;
+	for (i = 0; i < DA_QUERY_STEP; i += 8) {
+		__m256i w = _mm256_loadu_si256((const __m256i *)&data[i]);
+		__m256i c = _mm256_cmpeq_epi32(_mm256_and_si256(w, m), v);
+		bits |= (uint32_t)_mm256_movemask_ps(
+			_mm256_castsi256_ps(c)) << i;
+	}
+	return bits;
+}
+#endif
+
+/* Return index of the lowest set bit of bits, which is not zero. */
+static inline int
+da_query_lowest(uint32_t bits)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(bits);
+#else
+	int i = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		i += 1;
+	}
+	return i;
+#endif
+}
+
+/* Find the words among count words from data that match query. Words are
+   compared with the mask and value of the query using vector compares,
+   and only candidates that are not matched exactly are decoded. Store
+   the indices of up to max matching words in hits and return the number
+   stored. If it is max, the search can continue after the last hit. */
+DA_API size_t
+da_query_find(const da_query_t *query, size_t *hits, size_t max,
+	      const da_word_t *data, size_t count, int big_endian)
+{
+	/* Compare in the byte order of the data */
+	da_word_t mask = (big_endian ? htobe32(query->mask) :
+			  htole32(query->mask));
+	da_word_t value = (big_endian ? htobe32(query->value) :
+			   htole32(query->value));
+
+	uint32_t (*compare)(const da_word_t *, da_word_t, da_word_t) =
+		da_query_compare;
+#ifdef DA_SIMD_SSE2
+	compare = da_query_compare_sse2;
+#endif
+#ifdef DA_SIMD_AVX2
+	if (__builtin_cpu_supports("avx2")) compare = da_query_compare_avx2;
+#endif
+
+	size_t n = 0;
+	size_t i = 0;
+	while (i < count && n < max) {
+		uint32_t bits;
+		if (i + DA_QUERY_STEP <= count) {
+			bits = compare(&data[i], mask, value);
+		} else {
+			bits = 0;
+			size_t j;
+			for (j = 0; i + j < count; j++) {
+				bits |= (uint32_t)((data[i + j] & mask) ==
+						   value) << j;
+			}
+		}
+
+		while (bits != 0 && n < max) {
+			size_t j = i + da_query_lowest(bits);
+			bits &= bits - 1;
+
+			if (!query->exact) {
+				da_instr_t instr;
+				da_instr_parse(&instr, data[j], big_endian);
+				if (!da_query_match(query, &instr)) continue;
+			}
+			hits[n++] = j;
+		}
+
+		i += DA_QUERY_STEP;
+	}
+
+	return n;
+}
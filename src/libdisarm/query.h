@@ -0,0 +1,62 @@
+/*
+ * query.h - Instruction search header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_QUERY_H
+#define _LIBDISARM_QUERY_H
+
+#include <stddef.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Maximum number of fields of a query checked on the arguments */
+#define DA_QUERY_MAX_FIELDS  16
+
+DA_BEGIN_DECLS
+
+/* Field of the arguments of matching instructions */
+typedef struct {
+	size_t offset;
+	da_uint_t value;
+} da_query_field_t;
+
+/* Compiled query. Matching words have (data & mask) == value; unless the
+   query is exact, they must also be of the group (if not DA_GROUP_MAX)
+   and have the fields. */
+typedef struct {
+	da_group_t group;
+	da_word_t mask;
+	da_word_t value;
+	int exact;
+	size_t nfields;
+	da_query_field_t fields[DA_QUERY_MAX_FIELDS];
+} da_query_t;
+
+
+int da_query_compile(da_query_t *query, const char *text);
+int da_query_match(const da_query_t *query, const da_instr_t *instr);
+size_t da_query_find(const da_query_t *query, size_t *hits, size_t max,
+		     const da_word_t *data, size_t count, int big_endian);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_QUERY_H */
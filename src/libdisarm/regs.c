@@ -0,0 +1,306 @@
+/*
+ * regs.c - Register use
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macros.h"
+#include "regs.h"
+#include "types.h"
+
+
+/* Operand bits above the fixed registers and flags, selecting the
+   register fields at bits 0, 8, 12 and 16, the register after the field
+   at bit 12 and the register list in bits 0-15. */
+#define DA_REGS_FIELD(s)  (1 << (24 + (s) / 4))
+#define DA_REGS_NEXT      (1 << 29)
+#define DA_REGS_LIST      (1 << 30)
+
+/* A rule applies to an instruction if (data & mask) == value, adding its
+   operands to the read and written masks. Killed operands are removed
+   from the written mask after all rules are applied. */
+typedef struct {
+	uint32_t mask;
+	uint32_t value;
+	uint32_t read;
+	uint32_t written;
+	uint32_t killed;
+} da_regs_rule_t;
+
+/* Operands read and written by all instructions of a group, and the
+   rules for the rest */
+typedef struct {
+	uint32_t read;
+	uint32_t written;
+	const da_regs_rule_t *rules;
+	size_t count;
+} da_regs_map_t;
+
+
+/* Shorthands for the rules below. Fields are taken from the architecture
+   encoding, so rm of swp and rs of dsp_mul differ from args.c. */
+#define SET(bit)  (1 << (bit)), (1 << (bit))
+#define CLEAR(bit)  (1 << (bit)), 0
+#define RULE(...)  RULE_(__VA_ARGS__)
+#define RULE_(mask, value, r, w)  { mask, value, r, w, 0 }
+
+#define RD  DA_REGS_FIELD(12)
+#define RN  DA_REGS_FIELD(16)
+#define RM  DA_REGS_FIELD(0)
+#define RS  DA_REGS_FIELD(8)
+#define PAIR  (DA_REGS_FIELD(12) | DA_REGS_NEXT)
+#define LIST  DA_REGS_LIST
+#define PC  (1 << DA_REG_R15)
+#define LR  (1 << DA_REG_R14)
+#define CPSR  DA_REGS_CPSR
+#define MEMORY  DA_REGS_MEMORY
+
+/* Multiplies have rd in bits 16-19 and rn in bits 12-15 */
+#define MUL_RD  DA_REGS_FIELD(16)
+#define MUL_RN  DA_REGS_FIELD(12)
+
+/* Opcode bits of data processing instructions */
+#define OP(x)  ((x) << 21)
+
+/* Shift field of RRX, which reads the carry flag */
+#define RRX  0xfe0, 0x060
+
+/* Data processing: rd is not written by tst, teq, cmp and cmn (10xx), rn
+   is not read by mov and mvn (11x1), and adc, sbc and rsc read the
+   carry flag. */
+#define DATA_RULES \
+	RULE(CLEAR(24), RN, RD), \
+	RULE(OP(0xc), OP(0x8), RN, 0), \
+	RULE(OP(0xd), OP(0xc), RN, 0), \
+	RULE(OP(0xc), OP(0xc), 0, RD), \
+	RULE(OP(0xf), OP(0x5), CPSR, 0), \
+	RULE(OP(0xe), OP(0x6), CPSR, 0), \
+	RULE(SET(20), 0, CPSR)
+
+/* Load/store: rn is written back if post-indexed or if W is set, and
+   the operand op is loaded if bit l is set. */
+#define LS_RULES(l, op) \
+	RULE(CLEAR(24), 0, RN), \
+	RULE(SET(21), 0, RN), \
+	RULE(SET(l), MEMORY, op), \
+	RULE(CLEAR(l), op, MEMORY)
+
+/* ldm with S set and the pc in the list */
+#define LDM_S_PC  ((1 << 22) | (1 << 20) | (1 << 15))
+
+static const da_regs_rule_t da_regs_bl[] = {
+	RULE(SET(24), 0, LR)
+};
+
+static const da_regs_rule_t da_regs_blx_reg[] = {
+	RULE(SET(5), 0, LR)
+};
+
+/* ldc and stc are unindexed with P clear */
+static const da_regs_rule_t da_regs_cp_ls[] = {
+	RULE(SET(21), 0, RN),
+	RULE(SET(20), MEMORY, 0),
+	RULE(CLEAR(20), 0, MEMORY)
+};
+
+/* mrc to r15 writes the condition flags */
+static const da_regs_rule_t da_regs_cp_reg[] = {
+	RULE(SET(20), 0, RD),
+	RULE(CLEAR(20), RD, 0),
+	{ (1 << 20) | (0xf << 12), (1 << 20) | (0xf << 12), 0, CPSR, PC }
+};
+
+static const da_regs_rule_t da_regs_data[] = {
+	DATA_RULES
+};
+
+static const da_regs_rule_t da_regs_data_imm_sh[] = {
+	DATA_RULES,
+	RULE(RRX, CPSR, 0)
+};
+
+/* smla<x><y> and smlaw<y> accumulate rn and set Q, smlal<x><y>
+   accumulates rdhi:rdlo, smulw<y> and smul<x><y> only multiply. */
+static const da_regs_rule_t da_regs_dsp_mul[] = {
+	RULE(3 << 21, 0, MUL_RN, CPSR),
+	RULE((3 << 21) | (1 << 5), 1 << 21, MUL_RN, CPSR),
+	RULE(3 << 21, 2 << 21, MUL_RN | MUL_RD, MUL_RN)
+};
+
+/* Signed loads always load */
+static const da_regs_rule_t da_regs_l_sign[] = {
+	RULE(CLEAR(24), 0, RN),
+	RULE(SET(21), 0, RN)
+};
+
+static const da_regs_rule_t da_regs_ls[] = {
+	LS_RULES(20, RD)
+};
+
+static const da_regs_rule_t da_regs_ls_reg[] = {
+	LS_RULES(20, RD),
+	RULE(RRX, CPSR, 0)
+};
+
+/* ldm with the pc and S set restores the status register */
+static const da_regs_rule_t da_regs_ls_multi[] = {
+	RULE(SET(21), 0, RN),
+	RULE(SET(20), MEMORY, LIST),
+	RULE(CLEAR(20), LIST, MEMORY),
+	RULE(LDM_S_PC, LDM_S_PC, 0, CPSR)
+};
+
+/* ldrd is encoded with bit 5 clear */
+static const da_regs_rule_t da_regs_ls_two[] = {
+	RULE(CLEAR(24), 0, RN),
+	RULE(SET(21), 0, RN),
+	RULE(CLEAR(5), MEMORY, PAIR),
+	RULE(SET(5), PAIR, MEMORY)
+};
+
+static const da_regs_rule_t da_regs_mul[] = {
+	RULE(SET(21), MUL_RN, 0),
+	RULE(SET(20), 0, CPSR)
+};
+
+static const da_regs_rule_t da_regs_mull[] = {
+	RULE(SET(21), RD | RN, 0),
+	RULE(SET(20), 0, CPSR)
+};
+
+#define GROUP(r, w, rules)  { r, w, rules, sizeof(rules) / sizeof(rules[0]) }
+#define BASE(r, w)  { r, w, NULL, 0 }
+
+/* Exceptions only write the pc; banked registers are not included */
+static const da_regs_map_t da_regs_map[DA_GROUP_MAX] = {
+	[DA_GROUP_BKPT] = BASE(0, PC),
+	[DA_GROUP_BL] = GROUP(PC, PC, da_regs_bl),
+	[DA_GROUP_BLX_IMM] = BASE(PC, PC | LR),
+	[DA_GROUP_BLX_REG] = GROUP(RM, PC, da_regs_blx_reg),
+	[DA_GROUP_CLZ] = BASE(RM, RD),
+	[DA_GROUP_CP_DATA] = BASE(0, 0),
+	[DA_GROUP_CP_LS] = GROUP(RN, 0, da_regs_cp_ls),
+	[DA_GROUP_CP_REG] = GROUP(0, 0, da_regs_cp_reg),
+	[DA_GROUP_DATA_IMM] = GROUP(0, 0, da_regs_data),
+	[DA_GROUP_DATA_IMM_SH] = GROUP(RM, 0, da_regs_data_imm_sh),
+	[DA_GROUP_DATA_REG_SH] = GROUP(RM | RS, 0, da_regs_data),
+	[DA_GROUP_DSP_ADD_SUB] = BASE(RN | RM, RD | CPSR),
+	[DA_GROUP_DSP_MUL] = GROUP(RM | RS, MUL_RD, da_regs_dsp_mul),
+	[DA_GROUP_L_SIGN_IMM] = GROUP(RN | MEMORY, RD, da_regs_l_sign),
+	[DA_GROUP_L_SIGN_REG] = GROUP(RN | RM | MEMORY, RD, da_regs_l_sign),
+	[DA_GROUP_LS_HW_IMM] = GROUP(RN, 0, da_regs_ls),
+	[DA_GROUP_LS_HW_REG] = GROUP(RN | RM, 0, da_regs_ls),
+	[DA_GROUP_LS_IMM] = GROUP(RN, 0, da_regs_ls),
+	[DA_GROUP_LS_MULTI] = GROUP(RN, 0, da_regs_ls_multi),
+	[DA_GROUP_LS_REG] = GROUP(RN | RM, 0, da_regs_ls_reg),
+	[DA_GROUP_LS_TWO_IMM] = GROUP(RN, 0, da_regs_ls_two),
+	[DA_GROUP_LS_TWO_REG] = GROUP(RN | RM, 0, da_regs_ls_two),
+	[DA_GROUP_MRS] = BASE(CPSR, RD),
+	[DA_GROUP_MSR] = BASE(RM, CPSR),
+	[DA_GROUP_MSR_IMM] = BASE(0, CPSR),
+	[DA_GROUP_MUL] = GROUP(RM | RS, MUL_RD, da_regs_mul),
+	[DA_GROUP_MULL] = GROUP(RM | RS, RD | RN, da_regs_mull),
+	[DA_GROUP_SWI] = BASE(0, PC),
+	[DA_GROUP_SWP] = BASE(RN | RM | MEMORY, RD | MEMORY),
+	[DA_GROUP_UNDEF_1] = BASE(0, 0),
+	[DA_GROUP_UNDEF_2] = BASE(0, 0),
+	[DA_GROUP_UNDEF_3] = BASE(0, 0),
+	[DA_GROUP_UNDEF_4] = BASE(0, 0),
+	[DA_GROUP_UNDEF_5] = BASE(0, 0)
+};
+
+
+/* Return the registers and flags of the operand bits in x. */
+static inline da_uint_t
+da_regs_expand(da_uint_t x, da_word_t data)
+{
+	da_uint_t m = x & (DA_REGS_MASK | DA_REGS_CPSR | DA_REGS_MEMORY);
+	m |= ((x >> 24) & 1) << (data & DA_REG_MASK);
+	m |= ((x >> 26) & 1) << ((data >> 8) & DA_REG_MASK);
+	m |= ((x >> 27) & 1) << ((data >> 12) & DA_REG_MASK);
+	m |= ((x >> 28) & 1) << ((data >> 16) & DA_REG_MASK);
+	m |= ((x >> 29) & 1) << (((data >> 12) + 1) & DA_REG_MASK);
+	m |= data & DA_REGS_MASK & -((x >> 30) & 1);
+	return m;
+}
+
+/* Apply the rules of the group of instr without branching on the
+   rules. Conditional instructions also read the condition flags. */
+static inline void
+da_instr_regs(const da_instr_t *instr, da_uint_t *read, da_uint_t *written)
+{
+	const da_regs_map_t *map = &da_regs_map[instr->group];
+	da_word_t data = instr->data;
+	da_uint_t r = map->read, w = map->written, k = 0;
+
+	size_t i;
+	for (i = 0; i < map->count; i++) {
+		const da_regs_rule_t *rule = &map->rules[i];
+		da_uint_t on = -(da_uint_t)((data & rule->mask) ==
+					    rule->value);
+		r |= rule->read & on;
+		w |= rule->written & on;
+		k |= rule->killed & on;
+	}
+
+	if ((data >> 28) < DA_COND_AL) r |= DA_REGS_CPSR;
+
+	*read = da_regs_expand(r, data);
+	*written = da_regs_expand(w, data) & ~k;
+}
+
+/* Return mask of the registers, status register and memory read by
+   instr. */
+DA_API da_uint_t
+da_instr_regs_read(const da_instr_t *instr)
+{
+	da_uint_t read, written;
+	da_instr_regs(instr, &read, &written);
+	return read;
+}
+
+/* Return mask of the registers, status register and memory written by
+   instr. Branches write r15. */
+DA_API da_uint_t
+da_instr_regs_written(const da_instr_t *instr)
+{
+	da_uint_t read, written;
+	da_instr_regs(instr, &read, &written);
+	return written;
+}
+
+/* Store the read and written masks of count instructions in read and
+   written. Either may be NULL. */
+DA_API void
+da_instr_regs_block(da_uint_t *read, da_uint_t *written,
+		    const da_instr_t *instrs, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_uint_t r, w;
+		da_instr_regs(&instrs[i], &r, &w);
+		if (read != NULL) read[i] = r;
+		if (written != NULL) written[i] = w;
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * regs.h - Register use header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_REGS_H
+#define _LIBDISARM_REGS_H
+
+#include <stddef.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Masks returned by the register use functions. Bit n of DA_REGS_MASK is
+   set for register rn; the flags above it are set for the status
+   register (condition flags, Q flag or mode) and for memory. */
+#define DA_REGS_MASK    0xffff
+#define DA_REGS_CPSR    (1 << 16)
+#define DA_REGS_MEMORY  (1 << 17)
+
+DA_BEGIN_DECLS
+
+da_uint_t da_instr_regs_read(const da_instr_t *instr);
+da_uint_t da_instr_regs_written(const da_instr_t *instr);
+void da_instr_regs_block(da_uint_t *read, da_uint_t *written,
+			 const da_instr_t *instrs, size_t count);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_REGS_H */
@@ -0,0 +1,335 @@
+/*
+ * symtab.c - Symbol table
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf.h"
+#include "macros.h"
+#include "symtab.h"
+#include "types.h"
+
+/* Keys in a cache line. The descendants four levels below key k are the
+   keys 16k to 16k+15, which are prefetched together. */
+#define DA_SYMTAB_LINE_KEYS  16
+
+
+DA_API void
+da_symtab_init(da_symtab_t *symtab)
+{
+	memset(symtab, 0, sizeof(da_symtab_t));
+}
+
+/* Add symbol name at address addr. The name is not copied. The table must
+   be built again before lookups. Return -1 if out of memory. */
+DA_API int
+da_symtab_add(da_symtab_t *symtab, da_addr_t addr, da_uint_t size,
+	      const char *name)
+{
+	if (symtab->count == symtab->alloc) {
+		size_t alloc = (symtab->alloc > 0 ? 2*symtab->alloc : 256);
+		da_sym_t *syms = realloc(symtab->syms,
+					 alloc*sizeof(da_sym_t));
+		if (syms == NULL) return -1;
+		symtab->syms = syms;
+		symtab->alloc = alloc;
+	}
+
+	da_sym_t *sym = &symtab->syms[symtab->count++];
+	sym->addr = addr;
+	sym->size = size;
+	sym->name = name;
+	return 0;
+}
+
+/* Add the symbols of elf, which must not be freed before symtab. */
+DA_API int
+da_symtab_add_elf(da_symtab_t *symtab, const da_elf_t *elf)
+{
+	size_t i;
+	for (i = 0; i < elf->nsyms; i++) {
+		const da_elf_sym_t *sym = &elf->syms[i];
+		if (da_symtab_add(symtab, sym->addr, sym->size,
+				  sym->name) < 0) return -1;
+	}
+	return 0;
+}
+
+/* Return the end of the token at p, which starts at the first non-space
+   character. */
+static char *
+da_symtab_token(char **p)
+{
+	while (**p == ' ' || **p == '\t' || **p == '\r') *p += 1;
+	char *end = *p;
+	while (*end != '\0' && *end != ' ' && *end != '\t' &&
+	       *end != '\r') end += 1;
+	return end;
+}
+
+/* Add the symbol of one line of a map file. Lines are ADDR NAME,
+   ADDR TYPE NAME or ADDR SIZE TYPE NAME as printed by nm (-S). Other
+   lines are ignored. */
+static int
+da_symtab_map_line(da_symtab_t *symtab, char *line)
+{
+	char *tokens[4];
+	char *ends[4];
+	int n = 0;
+
+	char *p = line;
+	while (n < 4) {
+		char *end = da_symtab_token(&p);
+		if (end == p) break;
+		tokens[n] = p;
+		ends[n] = end;
+		n += 1;
+		p = end;
+	}
+	if (n < 2 || tokens[0][0] == '#') return 0;
+
+	char *end;
+	da_addr_t addr = strtoul(tokens[0], &end, 16);
+	if (end != ends[0]) return 0;
+
+	da_uint_t size = 0;
+	int name = 1;
+	if (n >= 3 && ends[1] - tokens[1] == 1) {
+		name = 2;
+	} else if (n >= 4 && ends[2] - tokens[2] == 1) {
+		size = strtoul(tokens[1], &end, 16);
+		if (end != ends[1]) return 0;
+		name = 3;
+	}
+
+	/* Undefined symbols have no address */
+	if (name >= 2 && (*tokens[name-1] == 'U' || *tokens[name-1] == 'w' ||
+			  *tokens[name-1] == 'v')) return 0;
+
+	*ends[name] = '\0';
+	return da_symtab_add(symtab, addr, size, tokens[name]);
+}
+
+/* Add the symbols of the map file in path, in the format of nm, or of
+   lines of an address and a name. Return -1 on error. */
+DA_API int
+da_symtab_load_map(da_symtab_t *symtab, const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (f == NULL) return -1;
+
+	char **texts = realloc(symtab->texts,
+			       (symtab->ntexts + 1)*sizeof(char *));
+	if (texts == NULL) {
+		fclose(f);
+		return -1;
+	}
+	symtab->texts = texts;
+
+	size_t len = 0, alloc = 65536;
+	char *text = malloc(alloc);
+	while (text != NULL) {
+		if (alloc - len < 2) {
+			char *t = realloc(text, 2*alloc);
+			if (t == NULL) {
+				free(text);
+				text = NULL;
+				break;
+			}
+			text = t;
+			alloc *= 2;
+		}
+
+		size_t n = fread(text + len, 1, alloc - len - 1, f);
+		len += n;
+		if (n == 0) break;
+	}
+
+	int error = (text == NULL || ferror(f));
+	fclose(f);
+	if (error) {
+		free(text);
+		return -1;
+	}
+
+	text[len] = '\0';
+	symtab->texts[symtab->ntexts++] = text;
+
+	char *line = text;
+	while (*line != '\0') {
+		char *next = strchr(line, '\n');
+		if (next != NULL) *next++ = '\0';
+		else next = line + strlen(line);
+
+		if (da_symtab_map_line(symtab, line) < 0) return -1;
+		line = next;
+	}
+
+	return 0;
+}
+
+static int
+da_symtab_cmp(const void *a, const void *b)
+{
+	const da_sym_t *sa = a;
+	const da_sym_t *sb = b;
+	if (sa->addr != sb->addr) return sa->addr < sb->addr ? -1 : 1;
+	return strcmp(sa->name, sb->name);
+}
+
+/* Fill the subtree of key k with the distinct addresses from index i of
+   the sorted symbols. Return the index after the last one used. */
+static size_t
+da_symtab_fill(da_symtab_t *symtab, size_t i, size_t k)
+{
+	if (k > symtab->nkeys) return i;
+
+	i = da_symtab_fill(symtab, i, 2*k);
+
+	symtab->keys[k] = symtab->syms[i].addr;
+	symtab->first[k] = i;
+	do i += 1;
+	while (i < symtab->count && symtab->syms[i].addr ==
+	       symtab->syms[i-1].addr);
+
+	return da_symtab_fill(symtab, i, 2*k + 1);
+}
+
+/* Sort the symbols and build the search layout. Duplicate symbols are
+   removed. Return -1 if out of memory. */
+DA_API int
+da_symtab_build(da_symtab_t *symtab)
+{
+	qsort(symtab->syms, symtab->count, sizeof(da_sym_t), da_symtab_cmp);
+
+	size_t i, n = 0, nkeys = 0;
+	for (i = 0; i < symtab->count; i++) {
+		const da_sym_t *sym = &symtab->syms[i];
+		if (n > 0 && sym->addr == symtab->syms[n-1].addr) {
+			if (!strcmp(sym->name, symtab->syms[n-1].name)) {
+				continue;
+			}
+		} else {
+			nkeys += 1;
+		}
+		symtab->syms[n++] = *sym;
+	}
+	symtab->count = n;
+
+	/* Keys start on a cache line so that each group of descendants is
+	   in one line */
+	free(symtab->mem);
+	size_t line = DA_SYMTAB_LINE_KEYS*sizeof(da_addr_t);
+	size_t keys_size = (nkeys + 1)*sizeof(da_addr_t) + line;
+	symtab->mem = malloc(keys_size + (nkeys + 1)*sizeof(uint32_t));
+	if (symtab->mem == NULL) {
+		symtab->keys = NULL;
+		symtab->first = NULL;
+		symtab->nkeys = 0;
+		return -1;
+	}
+
+	uintptr_t base = (uintptr_t)symtab->mem;
+	symtab->keys = (da_addr_t *)((base + line - 1) & ~(uintptr_t)(line - 1));
+	symtab->first = (uint32_t *)((char *)symtab->mem + keys_size);
+	symtab->nkeys = nkeys;
+
+	da_symtab_fill(symtab, 0, 1);
+	return 0;
+}
+
+DA_API void
+da_symtab_free(da_symtab_t *symtab)
+{
+	size_t i;
+	for (i = 0; i < symtab->ntexts; i++) free(symtab->texts[i]);
+	free(symtab->texts);
+	free(symtab->syms);
+	free(symtab->mem);
+	memset(symtab, 0, sizeof(da_symtab_t));
+}
+
+/* Return the symbol that covers address addr and set offset to the offset
+   of addr from it, or return NULL if there is none. The search descends
+   the Eytzinger layout without branches on the keys. */
+DA_API const da_sym_t *
+da_symtab_lookup(const da_symtab_t *symtab, da_addr_t addr,
+		 da_uint_t *offset)
+{
+	const da_addr_t *keys = symtab->keys;
+	size_t n = symtab->nkeys;
+	size_t k = 1;
+
+	while (k <= n) {
+#ifdef __GNUC__
+		__builtin_prefetch(keys + DA_SYMTAB_LINE_KEYS*k);
+#endif
+		k = 2*k + (keys[k] <= addr);
+	}
+
+	/* The last right turn was at the greatest key not above addr */
+#ifdef __GNUC__
+	k >>= __builtin_ctzl(k) + 1;
+#else
+	while (!(k & 1)) k >>= 1;
+	k >>= 1;
+#endif
+	if (k == 0) return NULL;
+
+	const da_sym_t *sym = &symtab->syms[symtab->first[k]];
+	da_uint_t off = addr - sym->addr;
+	if (sym->size != 0 && off >= sym->size) return NULL;
+
+	if (offset != NULL) *offset = off;
+	return sym;
+}
+
+/* Return the index of the first symbol at or after address addr, or
+   count if there is none. */
+DA_API size_t
+da_symtab_find(const da_symtab_t *symtab, da_addr_t addr)
+{
+	size_t lo = 0, hi = symtab->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo)/2;
+		if (symtab->syms[mid].addr < addr) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+/* Print address addr as symbol+0xoffset, or as 0xaddr if no symbol
+   covers it. Return the length as snprintf does. */
+DA_API size_t
+da_symtab_snprint_addr(char *buf, size_t len, const da_symtab_t *symtab,
+		       da_addr_t addr)
+{
+	da_uint_t offset;
+	const da_sym_t *sym = da_symtab_lookup(symtab, addr, &offset);
+	if (sym == NULL) return snprintf(buf, len, "0x%x", addr);
+	if (offset == 0) return snprintf(buf, len, "%s", sym->name);
+	return snprintf(buf, len, "%s+0x%x", sym->name, offset);
+}
@@ -0,0 +1,74 @@
+/*
+ * symtab.h - Symbol table header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_SYMTAB_H
+#define _LIBDISARM_SYMTAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/elf.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+DA_BEGIN_DECLS
+
+/* Symbol covering size bytes from addr, or up to the next symbol if size
+   is zero. */
+typedef struct {
+	da_addr_t addr;
+	da_uint_t size;
+	const char *name;
+} da_sym_t;
+
+/* Symbols sorted by address. The distinct addresses are kept in
+   Eytzinger (breadth first) order in keys[1..nkeys], and first[k] is the
+   index of the first symbol at keys[k]; both are allocated in mem. Names
+   are not copied, except those of map files which are kept in texts. */
+typedef struct {
+	da_sym_t *syms;
+	size_t count;
+	size_t alloc;
+	da_addr_t *keys;
+	uint32_t *first;
+	size_t nkeys;
+	void *mem;
+	char **texts;
+	size_t ntexts;
+} da_symtab_t;
+
+
+void da_symtab_init(da_symtab_t *symtab);
+int da_symtab_add(da_symtab_t *symtab, da_addr_t addr, da_uint_t size,
+		  const char *name);
+int da_symtab_add_elf(da_symtab_t *symtab, const da_elf_t *elf);
+int da_symtab_load_map(da_symtab_t *symtab, const char *path);
+int da_symtab_build(da_symtab_t *symtab);
+void da_symtab_free(da_symtab_t *symtab);
+
+const da_sym_t *da_symtab_lookup(const da_symtab_t *symtab, da_addr_t addr,
+				 da_uint_t *offset);
+size_t da_symtab_find(const da_symtab_t *symtab, da_addr_t addr);
+size_t da_symtab_snprint_addr(char *buf, size_t len,
+			      const da_symtab_t *symtab, da_addr_t addr);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_SYMTAB_H */
@@ -0,0 +1,156 @@
+/*
+ * textcache.c - Rendered instruction text cache
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "emit.h"
+#include "macros.h"
+#include "print.h"
+#include "textcache.h"
+#include "types.h"
+
+
+/* Return the index of the entry of instruction word data. */
+static inline size_t
+da_text_cache_index(const da_text_cache_t *cache, da_word_t data)
+{
+	uint32_t h = data * 0x9e3779b1;
+	return (h ^ (h >> 15)) & cache->mask;
+}
+
+/* Initialize empty cache of at least size entries (rounded up to a power
+   of two). Return -1 on error. */
+DA_API int
+da_text_cache_init(da_text_cache_t *cache, size_t size)
+{
+	size_t n = 1;
+	while (n < size) n *= 2;
+
+	memset(cache, 0, sizeof(da_text_cache_t));
+	cache->entries = calloc(n, sizeof(da_text_cache_entry_t));
+	if (cache->entries == NULL) return -1;
+	cache->mask = n - 1;
+
+	return 0;
+}
+
+DA_API void
+da_text_cache_free(da_text_cache_t *cache)
+{
+	free(cache->entries);
+	memset(cache, 0, sizeof(da_text_cache_t));
+}
+
+/* Remove all entries and reset the counters. */
+DA_API void
+da_text_cache_clear(da_text_cache_t *cache)
+{
+	memset(cache->entries, 0,
+	       (cache->mask + 1)*sizeof(da_text_cache_entry_t));
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+/* Print instruction to text of size DA_EMIT_SIZE, using and updating the
+   cache, and return the end of the text. args may be NULL, in which case
+   the arguments are parsed if the text is not cached. */
+static char *
+da_text_cache_print(da_text_cache_t *cache, char *text,
+		    const da_instr_t *instr, const da_instr_args_t *args,
+		    da_addr_t addr)
+{
+	da_text_cache_entry_t *e =
+		&cache->entries[da_text_cache_index(cache, instr->data)];
+	char *p;
+
+	if (e->len > 0 && e->data == instr->data) {
+		cache->hits += 1;
+
+		/* Copying the whole entry text is cheaper than its length */
+		memcpy(text, e->text, DA_TEXT_CACHE_TEXT_SIZE);
+		p = text + e->len;
+		if (e->rel) p = da_emit_hex(p, addr + e->delta - e->bits);
+		return p;
+	}
+
+	da_instr_args_t parsed;
+	da_instr_rel_t rel;
+
+	cache->misses += 1;
+	if (args == NULL) {
+		da_instr_parse_args(&parsed, instr);
+		args = &parsed;
+	}
+
+	size_t n = da_instr_snprint_rel(text, DA_EMIT_SIZE, instr, args, &rel);
+	if (n <= DA_TEXT_CACHE_TEXT_SIZE) {
+		e->data = instr->data;
+		e->delta = rel.delta;
+		e->len = n;
+		e->rel = rel.present;
+		e->bits = rel.bits;
+		memcpy(e->text, text, n);
+	}
+
+	p = text + n;
+	if (rel.present) p = da_emit_hex(p, addr + rel.delta - rel.bits);
+	return p;
+}
+
+/* Print instruction as da_instr_snprint does, using the cache. */
+DA_API size_t
+da_text_cache_snprint(da_text_cache_t *cache, char *buf, size_t len,
+		      const da_instr_t *instr, const da_instr_args_t *args,
+		      da_addr_t addr)
+{
+	if (len >= DA_EMIT_SIZE) {
+		char *end = da_text_cache_print(cache, buf, instr, args, addr);
+		*end = '\0';
+		return end - buf;
+	} else {
+		char text[DA_EMIT_SIZE];
+		size_t n = da_text_cache_print(cache, text, instr, args,
+					       addr) - text;
+		if (len > 0) {
+			size_t copy = ((n < len) ? n : len - 1);
+			memcpy(buf, text, copy);
+			buf[copy] = '\0';
+		}
+		return n;
+	}
+}
+
+/* Print instruction as da_instr_fprint does, using the cache. */
+DA_API void
+da_text_cache_fprint(da_text_cache_t *cache, FILE *f,
+		     const da_instr_t *instr, const da_instr_args_t *args,
+		     da_addr_t addr)
+{
+	char text[DA_EMIT_SIZE];
+	size_t n = da_text_cache_print(cache, text, instr, args, addr) - text;
+	fwrite(text, 1, n, f);
+}
@@ -0,0 +1,76 @@
+/*
+ * textcache.h - Rendered instruction text cache header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_TEXTCACHE_H
+#define _LIBDISARM_TEXTCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libdisarm/args.h>
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Longest address independent text kept in the cache */
+#define DA_TEXT_CACHE_TEXT_SIZE  52
+
+DA_BEGIN_DECLS
+
+/* Cached text of one instruction word, 64 bytes. The text is stored
+   without the address dependent end, which is described as in
+   da_instr_rel_t. An entry of length 0 is empty. */
+typedef struct {
+	da_word_t data;
+	da_word_t delta;
+	uint8_t len;
+	uint8_t rel;
+	uint8_t bits;
+	uint8_t reserved;
+	char text[DA_TEXT_CACHE_TEXT_SIZE];
+} da_text_cache_entry_t;
+
+/* Direct mapped cache of instruction text, indexed by a hash of the
+   instruction word. hits and misses count the lookups; texts too long
+   for an entry are never cached and count as misses. */
+typedef struct {
+	da_text_cache_entry_t *entries;
+	size_t mask;
+
+	unsigned long hits;
+	unsigned long misses;
+} da_text_cache_t;
+
+
+int da_text_cache_init(da_text_cache_t *cache, size_t size);
+void da_text_cache_free(da_text_cache_t *cache);
+void da_text_cache_clear(da_text_cache_t *cache);
+
+size_t da_text_cache_snprint(da_text_cache_t *cache, char *buf, size_t len,
+			     const da_instr_t *instr,
+			     const da_instr_args_t *args, da_addr_t addr);
+void da_text_cache_fprint(da_text_cache_t *cache, FILE *f,
+			  const da_instr_t *instr,
+			  const da_instr_args_t *args, da_addr_t addr);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_TEXTCACHE_H */
@@ -0,0 +1,123 @@
+/*
+ * thumb.c - Thumb instruction parser and argument functions
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "endian.h"
+#include "macros.h"
+#include "thumb.h"
+#include "types.h"
+
+
+#ifdef DA_GROUP_TABLE
+
+/* Generated by mktables from the decode tree in thumbtree.h. Every
+   encoding has an entry with its group and arguments. */
+# include "thumb_table.h"
+
+static inline void
+da_thumb_decode_args(da_thumb_args_t *args, da_hword_t data)
+{
+	*args = da_thumb_table[data];
+}
+
+static inline da_thumb_group_t
+da_thumb_decode_group(da_hword_t data)
+{
+	return da_thumb_table[data].group;
+}
+
+#else /* ! DA_GROUP_TABLE */
+
+# include "thumbtree.h"
+
+static inline void
+da_thumb_decode_args(da_thumb_args_t *args, da_hword_t data)
+{
+	da_thumb_decode(args, data);
+}
+
+static inline da_thumb_group_t
+da_thumb_decode_group(da_hword_t data)
+{
+	da_thumb_args_t args;
+	da_thumb_decode(&args, data);
+	return args.group;
+}
+
+#endif /* DA_GROUP_TABLE */
+
+
+DA_API void
+da_thumb_parse(da_thumb_instr_t *instr, da_hword_t data, int big_endian)
+{
+	instr->data = (big_endian ? be16toh(data) : le16toh(data));
+	instr->group = da_thumb_decode_group(instr->data);
+}
+
+/* Parse count halfwords from data into the instrs array. */
+DA_API void
+da_thumb_parse_block(da_thumb_instr_t *instrs, const da_hword_t *data,
+		     size_t count, int big_endian)
+{
+	size_t i;
+	if (big_endian) {
+		for (i = 0; i < count; i++) {
+			instrs[i].data = be16toh(data[i]);
+			instrs[i].group = da_thumb_decode_group(instrs[i].data);
+		}
+	} else {
+		for (i = 0; i < count; i++) {
+			instrs[i].data = le16toh(data[i]);
+			instrs[i].group = da_thumb_decode_group(instrs[i].data);
+		}
+	}
+}
+
+DA_API void
+da_thumb_parse_args(da_thumb_args_t *args, const da_thumb_instr_t *instr)
+{
+	da_thumb_decode_args(args, instr->data);
+}
+
+/* Parse arguments of count instructions into the args array. */
+DA_API void
+da_thumb_parse_args_block(da_thumb_args_t *args,
+			  const da_thumb_instr_t *instrs, size_t count)
+{
+	size_t i;
+	for (i = 0; i < count; i++) {
+		da_thumb_decode_args(&args[i], instrs[i].data);
+	}
+}
+
+/* Return target address of the BL or BLX pair whose prefix is at addr.
+   BLX changes to ARM state, so its target is word aligned. */
+DA_API da_addr_t
+da_thumb_bl_target(const da_thumb_args_t *prefix,
+		   const da_thumb_args_t *suffix, da_addr_t addr)
+{
+	da_addr_t target = addr + 4 + ((da_addr_t)prefix->imm << 12) +
+		((da_addr_t)suffix->imm << 1);
+	if (suffix->group == DA_THUMB_GROUP_BLX_SUFFIX) target &= ~3;
+	return target;
+}
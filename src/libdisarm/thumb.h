@@ -0,0 +1,161 @@
+/*
+ * thumb.h - Thumb instruction header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_THUMB_H
+#define _LIBDISARM_THUMB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+DA_BEGIN_DECLS
+
+typedef uint16_t da_hword_t;
+
+
+typedef enum {
+	/* Add to pc or sp: add Rd, pc/sp, #imm */
+	DA_THUMB_GROUP_ADD_PC_SP = 0,
+	/* Add/subtract immediate: add/sub Rd, Rn, #imm */
+	DA_THUMB_GROUP_ADD_SUB_IMM,
+	/* Add/subtract register: add/sub Rd, Rn, Rm */
+	DA_THUMB_GROUP_ADD_SUB_REG,
+	/* Adjust stack pointer: add/sub sp, #imm */
+	DA_THUMB_GROUP_ADJUST_SP,
+
+	/* Unconditional branch */
+	DA_THUMB_GROUP_B,
+	/* Conditional branch */
+	DA_THUMB_GROUP_B_COND,
+	/* Software breakpoint */
+	DA_THUMB_GROUP_BKPT,
+	/* First half of branch with link: high part of offset */
+	DA_THUMB_GROUP_BL_PREFIX,
+	/* Second half of branch with link: low part of offset */
+	DA_THUMB_GROUP_BL_SUFFIX,
+	/* Second half of branch with link and change to ARM */
+	DA_THUMB_GROUP_BLX_SUFFIX,
+	/* Branch (with link) and exchange instruction set */
+	DA_THUMB_GROUP_BX,
+
+	/* Data processing immediate: mov/cmp/add/sub Rd, #imm */
+	DA_THUMB_GROUP_DATA_IMM,
+	/* Data processing register */
+	DA_THUMB_GROUP_DATA_REG,
+	/* Data processing with high registers: add/cmp/mov */
+	DA_THUMB_GROUP_HI_REG,
+
+	/* Load pc relative */
+	DA_THUMB_GROUP_LDR_PC,
+	/* Load/store halfword immediate offset */
+	DA_THUMB_GROUP_LS_HW_IMM,
+	/* Load/store word/byte immediate offset */
+	DA_THUMB_GROUP_LS_IMM,
+	/* Load/store multiple */
+	DA_THUMB_GROUP_LS_MULTI,
+	/* Load/store register offset */
+	DA_THUMB_GROUP_LS_REG,
+	/* Load/store sp relative */
+	DA_THUMB_GROUP_LS_SP,
+
+	/* Push/pop registers */
+	DA_THUMB_GROUP_PUSH_POP,
+
+	/* Shift by immediate: lsl/lsr/asr Rd, Rm, #imm */
+	DA_THUMB_GROUP_SHIFT_IMM,
+
+	/* Software interrupt */
+	DA_THUMB_GROUP_SWI,
+
+	/* Undefined instruction */
+	DA_THUMB_GROUP_UNDEF,
+
+	DA_THUMB_GROUP_MAX
+} da_thumb_group_t;
+
+
+/* Operations of the load/store groups, numbered as bits 9-11 of the
+   register offset form */
+typedef enum {
+	DA_THUMB_LS_STR = 0, DA_THUMB_LS_STRH,
+	DA_THUMB_LS_STRB,    DA_THUMB_LS_LDRSB,
+	DA_THUMB_LS_LDR,     DA_THUMB_LS_LDRH,
+	DA_THUMB_LS_LDRB,    DA_THUMB_LS_LDRSH,
+	DA_THUMB_LS_MAX
+} da_thumb_ls_op_t;
+
+
+typedef struct {
+	da_hword_t data;
+	da_thumb_group_t group;
+} da_thumb_instr_t;
+
+/* Decoded arguments of a Thumb instruction. The meaning of op depends on
+   the group:
+     SHIFT_IMM                      da_shift_t
+     ADD_SUB_*, DATA_IMM, HI_REG,
+     ADD_PC_SP, ADJUST_SP           da_data_op_t
+     DATA_REG                       bits 6-9 (and, eor, lsl, ..., mvn)
+     LDR_PC, LS_*                   da_thumb_ls_op_t
+     LS_MULTI, PUSH_POP             1 for load
+     BX                             1 for link
+   imm holds the immediate, the offset in bytes, the register list (pc
+   and lr at bits 15 and 14 for push/pop) or the branch offset in bytes
+   from the instruction address plus 4. For BL_PREFIX it is the signed
+   high part of the offset in units of 4096 bytes, and for the suffixes
+   the low part in units of 2 bytes. Unused registers are 0. */
+typedef struct {
+	uint8_t group;
+	uint8_t op;
+	uint8_t cond;
+	uint8_t rd;
+	uint8_t rn;
+	uint8_t rm;
+	int16_t imm;
+} da_thumb_args_t;
+
+
+void da_thumb_parse(da_thumb_instr_t *instr, da_hword_t data,
+		    int big_endian);
+void da_thumb_parse_block(da_thumb_instr_t *instrs, const da_hword_t *data,
+			  size_t count, int big_endian);
+
+void da_thumb_parse_args(da_thumb_args_t *args,
+			 const da_thumb_instr_t *instr);
+void da_thumb_parse_args_block(da_thumb_args_t *args,
+			       const da_thumb_instr_t *instrs, size_t count);
+
+da_addr_t da_thumb_bl_target(const da_thumb_args_t *prefix,
+			     const da_thumb_args_t *suffix, da_addr_t addr);
+
+size_t da_thumb_snprint(char *buf, size_t len, const da_thumb_instr_t *instr,
+			const da_thumb_args_t *args, da_addr_t addr);
+size_t da_thumb_snprint_bl(char *buf, size_t len,
+			   const da_thumb_args_t *prefix,
+			   const da_thumb_args_t *suffix, da_addr_t addr);
+void da_thumb_fprint(FILE *f, const da_thumb_instr_t *instr,
+		     const da_thumb_args_t *args, da_addr_t addr);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_THUMB_H */
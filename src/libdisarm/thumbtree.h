@@ -0,0 +1,214 @@
+/*
+ * thumbtree.h - Thumb instruction decode tree
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_THUMBTREE_H
+#define _LIBDISARM_THUMBTREE_H
+
+#include <string.h>
+
+#include "thumb.h"
+#include "types.h"
+
+
+#define DA_THUMB_ARG(data,shift,mask)  (((data) >> (shift)) & (mask))
+#define DA_THUMB_ARG_REG(data,shift)  DA_THUMB_ARG(data,shift,0x7)
+
+/* Sign-extend the low bits of value. */
+#define DA_THUMB_SEXT(value,bits)  \
+	((int)((unsigned int)(value) << (32 - (bits))) >> (32 - (bits)))
+
+
+/* Figure 6-1 in ARM Architecture Reference. mktables runs this for every
+   encoding to generate the Thumb table. */
+static inline void
+da_thumb_decode(da_thumb_args_t *args, da_hword_t data)
+{
+	static const da_data_op_t data_imm_ops[] = {
+		DA_DATA_OP_MOV, DA_DATA_OP_CMP, DA_DATA_OP_ADD, DA_DATA_OP_SUB
+	};
+	static const da_data_op_t hi_reg_ops[] = {
+		DA_DATA_OP_ADD, DA_DATA_OP_CMP, DA_DATA_OP_MOV
+	};
+	unsigned int load = DA_THUMB_ARG(data, 11, 1);
+
+	memset(args, 0, sizeof(*args));
+	args->cond = DA_COND_AL;
+	args->group = DA_THUMB_GROUP_UNDEF;
+
+	switch (DA_THUMB_ARG(data, 13, 0x7)) {
+	case 0:
+		args->rd = DA_THUMB_ARG_REG(data, 0);
+		if (DA_THUMB_ARG(data, 11, 0x3) == 0x3) {
+			args->rn = DA_THUMB_ARG_REG(data, 3);
+			args->op = (DA_THUMB_ARG(data, 9, 1) ?
+				    DA_DATA_OP_SUB : DA_DATA_OP_ADD);
+			if (DA_THUMB_ARG(data, 10, 1)) {
+				args->group = DA_THUMB_GROUP_ADD_SUB_IMM;
+				args->imm = DA_THUMB_ARG(data, 6, 0x7);
+			} else {
+				args->group = DA_THUMB_GROUP_ADD_SUB_REG;
+				args->rm = DA_THUMB_ARG_REG(data, 6);
+			}
+		} else {
+			args->group = DA_THUMB_GROUP_SHIFT_IMM;
+			args->op = DA_THUMB_ARG(data, 11, 0x3);
+			args->rm = DA_THUMB_ARG_REG(data, 3);
+			args->imm = DA_THUMB_ARG(data, 6, 0x1f);
+			/* lsr #32 and asr #32 are encoded as #0 */
+			if (args->op != DA_SHIFT_LSL && args->imm == 0) {
+				args->imm = 32;
+			}
+		}
+		break;
+	case 1:
+		args->group = DA_THUMB_GROUP_DATA_IMM;
+		args->op = data_imm_ops[DA_THUMB_ARG(data, 11, 0x3)];
+		args->rd = DA_THUMB_ARG_REG(data, 8);
+		args->imm = DA_THUMB_ARG(data, 0, 0xff);
+		break;
+	case 2:
+		if (DA_THUMB_ARG(data, 12, 1)) {
+			args->group = DA_THUMB_GROUP_LS_REG;
+			args->op = DA_THUMB_ARG(data, 9, 0x7);
+			args->rm = DA_THUMB_ARG_REG(data, 6);
+			args->rn = DA_THUMB_ARG_REG(data, 3);
+			args->rd = DA_THUMB_ARG_REG(data, 0);
+		} else if (DA_THUMB_ARG(data, 11, 1)) {
+			args->group = DA_THUMB_GROUP_LDR_PC;
+			args->op = DA_THUMB_LS_LDR;
+			args->rd = DA_THUMB_ARG_REG(data, 8);
+			args->rn = DA_REG_R15;
+			args->imm = DA_THUMB_ARG(data, 0, 0xff) << 2;
+		} else if (DA_THUMB_ARG(data, 10, 1) == 0) {
+			args->group = DA_THUMB_GROUP_DATA_REG;
+			args->op = DA_THUMB_ARG(data, 6, 0xf);
+			args->rm = DA_THUMB_ARG_REG(data, 3);
+			args->rd = DA_THUMB_ARG_REG(data, 0);
+		} else if (DA_THUMB_ARG(data, 8, 0x3) == 0x3) {
+			args->group = DA_THUMB_GROUP_BX;
+			args->op = DA_THUMB_ARG(data, 7, 1);
+			args->rm = DA_THUMB_ARG(data, 3, 0xf);
+		} else {
+			args->group = DA_THUMB_GROUP_HI_REG;
+			args->op = hi_reg_ops[DA_THUMB_ARG(data, 8, 0x3)];
+			args->rd = (DA_THUMB_ARG(data, 7, 1) << 3) |
+				DA_THUMB_ARG_REG(data, 0);
+			args->rm = DA_THUMB_ARG(data, 3, 0xf);
+		}
+		break;
+	case 3:
+		args->group = DA_THUMB_GROUP_LS_IMM;
+		args->rn = DA_THUMB_ARG_REG(data, 3);
+		args->rd = DA_THUMB_ARG_REG(data, 0);
+		if (DA_THUMB_ARG(data, 12, 1)) {
+			args->op = load ? DA_THUMB_LS_LDRB : DA_THUMB_LS_STRB;
+			args->imm = DA_THUMB_ARG(data, 6, 0x1f);
+		} else {
+			args->op = load ? DA_THUMB_LS_LDR : DA_THUMB_LS_STR;
+			args->imm = DA_THUMB_ARG(data, 6, 0x1f) << 2;
+		}
+		break;
+	case 4:
+		if (DA_THUMB_ARG(data, 12, 1)) {
+			args->group = DA_THUMB_GROUP_LS_SP;
+			args->op = load ? DA_THUMB_LS_LDR : DA_THUMB_LS_STR;
+			args->rd = DA_THUMB_ARG_REG(data, 8);
+			args->rn = DA_REG_R13;
+			args->imm = DA_THUMB_ARG(data, 0, 0xff) << 2;
+		} else {
+			args->group = DA_THUMB_GROUP_LS_HW_IMM;
+			args->op = load ? DA_THUMB_LS_LDRH : DA_THUMB_LS_STRH;
+			args->rn = DA_THUMB_ARG_REG(data, 3);
+			args->rd = DA_THUMB_ARG_REG(data, 0);
+			args->imm = DA_THUMB_ARG(data, 6, 0x1f) << 1;
+		}
+		break;
+	case 5:
+		if (DA_THUMB_ARG(data, 12, 1) == 0) {
+			args->group = DA_THUMB_GROUP_ADD_PC_SP;
+			args->op = DA_DATA_OP_ADD;
+			args->rd = DA_THUMB_ARG_REG(data, 8);
+			args->rn = (DA_THUMB_ARG(data, 11, 1) ?
+				    DA_REG_R13 : DA_REG_R15);
+			args->imm = DA_THUMB_ARG(data, 0, 0xff) << 2;
+		} else if (DA_THUMB_ARG(data, 8, 0xf) == 0x0) {
+			args->group = DA_THUMB_GROUP_ADJUST_SP;
+			args->op = (DA_THUMB_ARG(data, 7, 1) ?
+				    DA_DATA_OP_SUB : DA_DATA_OP_ADD);
+			args->rd = DA_REG_R13;
+			args->rn = DA_REG_R13;
+			args->imm = DA_THUMB_ARG(data, 0, 0x7f) << 2;
+		} else if (DA_THUMB_ARG(data, 9, 0x3) == 0x2) {
+			args->group = DA_THUMB_GROUP_PUSH_POP;
+			args->op = load;
+			args->imm = DA_THUMB_ARG(data, 0, 0xff) |
+				(DA_THUMB_ARG(data, 8, 1) <<
+				 (load ? DA_REG_R15 : DA_REG_R14));
+		} else if (DA_THUMB_ARG(data, 8, 0xf) == 0xe) {
+			args->group = DA_THUMB_GROUP_BKPT;
+			args->imm = DA_THUMB_ARG(data, 0, 0xff);
+		}
+		break;
+	case 6:
+		if (DA_THUMB_ARG(data, 12, 1) == 0) {
+			args->group = DA_THUMB_GROUP_LS_MULTI;
+			args->op = load;
+			args->rn = DA_THUMB_ARG_REG(data, 8);
+			args->imm = DA_THUMB_ARG(data, 0, 0xff);
+		} else if (DA_THUMB_ARG(data, 8, 0xf) == 0xf) {
+			args->group = DA_THUMB_GROUP_SWI;
+			args->imm = DA_THUMB_ARG(data, 0, 0xff);
+		} else if (DA_THUMB_ARG(data, 8, 0xf) != 0xe) {
+			args->group = DA_THUMB_GROUP_B_COND;
+			args->cond = DA_THUMB_ARG(data, 8, 0xf);
+			args->imm = DA_THUMB_SEXT(DA_THUMB_ARG(data, 0, 0xff),
+						  8) << 1;
+		}
+		break;
+	case 7:
+		switch (DA_THUMB_ARG(data, 11, 0x3)) {
+		case 0:
+			args->group = DA_THUMB_GROUP_B;
+			args->imm = DA_THUMB_SEXT(DA_THUMB_ARG(data, 0, 0x7ff),
+						  11) << 1;
+			break;
+		case 1:
+			/* Odd offsets are undefined for blx */
+			if (DA_THUMB_ARG(data, 0, 1) == 0) {
+				args->group = DA_THUMB_GROUP_BLX_SUFFIX;
+				args->imm = DA_THUMB_ARG(data, 0, 0x7ff);
+			}
+			break;
+		case 2:
+			args->group = DA_THUMB_GROUP_BL_PREFIX;
+			args->imm = DA_THUMB_SEXT(DA_THUMB_ARG(data, 0, 0x7ff),
+						  11);
+			break;
+		case 3:
+			args->group = DA_THUMB_GROUP_BL_SUFFIX;
+			args->imm = DA_THUMB_ARG(data, 0, 0x7ff);
+			break;
+		}
+		break;
+	}
+}
+
+
+#endif /* ! _LIBDISARM_THUMBTREE_H */
@@ -0,0 +1,454 @@
+/*
+ * trace.c - Recursive traversal
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+#include "access.h"
+#include "args.h"
+#include "macros.h"
+#include "parser.h"
+#include "trace.h"
+#include "types.h"
+
+/* Worker threads need the GCC atomic builtins */
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+# define DA_TRACE_THREADS  1
+# define DA_LOAD(p, order)  __atomic_load_n(p, __ATOMIC_ ## order)
+# define DA_STORE(p, v, order)  __atomic_store_n(p, v, __ATOMIC_ ## order)
+# define DA_FETCH_ADD(p, v)  __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+# define DA_FETCH_OR(p, v)  __atomic_fetch_or(p, v, __ATOMIC_RELAXED)
+# define DA_CAS(p, e, v) \
+	__atomic_compare_exchange_n(p, e, v, 0, __ATOMIC_SEQ_CST, \
+				    __ATOMIC_RELAXED)
+# define DA_FENCE(order)  __atomic_thread_fence(__ATOMIC_ ## order)
+#else
+# define DA_LOAD(p, order)  (*(p))
+# define DA_STORE(p, v, order)  (*(p) = (v))
+# define DA_FETCH_ADD(p, v)  ((*(p) += (v)) - (v))
+# define DA_FETCH_OR(p, v)  da_trace_fetch_or(p, v)
+# define DA_CAS(p, e, v)  (*(p) == *(e) ? (*(p) = (v), 1) : 0)
+# define DA_FENCE(order)
+
+static inline uint64_t
+da_trace_fetch_or(uint64_t *p, uint64_t v)
+{
+	uint64_t old = *p;
+	*p |= v;
+	return old;
+}
+#endif
+
+
+/* Initial size of the deques */
+#define DA_TRACE_DEQUE_SIZE  1024
+
+/* Size of a cache line, to keep deques apart */
+#define DA_TRACE_LINE_SIZE  64
+
+/* Value returned by empty deques */
+#define DA_TRACE_EMPTY  (-1)
+
+
+/* Array of a deque. Arrays replaced by a larger one are kept until the
+   end of the traversal since thieves may still read them. */
+typedef struct da_trace_array {
+	struct da_trace_array *prev;
+	int64_t size;
+	uint32_t items[1];
+} da_trace_array_t;
+
+/* Work-stealing deque of word indices (Chase and Lev). The owner pushes
+   and takes at the bottom, other workers steal from the top. */
+typedef struct {
+	int64_t top;
+	int64_t bottom;
+	da_trace_array_t *array;
+	char pad[DA_TRACE_LINE_SIZE - 2*sizeof(int64_t) - sizeof(void *)];
+} da_trace_deque_t;
+
+/* Traversal state shared by the workers */
+typedef struct {
+	const da_word_t *data;
+	size_t count;
+	da_addr_t addr;
+	int big_endian;
+
+	uint64_t *code;
+	int64_t pending;
+	int error;
+
+	da_trace_deque_t *deques;
+	int nworkers;
+} da_trace_ctx_t;
+
+/* Argument of a worker thread */
+typedef struct {
+	da_trace_ctx_t *ctx;
+	int id;
+	size_t reached;
+} da_trace_worker_t;
+
+
+static da_trace_array_t *
+da_trace_array_new(int64_t size, da_trace_array_t *prev)
+{
+	da_trace_array_t *a = malloc(sizeof(da_trace_array_t) +
+				     (size - 1)*sizeof(uint32_t));
+	if (a == NULL) return NULL;
+	a->prev = prev;
+	a->size = size;
+	return a;
+}
+
+/* Push word index i to the bottom of deque. Return -1 on error. */
+static int
+da_trace_push(da_trace_deque_t *d, uint32_t i)
+{
+	int64_t b = DA_LOAD(&d->bottom, RELAXED);
+	int64_t t = DA_LOAD(&d->top, ACQUIRE);
+	da_trace_array_t *a = DA_LOAD(&d->array, RELAXED);
+
+	if (b - t > a->size - 1) {
+		da_trace_array_t *n = da_trace_array_new(2*a->size, a);
+		if (n == NULL) return -1;
+
+		int64_t k;
+		for (k = t; k < b; k++) {
+			n->items[k & (n->size - 1)] = a->items[k & (a->size - 1)];
+		}
+		DA_STORE(&d->array, n, RELEASE);
+		a = n;
+	}
+
+	DA_STORE(&a->items[b & (a->size - 1)], i, RELAXED);
+	DA_FENCE(RELEASE);
+	DA_STORE(&d->bottom, b + 1, RELAXED);
+	return 0;
+}
+
+/* Take word index from the bottom of deque, or DA_TRACE_EMPTY. */
+static int64_t
+da_trace_take(da_trace_deque_t *d)
+{
+	int64_t b = DA_LOAD(&d->bottom, RELAXED) - 1;
+	da_trace_array_t *a = DA_LOAD(&d->array, RELAXED);
+	DA_STORE(&d->bottom, b, RELAXED);
+	DA_FENCE(SEQ_CST);
+	int64_t t = DA_LOAD(&d->top, RELAXED);
+
+	if (t > b) {
+		DA_STORE(&d->bottom, b + 1, RELAXED);
+		return DA_TRACE_EMPTY;
+	}
+
+	int64_t x = DA_LOAD(&a->items[b & (a->size - 1)], RELAXED);
+	if (t == b) {
+		/* Last item; race against thieves */
+		if (!DA_CAS(&d->top, &t, t + 1)) x = DA_TRACE_EMPTY;
+		DA_STORE(&d->bottom, b + 1, RELAXED);
+	}
+
+	return x;
+}
+
+/* Steal word index from the top of deque, or DA_TRACE_EMPTY if it is
+   empty or the steal lost a race. */
+static int64_t
+da_trace_steal(da_trace_deque_t *d)
+{
+	int64_t t = DA_LOAD(&d->top, ACQUIRE);
+	DA_FENCE(SEQ_CST);
+	int64_t b = DA_LOAD(&d->bottom, ACQUIRE);
+	if (t >= b) return DA_TRACE_EMPTY;
+
+	da_trace_array_t *a = DA_LOAD(&d->array, ACQUIRE);
+	int64_t x = DA_LOAD(&a->items[t & (a->size - 1)], RELAXED);
+	if (!DA_CAS(&d->top, &t, t + 1)) return DA_TRACE_EMPTY;
+
+	return x;
+}
+
+/* Queue word at address target for traversal if it is in the image and
+   was not reached yet. */
+static void
+da_trace_queue(da_trace_ctx_t *ctx, da_trace_deque_t *d, da_addr_t target)
+{
+	da_addr_t off = target - ctx->addr;
+	if (target < ctx->addr || (off & 3)) return;
+
+	size_t i = off / sizeof(da_word_t);
+	if (i >= ctx->count) return;
+	if ((DA_LOAD(&ctx->code[i >> 6], RELAXED) >> (i & 63)) & 1) return;
+
+	/* Count the item before thieves can see it */
+	DA_FETCH_ADD(&ctx->pending, 1);
+	if (da_trace_push(d, i) < 0) {
+		DA_FETCH_ADD(&ctx->pending, -1);
+		DA_STORE(&ctx->error, 1, RELAXED);
+	}
+}
+
+/* Follow the instructions from word i until control leaves the straight
+   line or reaches a word that was already reached. Return the number of
+   words reached. */
+static size_t
+da_trace_follow(da_trace_ctx_t *ctx, da_trace_deque_t *d, size_t i)
+{
+	size_t reached = 0;
+
+	for (; i < ctx->count; i++) {
+		uint64_t bit = (uint64_t)1 << (i & 63);
+		if (DA_FETCH_OR(&ctx->code[i >> 6], bit) & bit) break;
+		reached += 1;
+
+		da_instr_t instr;
+		da_instr_parse(&instr, ctx->data[i], ctx->big_endian);
+		da_addr_t addr = ctx->addr + i*sizeof(da_word_t);
+		int cond = (da_instr_get_cond(&instr) != DA_COND_AL);
+		da_uint_t rd = da_instr_rd(&instr);
+		da_uint_t op = (instr.data >> 21) & 0xf;
+
+		switch (instr.group) {
+		case DA_GROUP_BL:
+			da_trace_queue(ctx, d, da_instr_branch_target(
+					       da_instr_imm(&instr), addr));
+			/* Calls return */
+			if (!cond && !((instr.data >> 24) & 1)) return reached;
+			break;
+		case DA_GROUP_BLX_IMM:
+			/* The target is Thumb code */
+			break;
+		case DA_GROUP_BLX_REG:
+			if (!cond && !((instr.data >> 5) & 1)) return reached;
+			break;
+		case DA_GROUP_LS_MULTI:
+			if (!cond && da_instr_is_load(&instr) &&
+			    ((instr.data >> DA_REG_R15) & 1)) return reached;
+			break;
+		case DA_GROUP_DATA_IMM:
+		case DA_GROUP_DATA_IMM_SH:
+		case DA_GROUP_DATA_REG_SH:
+			if (rd == DA_REG_R15 && (op < DA_DATA_OP_TST ||
+						 op > DA_DATA_OP_CMN)) {
+				if (!cond) return reached;
+			}
+			break;
+		case DA_GROUP_LS_IMM:
+			/* Follow ldr pc, [pc, #off] through the literal */
+			if (rd == DA_REG_R15 && da_instr_is_load(&instr) &&
+			    da_instr_rn(&instr) == DA_REG_R15 &&
+			    ((instr.data >> 24) & 1) &&
+			    !((instr.data >> 22) & 1)) {
+				da_addr_t lit = addr + 8 + da_instr_imm(&instr);
+				size_t j = (lit - ctx->addr) / sizeof(da_word_t);
+				if (lit >= ctx->addr && !(lit & 3) &&
+				    j < ctx->count) {
+					da_instr_t target;
+					da_instr_parse(&target, ctx->data[j],
+						       ctx->big_endian);
+					da_trace_queue(ctx, d, target.data);
+				}
+			}
+			/* Fall through */
+		case DA_GROUP_L_SIGN_IMM:
+		case DA_GROUP_L_SIGN_REG:
+		case DA_GROUP_LS_HW_IMM:
+		case DA_GROUP_LS_HW_REG:
+		case DA_GROUP_LS_REG:
+			if (rd == DA_REG_R15 && da_instr_is_load(&instr) &&
+			    !cond) return reached;
+			break;
+		case DA_GROUP_UNDEF_1:
+		case DA_GROUP_UNDEF_2:
+		case DA_GROUP_UNDEF_3:
+		case DA_GROUP_UNDEF_4:
+		case DA_GROUP_UNDEF_5:
+			/* Probably data */
+			return reached;
+		default:
+			break;
+		}
+	}
+
+	return reached;
+}
+
+/* Run worker: follow words from the own deque, then steal from the
+   others, until no words are pending. */
+static void *
+da_trace_worker(void *arg)
+{
+	da_trace_worker_t *w = arg;
+	da_trace_ctx_t *ctx = w->ctx;
+	da_trace_deque_t *own = &ctx->deques[w->id];
+
+	for (;;) {
+		int64_t x = da_trace_take(own);
+
+		int k;
+		for (k = 1; x == DA_TRACE_EMPTY && k < ctx->nworkers; k++) {
+			int victim = (w->id + k) % ctx->nworkers;
+			x = da_trace_steal(&ctx->deques[victim]);
+		}
+
+		if (x != DA_TRACE_EMPTY) {
+			w->reached += da_trace_follow(ctx, own, x);
+			DA_FETCH_ADD(&ctx->pending, -1);
+		} else if (DA_LOAD(&ctx->pending, SEQ_CST) == 0) {
+			break;
+		} else {
+#ifdef DA_TRACE_THREADS
+			sched_yield();
+#endif
+		}
+	}
+
+	return NULL;
+}
+
+/* Find the code of count words at address addr by recursive traversal
+   from the nentries addresses in entries, or from the exception vectors
+   if entries is NULL. The traversal follows fall through, direct
+   branches and calls, and ldr pc from literals, and stops at other
+   unconditional writes to r15 and at undefined instructions. Blx
+   targets, which are Thumb code, are not followed. The frontier is
+   spread over the given number of threads with work-stealing deques.
+   Return -1 on error. */
+DA_API int
+da_trace_run(da_trace_t *trace, const da_word_t *data, size_t count,
+	     da_addr_t addr, int big_endian, const da_addr_t *entries,
+	     size_t nentries, int threads)
+{
+	memset(trace, 0, sizeof(da_trace_t));
+	if (count >= UINT32_MAX) return -1;
+
+#ifndef DA_TRACE_THREADS
+	threads = 1;
+#endif
+	if (threads < 1) threads = 1;
+
+	size_t words = (count + 63) / 64 + 1;
+	trace->code = calloc(words, sizeof(uint64_t));
+	if (trace->code == NULL) return -1;
+	trace->addr = addr;
+	trace->count = count;
+
+	da_trace_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.data = data;
+	ctx.count = count;
+	ctx.addr = addr;
+	ctx.big_endian = big_endian;
+	ctx.code = trace->code;
+	ctx.nworkers = threads;
+
+	da_trace_worker_t *workers = calloc(threads,
+					    sizeof(da_trace_worker_t));
+	ctx.deques = calloc(threads, sizeof(da_trace_deque_t));
+	if (workers == NULL || ctx.deques == NULL) {
+		free(workers);
+		free(ctx.deques);
+		da_trace_free(trace);
+		return -1;
+	}
+
+	int t;
+	for (t = 0; t < threads; t++) {
+		workers[t].ctx = &ctx;
+		workers[t].id = t;
+		ctx.deques[t].array = da_trace_array_new(DA_TRACE_DEQUE_SIZE,
+							 NULL);
+		if (ctx.deques[t].array == NULL) ctx.error = 1;
+	}
+
+	if (!ctx.error) {
+		size_t k;
+		if (entries == NULL) {
+			for (k = 0; k < DA_TRACE_VECTORS; k++) {
+				da_trace_queue(&ctx, &ctx.deques[0],
+					       addr + k*sizeof(da_word_t));
+			}
+		} else {
+			for (k = 0; k < nentries; k++) {
+				da_trace_queue(&ctx, &ctx.deques[0],
+					       entries[k]);
+			}
+		}
+
+#ifdef DA_TRACE_THREADS
+		pthread_t *tids = calloc(threads, sizeof(pthread_t));
+		int *started = calloc(threads, sizeof(int));
+		if (tids != NULL && started != NULL) {
+			for (t = 1; t < threads; t++) {
+				started[t] = (pthread_create(
+						      &tids[t], NULL,
+						      da_trace_worker,
+						      &workers[t]) == 0);
+			}
+		}
+		da_trace_worker(&workers[0]);
+		if (tids != NULL && started != NULL) {
+			for (t = 1; t < threads; t++) {
+				if (started[t]) pthread_join(tids[t], NULL);
+			}
+		}
+		free(tids);
+		free(started);
+#else
+		da_trace_worker(&workers[0]);
+#endif
+	}
+
+	for (t = 0; t < threads; t++) {
+		da_trace_array_t *a = ctx.deques[t].array;
+		while (a != NULL) {
+			da_trace_array_t *prev = a->prev;
+			free(a);
+			a = prev;
+		}
+		trace->reached += workers[t].reached;
+	}
+	free(workers);
+	free(ctx.deques);
+
+	if (ctx.error) {
+		da_trace_free(trace);
+		return -1;
+	}
+
+	return 0;
+}
+
+DA_API void
+da_trace_free(da_trace_t *trace)
+{
+	free(trace->code);
+	memset(trace, 0, sizeof(da_trace_t));
+}
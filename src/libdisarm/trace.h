@@ -0,0 +1,61 @@
+/*
+ * trace.h - Recursive traversal header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_TRACE_H
+#define _LIBDISARM_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+
+/* Number of exception vectors used as entry points by default */
+#define DA_TRACE_VECTORS  8
+
+DA_BEGIN_DECLS
+
+/* Words of an image, the first at address addr, that were reached by
+   recursive traversal from the entry points. Bit i of code is set if
+   word i was reached. */
+typedef struct {
+	da_addr_t addr;
+	size_t count;
+	size_t reached;
+	uint64_t *code;
+} da_trace_t;
+
+
+int da_trace_run(da_trace_t *trace, const da_word_t *data, size_t count,
+		 da_addr_t addr, int big_endian, const da_addr_t *entries,
+		 size_t nentries, int threads);
+void da_trace_free(da_trace_t *trace);
+
+/* Return true if word i was reached. */
+static inline int
+da_trace_is_code(const da_trace_t *trace, size_t i)
+{
+	return (trace->code[i >> 6] >> (i & 63)) & 1;
+}
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_TRACE_H */
@@ -0,0 +1,529 @@
+/*
+ * xref.c - Cross reference index
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include "args.h"
+#include "macros.h"
+#include "parser.h"
+#include "types.h"
+#include "xref.h"
+
+
+/* Number of words decoded at a time */
+#define DA_XREF_PARSE_SIZE  256
+
+/* Serialized index: magic, version and byte order mark, followed by the
+   sizes and the arena. Indexes are stored in host byte order. */
+#define DA_XREF_MAGIC    "DAXR"
+#define DA_XREF_VERSION  1
+#define DA_XREF_ORDER    0x01020304
+
+
+/* Reference from an instruction */
+typedef struct {
+	da_addr_t from;
+	da_addr_t to;
+	uint8_t kind;
+} da_xref_ref_t;
+
+/* References of a chunk of the image, found by one thread */
+typedef struct {
+	const da_word_t *data;
+	size_t count;
+	da_addr_t addr;
+	int big_endian;
+
+	da_xref_ref_t *refs;
+	size_t nrefs;
+	size_t size;
+	int error;
+} da_xref_part_t;
+
+
+/* Store reference of instruction at address addr in ref. Return 0 if the
+   instruction references no address. */
+static int
+da_xref_get_ref(da_xref_ref_t *ref, const da_instr_t *instr,
+		const da_instr_args_t *args, da_addr_t addr)
+{
+	ref->from = addr;
+	ref->kind = DA_XREF_DATA;
+
+	switch (instr->group) {
+	case DA_GROUP_BL:
+		ref->to = da_instr_branch_target(args->bl.off, addr);
+		ref->kind = (args->bl.link ? DA_XREF_CALL : DA_XREF_BRANCH);
+		return 1;
+	case DA_GROUP_BLX_IMM:
+		ref->to = da_instr_blx_target(args->blx_imm.off,
+					      args->blx_imm.h, addr);
+		ref->kind = DA_XREF_CALL;
+		return 1;
+	case DA_GROUP_DATA_IMM:
+		if (args->data_imm.rn != DA_REG_R15) return 0;
+		if (args->data_imm.op == DA_DATA_OP_ADD) {
+			ref->to = addr + 8 + args->data_imm.imm;
+			return 1;
+		} else if (args->data_imm.op == DA_DATA_OP_SUB) {
+			ref->to = addr + 8 - args->data_imm.imm;
+			return 1;
+		}
+		return 0;
+	case DA_GROUP_L_SIGN_IMM:
+		if (args->l_sign_imm.rn != DA_REG_R15) return 0;
+		ref->to = addr + 8 + args->l_sign_imm.off;
+		return 1;
+	case DA_GROUP_LS_HW_IMM:
+		if (args->ls_hw_imm.rn != DA_REG_R15) return 0;
+		ref->to = addr + 8 + args->ls_hw_imm.off;
+		return 1;
+	case DA_GROUP_LS_IMM:
+		if (args->ls_imm.rn != DA_REG_R15) return 0;
+		ref->to = addr + 8 + args->ls_imm.off;
+		return 1;
+	case DA_GROUP_LS_TWO_IMM:
+		if (args->ls_two_imm.rn != DA_REG_R15) return 0;
+		ref->to = addr + 8 + args->ls_two_imm.off;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int
+da_xref_cmp_to(const void *a, const void *b)
+{
+	const da_xref_ref_t *ra = a;
+	const da_xref_ref_t *rb = b;
+
+	if (ra->to != rb->to) return (ra->to < rb->to ? -1 : 1);
+	if (ra->from != rb->from) return (ra->from < rb->from ? -1 : 1);
+	return 0;
+}
+
+/* Sort n references from src by target into dst, using tmp of the same
+   size. The sort is stable, so references in address order stay in that
+   order for each target. Return -1 on error. */
+static int
+da_xref_sort_to(da_xref_ref_t *dst, const da_xref_ref_t *src,
+		da_xref_ref_t *tmp, size_t n)
+{
+	uint32_t *counts = malloc(2*65536*sizeof(uint32_t));
+	if (counts == NULL) return -1;
+
+	/* Radix sort in two passes of 16 bits */
+	uint32_t *low = counts;
+	uint32_t *high = counts + 65536;
+	memset(counts, 0, 2*65536*sizeof(uint32_t));
+
+	size_t i;
+	for (i = 0; i < n; i++) {
+		low[src[i].to & 0xffff] += 1;
+		high[src[i].to >> 16] += 1;
+	}
+
+	uint32_t low_sum = 0, high_sum = 0;
+	for (i = 0; i < 65536; i++) {
+		uint32_t c = low[i];
+		low[i] = low_sum;
+		low_sum += c;
+		c = high[i];
+		high[i] = high_sum;
+		high_sum += c;
+	}
+
+	for (i = 0; i < n; i++) tmp[low[src[i].to & 0xffff]++] = src[i];
+	for (i = 0; i < n; i++) dst[high[tmp[i].to >> 16]++] = tmp[i];
+
+	free(counts);
+	return 0;
+}
+
+/* Find the references of a part, in address order, and sort a copy of
+   them by target into the second half of refs. */
+static void *
+da_xref_scan(void *arg)
+{
+	da_xref_part_t *part = arg;
+	da_instr_t instrs[DA_XREF_PARSE_SIZE];
+	da_instr_args_t args[DA_XREF_PARSE_SIZE];
+	size_t done = 0;
+
+	while (done < part->count) {
+		size_t n = part->count - done;
+		if (n > DA_XREF_PARSE_SIZE) n = DA_XREF_PARSE_SIZE;
+
+		/* Make room for a reference per instruction */
+		if (part->size - part->nrefs < n) {
+			size_t size = (part->size > 0 ? part->size*2 : 1024);
+			void *p = realloc(part->refs,
+					  2*size*sizeof(da_xref_ref_t));
+			if (p == NULL) {
+				part->error = 1;
+				return NULL;
+			}
+			part->refs = p;
+			part->size = size;
+		}
+
+		da_instr_parse_block(instrs, part->data + done, n,
+				     part->big_endian);
+		da_instr_parse_args_block(args, instrs, n);
+
+		size_t i;
+		for (i = 0; i < n; i++) {
+			da_addr_t addr = part->addr +
+				(done + i)*sizeof(da_word_t);
+			part->nrefs += da_xref_get_ref(
+				&part->refs[part->nrefs], &instrs[i],
+				&args[i], addr);
+		}
+
+		done += n;
+	}
+
+	da_xref_ref_t *tmp = malloc((part->nrefs > 0 ? part->nrefs : 1)*
+				    sizeof(da_xref_ref_t));
+	if (tmp == NULL ||
+	    da_xref_sort_to(part->refs + part->size, part->refs, tmp,
+			    part->nrefs) < 0) {
+		part->error = 1;
+	}
+	free(tmp);
+
+	return NULL;
+}
+
+/* Return size of the arena of an index with the given sizes. */
+static size_t
+da_xref_arena_size(size_t count, size_t nfrom, size_t nto)
+{
+	return (nfrom + (nfrom + 1) + count + nto + (nto + 1) + count) *
+		sizeof(uint32_t) + 2*count;
+}
+
+/* Set pointers of xref into arena for the given sizes. */
+static void
+da_xref_layout(da_xref_t *xref, void *arena, size_t count, size_t nfrom,
+	       size_t nto)
+{
+	uint32_t *p = arena;
+
+	xref->arena = arena;
+	xref->count = count;
+	xref->from.nkeys = nfrom;
+	xref->to.nkeys = nto;
+
+	/* Words first, then bytes */
+	xref->from.keys = p;
+	p += nfrom;
+	xref->from.index = p;
+	p += nfrom + 1;
+	xref->from.addrs = p;
+	p += count;
+	xref->to.keys = p;
+	p += nto;
+	xref->to.index = p;
+	p += nto + 1;
+	xref->to.addrs = p;
+	p += count;
+
+	xref->from.kinds = (uint8_t *)p;
+	xref->to.kinds = xref->from.kinds + count;
+}
+
+/* Return 0 if the lists of table are inside the arena. */
+static int
+da_xref_check(const da_xref_table_t *table, size_t count)
+{
+	size_t k;
+	if (table->index[0] != 0) return -1;
+	for (k = 0; k < table->nkeys; k++) {
+		if (table->index[k] > table->index[k + 1]) return -1;
+	}
+	return (table->index[table->nkeys] == count ? 0 : -1);
+}
+
+/* Append reference to table, keyed by its target if to is set, and
+   return the number of keys so far. */
+static inline size_t
+da_xref_add(da_xref_table_t *table, size_t nkeys, size_t i,
+	    const da_xref_ref_t *ref, int to)
+{
+	da_addr_t key = (to ? ref->to : ref->from);
+
+	if (nkeys == 0 || table->keys[nkeys - 1] != key) {
+		table->keys[nkeys] = key;
+		table->index[nkeys] = i;
+		nkeys += 1;
+	}
+
+	table->addrs[i] = (to ? ref->from : ref->to);
+	table->kinds[i] = ref->kind;
+	return nkeys;
+}
+
+/* Build index of the references made by count instructions at address
+   addr, on the given number of threads. Each thread indexes a chunk of
+   the image and the sorted chunks are merged. Return -1 on error. */
+DA_API int
+da_xref_build(da_xref_t *xref, const da_word_t *data, size_t count,
+	      da_addr_t addr, int big_endian, int threads)
+{
+	memset(xref, 0, sizeof(da_xref_t));
+	if (threads < 1) threads = 1;
+	if ((size_t)threads > count / DA_XREF_PARSE_SIZE + 1) {
+		threads = count / DA_XREF_PARSE_SIZE + 1;
+	}
+
+	da_xref_part_t *parts = calloc(threads, sizeof(da_xref_part_t));
+	if (parts == NULL) return -1;
+
+	int t;
+	size_t chunk = count / threads;
+	for (t = 0; t < threads; t++) {
+		size_t start = t*chunk;
+		parts[t].data = data + start;
+		parts[t].count = (t == threads - 1 ? count - start : chunk);
+		parts[t].addr = addr + start*sizeof(da_word_t);
+		parts[t].big_endian = big_endian;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_t *tids = calloc(threads, sizeof(pthread_t));
+	int *started = calloc(threads, sizeof(int));
+	if (tids == NULL || started == NULL) {
+		free(tids);
+		free(started);
+		free(parts);
+		return -1;
+	}
+
+	for (t = 1; t < threads; t++) {
+		started[t] = (pthread_create(&tids[t], NULL, da_xref_scan,
+					     &parts[t]) == 0);
+	}
+	da_xref_scan(&parts[0]);
+	for (t = 1; t < threads; t++) {
+		if (started[t]) pthread_join(tids[t], NULL);
+		else da_xref_scan(&parts[t]);
+	}
+
+	free(tids);
+	free(started);
+#else
+	for (t = 0; t < threads; t++) da_xref_scan(&parts[t]);
+#endif
+
+	/* Merge the parts sorted by target and count the targets */
+	size_t total = 0;
+	int error = 0;
+	for (t = 0; t < threads; t++) {
+		total += parts[t].nrefs;
+		error |= parts[t].error;
+	}
+
+	da_xref_ref_t *by_to = NULL;
+	if (!error && total >= UINT32_MAX) error = 1;
+	if (!error) {
+		by_to = malloc((total > 0 ? total : 1)*sizeof(da_xref_ref_t));
+		if (by_to == NULL) error = 1;
+	}
+
+	size_t *pos = calloc(threads, sizeof(size_t));
+	if (pos == NULL) error = 1;
+
+	if (error) {
+		for (t = 0; t < threads; t++) free(parts[t].refs);
+		free(parts);
+		free(by_to);
+		free(pos);
+		return -1;
+	}
+
+	size_t nto = 0;
+	size_t i;
+	for (i = 0; i < total; i++) {
+		int best = -1;
+		for (t = 0; t < threads; t++) {
+			if (pos[t] == parts[t].nrefs) continue;
+			const da_xref_ref_t *r =
+				&parts[t].refs[parts[t].size + pos[t]];
+			if (best < 0 || da_xref_cmp_to(r, &by_to[i]) < 0) {
+				best = t;
+				by_to[i] = *r;
+			}
+		}
+		pos[best] += 1;
+		if (i == 0 || by_to[i].to != by_to[i - 1].to) nto += 1;
+	}
+	free(pos);
+
+	/* Every instruction makes at most one reference */
+	size_t nfrom = total;
+	size_t size = da_xref_arena_size(total, nfrom, nto);
+	void *arena = malloc(size > 0 ? size : 1);
+	if (arena == NULL) {
+		for (t = 0; t < threads; t++) free(parts[t].refs);
+		free(parts);
+		free(by_to);
+		memset(xref, 0, sizeof(da_xref_t));
+		return -1;
+	}
+	da_xref_layout(xref, arena, total, nfrom, nto);
+
+	size_t k = 0;
+	i = 0;
+	for (t = 0; t < threads; t++) {
+		size_t j;
+		for (j = 0; j < parts[t].nrefs; j++, i++) {
+			k = da_xref_add(&xref->from, k, i, &parts[t].refs[j],
+					0);
+		}
+		free(parts[t].refs);
+	}
+	xref->from.index[k] = total;
+	free(parts);
+
+	k = 0;
+	for (i = 0; i < total; i++) {
+		k = da_xref_add(&xref->to, k, i, &by_to[i], 1);
+	}
+	xref->to.index[k] = total;
+	free(by_to);
+
+	return 0;
+}
+
+DA_API void
+da_xref_free(da_xref_t *xref)
+{
+	free(xref->arena);
+	memset(xref, 0, sizeof(da_xref_t));
+}
+
+/* Return number of references with key addr in table and store pointers
+   to their addresses and kinds. */
+static size_t
+da_xref_lookup(const da_xref_table_t *table, da_addr_t addr,
+	       const da_addr_t **addrs, const uint8_t **kinds)
+{
+	size_t lo = 0;
+	size_t hi = table->nkeys;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (table->keys[mid] < addr) lo = mid + 1;
+		else hi = mid;
+	}
+
+	if (lo == table->nkeys || table->keys[lo] != addr) return 0;
+
+	size_t first = table->index[lo];
+	if (addrs != NULL) *addrs = &table->addrs[first];
+	if (kinds != NULL) *kinds = &table->kinds[first];
+	return table->index[lo + 1] - first;
+}
+
+/* Return number of references to address addr, and store pointers to the
+   addresses of the referencing instructions, in order, and the kinds of
+   the references in from and kinds, which may be NULL. */
+DA_API size_t
+da_xref_refs_to(const da_xref_t *xref, da_addr_t addr,
+		const da_addr_t **from, const uint8_t **kinds)
+{
+	return da_xref_lookup(&xref->to, addr, from, kinds);
+}
+
+/* Return number of references made by the instruction at address addr,
+   as da_xref_refs_to does. */
+DA_API size_t
+da_xref_refs_from(const da_xref_t *xref, da_addr_t addr,
+		  const da_addr_t **to, const uint8_t **kinds)
+{
+	return da_xref_lookup(&xref->from, addr, to, kinds);
+}
+
+/* Write index to f. Return -1 on error. */
+DA_API int
+da_xref_save(const da_xref_t *xref, FILE *f)
+{
+	uint32_t header[5] = {
+		DA_XREF_VERSION, DA_XREF_ORDER, xref->count,
+		xref->from.nkeys, xref->to.nkeys
+	};
+	size_t size = da_xref_arena_size(xref->count, xref->from.nkeys,
+					 xref->to.nkeys);
+
+	if (fwrite(DA_XREF_MAGIC, 1, 4, f) != 4 ||
+	    fwrite(header, sizeof(header), 1, f) != 1 ||
+	    (size > 0 && fwrite(xref->arena, size, 1, f) != 1)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Read index written by da_xref_save from f. Return -1 on error or if
+   the index was written by another version or on a host of another byte
+   order. */
+DA_API int
+da_xref_load(da_xref_t *xref, FILE *f)
+{
+	char magic[4];
+	uint32_t header[5];
+
+	memset(xref, 0, sizeof(da_xref_t));
+	if (fread(magic, 1, 4, f) != 4 ||
+	    memcmp(magic, DA_XREF_MAGIC, 4) ||
+	    fread(header, sizeof(header), 1, f) != 1 ||
+	    header[0] != DA_XREF_VERSION || header[1] != DA_XREF_ORDER) {
+		return -1;
+	}
+
+	size_t size = da_xref_arena_size(header[2], header[3], header[4]);
+	void *arena = malloc(size > 0 ? size : 1);
+	if (arena == NULL) return -1;
+
+	if (size > 0 && fread(arena, size, 1, f) != 1) {
+		free(arena);
+		memset(xref, 0, sizeof(da_xref_t));
+		return -1;
+	}
+	da_xref_layout(xref, arena, header[2], header[3], header[4]);
+
+	if (da_xref_check(&xref->from, xref->count) < 0 ||
+	    da_xref_check(&xref->to, xref->count) < 0) {
+		da_xref_free(xref);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * xref.h - Cross reference index header
+ *
+ * Copyright (C) 2007  Jon Lund Steffensen <jonlst@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _LIBDISARM_XREF_H
+#define _LIBDISARM_XREF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libdisarm/macros.h>
+#include <libdisarm/types.h>
+
+DA_BEGIN_DECLS
+
+/* Kinds of references */
+typedef enum {
+	DA_XREF_BRANCH = 0,	/* Direct branch */
+	DA_XREF_CALL,		/* Direct branch with link, bl or blx */
+	DA_XREF_DATA,		/* PC relative address of data */
+	DA_XREF_MAX
+} da_xref_kind_t;
+
+/* References keyed by the address at one end. The references of key
+   keys[k] are entries index[k] to index[k + 1] - 1 of addrs, which holds
+   the address at the other end, and kinds. Keys are sorted, and the
+   addresses of each key are sorted. */
+typedef struct {
+	size_t nkeys;
+	da_addr_t *keys;
+	uint32_t *index;
+	da_addr_t *addrs;
+	uint8_t *kinds;
+} da_xref_table_t;
+
+/* Index of the references made by the instructions of an image, in both
+   directions. All arrays are allocated in one arena. */
+typedef struct {
+	size_t count;
+	da_xref_table_t from;
+	da_xref_table_t to;
+
+	void *arena;
+} da_xref_t;
+
+
+int da_xref_build(da_xref_t *xref, const da_word_t *data, size_t count,
+		  da_addr_t addr, int big_endian, int threads);
+void da_xref_free(da_xref_t *xref);
+
+size_t da_xref_refs_to(const da_xref_t *xref, da_addr_t addr,
+		       const da_addr_t **from, const uint8_t **kinds);
+size_t da_xref_refs_from(const da_xref_t *xref, da_addr_t addr,
+			 const da_addr_t **to, const uint8_t **kinds);
+
+int da_xref_save(const da_xref_t *xref, FILE *f);
+int da_xref_load(da_xref_t *xref, FILE *f);
+
+DA_END_DECLS
+
+#endif /* ! _LIBDISARM_XREF_H */